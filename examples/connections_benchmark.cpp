@@ -0,0 +1,148 @@
+#include <server_lib/event_loop.h>
+#include <server_lib/network/network_server.h>
+#include <server_lib/network/network_client.h>
+#include <server_lib/network/raw_builder.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Connect and drop a lot of clients to measure bookkeeping
+// of server connections. Clients are connected by batches
+// (to keep number of open sockets limited) and every batch is dropped
+// at once like it is for mass disconnection after failover.
+//
+// Usage: connections_benchmark [clients_total=100000] [batch=1000] [port=20230]
+//
+// Batch is 1000 clients by default. Every client takes two descriptors
+// (client and server sockets) in this process, so descriptor limit
+// (ulimit -n) should be above 2 * batch. Server registry holds
+// no more than 'batch' connections at once. Pass batch = clients_total
+// (with enough descriptors) to measure registry with all clients connected
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+long long to_ms(clock_type::duration elapsed)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    using namespace server_lib;
+    using namespace server_lib::network;
+
+    size_t clients_total = 100000;
+    size_t batch = 1000;
+    uint16_t port = 20230;
+    if (argc > 1)
+        clients_total = static_cast<size_t>(std::atoll(argv[1]));
+    if (argc > 2)
+        batch = static_cast<size_t>(std::atoll(argv[2]));
+    if (argc > 3)
+        port = static_cast<uint16_t>(std::atoi(argv[3]));
+
+    const std::string host = "localhost";
+
+    event_loop server_th;
+    event_loop client_th;
+
+    server_th.start();
+    client_th.start();
+
+    raw_builder protocol;
+
+    network_server server;
+
+    // server_th only
+    std::map<app_connection_i*, std::shared_ptr<app_connection_i>> connections;
+
+    size_t connected = 0;
+    size_t disconnected = 0;
+    std::mutex counters_guard;
+    std::condition_variable counters_cond;
+
+    auto wait_counter = [&](const size_t& counter, size_t value) {
+        std::unique_lock<std::mutex> lck(counters_guard);
+        counters_cond.wait(lck, [&]() { return counter >= value; });
+    };
+
+    auto server_disconnect_callback = [&](app_connection_i& conn) {
+        connections.erase(&conn);
+
+        std::lock_guard<std::mutex> lck(counters_guard);
+        ++disconnected;
+        counters_cond.notify_one();
+    };
+
+    auto server_new_connection_callback = [&](const std::shared_ptr<app_connection_i>& connection) {
+        connection->set_on_disconnect_handler(server_disconnect_callback);
+        connections.emplace(connection.get(), connection);
+
+        std::lock_guard<std::mutex> lck(counters_guard);
+        ++connected;
+        counters_cond.notify_one();
+    };
+
+    if (!server.start(host, port, &protocol, &server_th, server_new_connection_callback))
+    {
+        std::cerr << "Can't start server at " << host << ":" << port << std::endl;
+        return 1;
+    }
+
+    clock_type::duration connect_time {};
+    clock_type::duration drop_time {};
+
+    for (size_t done = 0; done < clients_total;)
+    {
+        auto nb_clients = std::min(batch, clients_total - done);
+
+        std::vector<std::unique_ptr<network_client>> clients;
+        clients.reserve(nb_clients);
+
+        auto start = clock_type::now();
+        for (size_t ci = 0; ci < nb_clients; ++ci)
+        {
+            clients.emplace_back(new network_client);
+            if (!clients.back()->connect(host, port, &protocol, &client_th))
+            {
+                std::cerr << "Can't connect client #" << done + ci << std::endl;
+                return 1;
+            }
+        }
+        wait_counter(connected, done + nb_clients);
+        connect_time += clock_type::now() - start;
+
+        start = clock_type::now();
+        client_th.wait_async(true, [&clients]() {
+            for (auto&& client : clients)
+                client->disconnect();
+            clients.clear();
+            return true;
+        });
+        wait_counter(disconnected, done + nb_clients);
+        drop_time += clock_type::now() - start;
+
+        done += nb_clients;
+    }
+
+    std::cout << clients_total << " clients (by " << batch << "): "
+              << "connected " << to_ms(connect_time) << " ms, "
+              << "dropped " << to_ms(drop_time) << " ms" << std::endl;
+
+    server.stop();
+
+    client_th.stop();
+    server_th.stop();
+
+    return 0;
+}
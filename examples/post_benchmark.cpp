@@ -0,0 +1,222 @@
+#include <server_lib/event_loop.h>
+
+#include <boost/asio.hpp>
+#include <boost/utility/in_place_factory.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <thread>
+
+// Compare heap allocations per 'post' for plain asio posting
+// (as event_loop did before handler_memory) and for event_loop::post
+
+namespace {
+std::atomic_uint64_t g_allocations(0);
+
+void* counted_alloc(std::size_t sz)
+{
+    ++g_allocations;
+    if (void* p = std::malloc(sz ? sz : 1))
+        return p;
+    throw std::bad_alloc {};
+}
+} // namespace
+
+// All replaceable forms are replaced to keep allocation
+// and deallocation functions matched
+void* operator new(std::size_t sz)
+{
+    return counted_alloc(sz);
+}
+
+void* operator new[](std::size_t sz)
+{
+    return counted_alloc(sz);
+}
+
+void* operator new(std::size_t sz, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return counted_alloc(sz);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t sz, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return counted_alloc(sz);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
+struct payload
+{
+    uint64_t data[4] = {};
+};
+
+// Handlers are posted by bursts to keep queue size limited
+// like it is in steady traffic
+constexpr size_t BURST = 100;
+
+template <typename Post, typename Wait>
+void measure(const char* name, const size_t posts, Post&& post, Wait&& wait)
+{
+    std::atomic_size_t done(0);
+    payload p;
+
+    // warm up free lists
+    for (size_t ci = 0; ci < BURST; ++ci)
+        post([&done, p]() { ++done; });
+    wait();
+
+    done = 0;
+
+    auto allocations_before = g_allocations.load();
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t ci = 0; ci < posts; ++ci)
+    {
+        post([&done, p]() { ++done; });
+        if (ci % BURST == BURST - 1)
+            wait();
+    }
+    wait();
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    auto allocations = g_allocations.load() - allocations_before;
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+
+    std::cout << name << ": " << posts << " posts, "
+              << static_cast<double>(allocations) / posts << " allocations per post, "
+              << ms << " ms" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    using namespace server_lib;
+
+    size_t posts = 1000000;
+    if (argc > 1)
+        posts = static_cast<size_t>(std::atoll(argv[1]));
+
+    {
+        boost::asio::io_service service;
+        boost::asio::io_service::strand strand { service };
+        boost::optional<boost::asio::io_service::work> work { boost::in_place(std::ref(service)) };
+        std::thread th([&service]() { service.run(); });
+
+        auto post = [&service, &strand](auto&& handler) {
+            service.post(strand.wrap(std::move(handler)));
+        };
+        auto wait = [&service, &strand]() {
+            std::atomic_bool ready(false);
+            service.post(strand.wrap([&ready]() { ready = true; }));
+            while (!ready)
+                std::this_thread::yield();
+        };
+
+        measure("asio post (strand.wrap)", posts, post, wait);
+
+        work = boost::none;
+        th.join();
+    }
+
+    {
+        event_loop loop;
+        loop.start();
+
+        auto post = [&loop](auto&& handler) {
+            loop.post(std::move(handler));
+        };
+        auto wait = [&loop]() {
+            loop.wait_async(true, []() { return true; });
+        };
+
+        measure("event_loop::post", posts, post, wait);
+
+        std::cout << "handler memory: " << loop.memory().allocated() << " blocks allocated, "
+                  << loop.memory().reused() << " blocks reused" << std::endl;
+    }
+
+    {
+        event_loop loop(true, event_loop::queue_type::lockfree);
+        loop.start();
+
+        auto post = [&loop](auto&& handler) {
+            loop.post(std::move(handler));
+        };
+        auto wait = [&loop]() {
+            loop.wait_async(true, []() { return true; });
+        };
+
+        measure("event_loop::post (lockfree)", posts, post, wait);
+    }
+
+    {
+        event_loop loop;
+        loop.set_polling(16 * 1024);
+        loop.start();
+
+        auto post = [&loop](auto&& handler) {
+            loop.post(std::move(handler));
+        };
+        auto wait = [&loop]() {
+            loop.wait_async(true, []() { return true; });
+        };
+
+        measure("event_loop::post (polling)", posts, post, wait);
+
+        auto m = loop.get_metrics();
+        std::cout << "polling: " << m.idle_spins << " idle spins, "
+                  << m.wakeups << " wakeups" << std::endl;
+    }
+
+    return 0;
+}
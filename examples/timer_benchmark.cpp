@@ -0,0 +1,76 @@
+#include <server_lib/event_loop.h>
+
+#include <boost/asio.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// Arm and cancel a lot of idle timers (like per-connection timeouts)
+// with asio timers (as event_loop::start_timer did before timer wheel)
+// and with event_loop timer wheel
+
+namespace {
+
+template <typename Func>
+void measure(const char* name, const size_t timers, Func&& func)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    func();
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+
+    std::cout << name << ": " << timers << " timers armed and canceled, " << ms << " ms" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    using namespace server_lib;
+
+    size_t timers = 100000;
+    if (argc > 1)
+        timers = static_cast<size_t>(std::atoll(argv[1]));
+
+    event_loop loop;
+    loop.start();
+
+    measure("asio deadline_timer", timers, [&]() {
+        loop.wait_async(true, [&]() {
+            boost::asio::io_service& service = loop;
+            std::vector<std::shared_ptr<boost::asio::deadline_timer>> armed;
+            armed.reserve(timers);
+            for (size_t ci = 0; ci < timers; ++ci)
+            {
+                auto timer = std::make_shared<boost::asio::deadline_timer>(service);
+                timer->expires_from_now(boost::posix_time::milliseconds(1000 + ci % 60000));
+                timer->async_wait([timer](const boost::system::error_code&) {});
+                armed.emplace_back(std::move(timer));
+            }
+            for (auto&& timer : armed)
+                timer->cancel();
+            return true;
+        });
+    });
+
+    measure("event_loop timer wheel", timers, [&]() {
+        loop.wait_async(true, [&]() {
+            std::vector<event_loop::timer_handle> armed;
+            armed.reserve(timers);
+            for (size_t ci = 0; ci < timers; ++ci)
+            {
+                armed.emplace_back(loop.start_timer(std::chrono::milliseconds(1000 + ci % 60000), []() {}));
+            }
+            for (auto&& handle : armed)
+                loop.cancel_timer(handle);
+            return true;
+        });
+    });
+
+    return 0;
+}
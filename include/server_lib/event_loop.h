@@ -1,14 +1,39 @@
 #pragma once
 
+#include <utility> // it is missed by boost/asio/awaitable.hpp of some Boost versions
 #include <boost/asio.hpp>
 #include <boost/optional.hpp>
+#include <boost/version.hpp>
+#if defined(SERVER_LIB_COROUTINES)
+#include <boost/asio/spawn.hpp>
+#endif
+#if defined(BOOST_ASIO_HAS_CO_AWAIT)
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#endif
+#include <chrono>
 #include <functional>
+#include <iterator>
+#include <memory>
 #include <thread>
 #include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <type_traits>
+#include <vector>
 
 #include <server_lib/types.h>
 #include <server_lib/timers.h>
+#include <server_lib/loop_future.h>
+#include <server_lib/loop_owned.h>
 #include <server_lib/asserts.h>
+#include <server_lib/handler_allocator.h>
+#include <server_lib/mpsc_queue.h>
+#include <server_lib/timer_wheel.h>
+#include <server_lib/latency_histogram.h>
+#include <server_lib/thread_options.h>
 
 #include "wait_asynch_request.h"
 
@@ -16,6 +41,17 @@ namespace server_lib {
 
 DECLARE_PTR(event_loop);
 
+#if BOOST_VERSION >= 107000
+// Invoke completion handler of asynchronous operation
+// by its associated executor (coroutine strand for example)
+template <typename Handler, typename... Args>
+void complete_async(Handler&& handler, Args&&... args)
+{
+    auto executor = boost::asio::get_associated_executor(handler);
+    boost::asio::dispatch(executor, std::bind(std::forward<Handler>(handler), std::forward<Args>(args)...));
+}
+#endif
+
 /* To hold transport events (etc. from epool)
  * wrapped by boost::asio and a little bit more
  * that supposed by message queue
@@ -25,27 +61,280 @@ class event_loop
 public:
     using timer = server_lib::timer<event_loop>;
     using periodical_timer = server_lib::periodical_timer<event_loop>;
-
-    event_loop(bool in_separate_thread = true);
+    using hr_timer = server_lib::hr_timer<event_loop>;
+    template <typename T>
+    using future = server_lib::loop_future<T, event_loop>;
+    template <typename T>
+    using promise = server_lib::loop_promise<T, event_loop>;
+    template <typename T>
+    using owned = server_lib::loop_owned<T, event_loop>;
+    using timer_handle = timer_wheel::handle;
+
+    enum class queue_type
+    {
+        // io_service queue through strand
+        asio,
+        // intrusive lock-free MPSC queue with spin-then-park waiting.
+        // It is for loops that mostly run posted handlers
+        lockfree
+    };
+
+    event_loop(bool in_separate_thread = true, queue_type queue = queue_type::asio);
     virtual ~event_loop();
 
     static bool is_main_thread();
 
+    enum class priority
+    {
+        // control traffic. It runs before queued normal handlers
+        high,
+        // default lane
+        normal,
+        // background work. It gives way to normal handlers
+        low
+    };
+
+    // high lane handlers in a row between normal ones
+    static constexpr size_t high_lane_weight = 16;
+    // normal handlers that low lane handler could wait for
+    static constexpr size_t low_lane_weight = 8;
+
+    /* What to do with new handler when normal and low lanes
+     * have reached high watermark
+    */
+    enum class overflow_policy
+    {
+        // wait in posting thread until low watermark
+        // (except posting from loop thread)
+        block,
+        // 'post' returns false and handler is not queued
+        reject,
+        // oldest queued normal handler is dropped to make room for new one
+        // ('post' returns false if there is no handler to drop)
+        drop_oldest,
+        // accept and only notify by watermark callback
+        signal
+    };
+
+    // overloaded = true when high watermark is reached (called in posting thread),
+    // overloaded = false when queue is back to low watermark (called in loop thread)
+    using watermark_callback_type = std::function<void(bool overloaded)>;
+
+    // high_watermark = 0 disables limits. High lane is not limited.
+    // It should be set before posting
+    void set_watermarks(const uint64_t high_watermark,
+                        const uint64_t low_watermark,
+                        const overflow_policy policy = overflow_policy::signal,
+                        watermark_callback_type callback = nullptr);
+
+    bool is_overloaded() const
+    {
+        return _overloaded.load();
+    }
+
+    // Callback is invoked once when loop is not overloaded
+    // (immediately if it is not overloaded now).
+    // Waiters are released without invocation by 'stop'
+    void on_low_watermark(std::function<void(void)> callback);
+
+    // handlers rejected by 'reject' policy or by drain
+    uint64_t rejected() const
+    {
+        return _rejected.load();
+    }
+
+    // handlers dropped by 'drop_oldest' policy
+    uint64_t dropped() const
+    {
+        return _dropped.load();
+    }
+
+    struct metrics
+    {
+        uint64_t posts = 0;
+        uint64_t completions = 0;
+        // caught by loop
+        uint64_t exceptions = 0;
+        // handlers detected by watchdog
+        uint64_t stalls = 0;
+        // empty polls and waits in blocking mode
+        // (counted by lock-free queue and polling mode only)
+        uint64_t idle_spins = 0;
+        uint64_t wakeups = 0;
+        uint64_t queue_size = 0;
+        // from post to handler start
+        latency_histogram::snapshot queue_wait;
+        // handler execution
+        latency_histogram::snapshot run_time;
+    };
+
+    // Histograms are recorded only if they are enabled
+    // (it costs clock reading in post and around handler).
+    // Counters are recorded always
+    void enable_metrics(const bool enable = true)
+    {
+        _metrics_enabled.store(enable);
+    }
+
+    metrics get_metrics() const;
+    void reset_metrics();
+
+    // Enable metrics and log them periodically by this loop
+    void start_metrics_dump(const std::chrono::milliseconds& period);
+    void stop_metrics_dump();
+
+    // false if handler is rejected by overflow policy or by drain
     template <typename Handler>
-    void post(Handler&& handler)
+    bool post(Handler&& handler)
     {
         SRV_ASSERT(_pservice);
-        auto handler_ = [pqueue_size = &_queue_size, handler = std::move(handler)]() mutable {
-            handler();
-            std::atomic_fetch_sub<uint64_t>(pqueue_size, 1);
+        if (_draining.load(std::memory_order_relaxed) && !admit_draining())
+            return false;
+        if (_high_watermark.load(std::memory_order_relaxed) && !admit())
+            return false;
+
+        enqueue(std::forward<Handler>(handler), true);
+        return true;
+    }
+
+    /* Like 'post' but queued handler is never dropped
+     * by 'drop_oldest' policy (others are dropped instead)
+     * and it is not skipped by drain timeout.
+     * It is for handlers that can't be lost, like stream data
+    */
+    template <typename Handler>
+    bool post_undroppable(Handler&& handler)
+    {
+        SRV_ASSERT(_pservice);
+        if (_draining.load(std::memory_order_relaxed) && !admit_draining())
+            return false;
+        if (_high_watermark.load(std::memory_order_relaxed) && !admit())
+            return false;
+
+        enqueue(std::forward<Handler>(handler), false);
+        return true;
+    }
+
+    /* Like 'post_undroppable' but handler that is not admitted
+     * by overflow policy is posted again at low watermark
+     * (waiter is released by 'stop'). It is rejected by drain only.
+     * It is for notifications that can't be lost, like connection events
+    */
+    template <typename Handler>
+    bool post_or_defer(Handler handler)
+    {
+        if (post_undroppable(handler))
+            return true;
+        if (is_draining())
+            return false;
+
+        on_low_watermark([this, handler]() {
+            post_or_defer(handler);
+        });
+        return true;
+    }
+
+    /* Post to priority lane.
+     * High lane handlers are executed between normal handlers
+     * (no more than 'high_lane_weight' in a row).
+     * Low lane handler is executed when normal lane is empty
+     * or after 'low_lane_weight' normal handlers
+    */
+    template <typename Handler>
+    bool post(const priority lane, Handler&& handler)
+    {
+        if (lane == priority::normal)
+            return post(std::forward<Handler>(handler));
+
+        SRV_ASSERT(_pservice);
+        if (_draining.load(std::memory_order_relaxed) && !admit_draining())
+            return false;
+        if (lane == priority::low && _high_watermark.load(std::memory_order_relaxed) && !admit())
+            return false;
+
+        enqueue(lane, std::forward<Handler>(handler), true);
+        return true;
+    }
+
+    // Post range of handlers with single queue synchronization.
+    // Handlers run one by one in range order
+    template <typename Range>
+    bool post_bulk(Range&& handlers)
+    {
+        SRV_ASSERT(_pservice);
+
+        using handler_type = typename std::decay<decltype(*std::begin(handlers))>::type;
+        using element_type = typename std::conditional<std::is_lvalue_reference<Range>::value,
+                                                       const handler_type&, handler_type&&>::type;
+
+        std::vector<handler_type> batch;
+        batch.reserve(static_cast<size_t>(std::distance(std::begin(handlers), std::end(handlers))));
+        for (auto&& handler : handlers)
+        {
+            batch.emplace_back(static_cast<element_type>(handler));
+        }
+
+        if (batch.empty())
+            return true;
+
+        auto batch_size = static_cast<uint64_t>(batch.size());
+
+        if (_draining.load(std::memory_order_relaxed) && !admit_draining())
+            return false;
+        // every handler of batch is counted by watermarks
+        if (_high_watermark.load(std::memory_order_relaxed) && !admit(batch_size))
+            return false;
+
+        if (_bounded.load(std::memory_order_relaxed))
+        {
+            // every handler of batch could be dropped by 'drop_oldest' policy
+            std::vector<small_handler> entries;
+            entries.reserve(batch.size());
+            for (auto&& handler : batch)
+                entries.emplace_back(wrap_normal(std::move(handler), true));
+
+            std::atomic_fetch_add<uint64_t>(&lane_queue_size(priority::normal), batch_size);
+            _posts.fetch_add(batch_size, std::memory_order_relaxed);
+            push_bounded(std::move(entries));
+            return true;
+        }
+
+        auto handler_ = [this, enqueued = enqueue_time(), batch = std::move(batch)]() mutable {
+            {
+                // queue is released for whole batch even if some handler throws
+                queue_size_guard guard { *this, priority::normal, static_cast<uint64_t>(batch.size()) };
+
+                // handlers are independent, so the one that throws
+                // doesn't cancel the rest of batch
+                for (auto&& handler : batch)
+                {
+                    auto started = begin_handler(enqueued);
+                    if (run_caught(handler))
+                        end_handler(started);
+                    else
+                        watch_end();
+                }
+            }
+            run_high_lane();
         };
-        std::atomic_fetch_add<uint64_t>(&_queue_size, 1);
-        _pservice->post(_strand.wrap(std::move(handler_)));
+        std::atomic_fetch_add<uint64_t>(&lane_queue_size(priority::normal), batch_size);
+        _posts.fetch_add(batch_size, std::memory_order_relaxed);
+        post_impl(std::move(handler_));
+        return true;
+    }
+
+    // all lanes
+    uint64_t queue_size() const
+    {
+        uint64_t result = 0;
+        for (auto&& lane_size : _queue_size)
+            result += lane_size.load();
+        return result;
     }
 
-    auto queue_size() const
+    uint64_t queue_size(const priority lane) const
     {
-        return _queue_size.load();
+        return _queue_size[static_cast<size_t>(lane)].load();
     }
 
     operator boost::asio::io_service&()
@@ -59,7 +348,33 @@ public:
         return _pservice;
     }
 
+    const handler_memory& memory() const
+    {
+        return *_handler_memory;
+    }
+
     void change_thread_name(const std::string&);
+    std::string thread_name() const;
+
+    // CPU affinity, NUMA node and scheduling policy of loop thread.
+    // It is applied at start or immediately if loop is running
+    void set_thread_options(const thread_options&);
+
+    /* Busy polling mode for latency critical loops.
+     * Loop polls its queue in tight loop and blocks only after
+     * 'spin_budget' empty polls in a row. It saves wake up cost
+     * for the price of CPU. Zero budget turns polling off.
+     * It is applied at start
+    */
+    void set_polling(const size_t spin_budget)
+    {
+        _polling_budget.store(spin_budget);
+    }
+
+    size_t polling() const
+    {
+        return _polling_budget.load();
+    }
 
     virtual void start(std::function<void(void)> start_notify = nullptr, std::function<void(void)> stop_notify = nullptr);
     virtual void stop();
@@ -68,6 +383,21 @@ public:
         return _is_running;
     }
 
+    /* Graceful stop. New posts are rejected (except posts from this loop),
+     * already queued handlers are executed and loop is stopped.
+     * Handlers that are still queued after timeout are dropped.
+     *
+     * It blocks and returns the count of dropped handlers.
+     * Loop without own thread (main loop) could be drained from itself,
+     * then it returns 0 immediately and dropped handlers are only logged
+    */
+    uint64_t drain(const std::chrono::milliseconds& timeout);
+
+    bool is_draining() const
+    {
+        return _draining.load();
+    }
+
     bool is_main() const
     {
         return _is_main;
@@ -78,13 +408,25 @@ public:
         return _id.load() == std::this_thread::get_id();
     }
 
+    // current thread runs this loop (it is false before start)
+    bool is_this_running_loop() const
+    {
+        return _is_running.load() && is_this_loop();
+    }
+
+    // Blocking call of 'asynch_func' in this loop.
+    // If it is called from this loop 'asynch_func' is executed inline
     template <typename Result, typename AsynchFunc>
     Result wait_async(const Result initial_result, AsynchFunc&& asynch_func)
     {
+        if (is_this_running_loop())
+            return asynch_func();
+
+        // waiting is not limited by overflow policy
         auto call = [this](auto asynch_func) {
-            this->post(asynch_func);
+            this->enqueue(std::move(asynch_func));
         };
-        return wait_async_call(initial_result, call, asynch_func);
+        return wait_async_call(initial_result, call, std::forward<AsynchFunc>(asynch_func));
     }
 
     template <typename Result, typename AsynchFunc, typename DurationType>
@@ -94,14 +436,58 @@ public:
 
         SRV_ASSERT(ms.count() > 0, "1 millisecond is minimum waiting accuracy");
 
+        if (is_this_running_loop())
+            return asynch_func();
+
+        // waiting is not limited by overflow policy
         auto call = [this](auto asynch_func) {
-            this->post(asynch_func);
+            this->enqueue(std::move(asynch_func));
         };
-        return wait_async_call(initial_result, call, asynch_func, ms.count());
+        return wait_async_call(initial_result, call, std::forward<AsynchFunc>(asynch_func), ms.count());
+    }
+
+    // wait_async with microseconds timeout accuracy
+    template <typename Result, typename AsynchFunc, typename DurationType>
+    Result wait_async_hr(const Result initial_result, AsynchFunc&& asynch_func, DurationType&& duration)
+    {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration);
+
+        SRV_ASSERT(us.count() > 0, "1 microsecond is minimum waiting accuracy");
+
+        if (is_this_running_loop())
+            return asynch_func();
+
+        // waiting is not limited by overflow policy
+        auto call = [this](auto asynch_func) {
+            this->enqueue(std::move(asynch_func));
+        };
+        return wait_async_call(initial_result, call, std::forward<AsynchFunc>(asynch_func), us);
+    }
+
+    // Non-blocking call of 'func' in this loop. Result is delivered by future.
+    // If it is called from this loop 'func' is executed inline
+    template <typename Func>
+    future<typename std::result_of<typename std::decay<Func>::type()>::type> async_call(Func&& func)
+    {
+        using result_type = typename std::result_of<typename std::decay<Func>::type()>::type;
+
+        promise<result_type> p(*this);
+        auto f = p.get_future();
+        if (is_this_running_loop())
+        {
+            p.set_by(func);
+        }
+        else
+        {
+            this->enqueue([p, func = typename std::decay<Func>::type(std::forward<Func>(func))]() mutable {
+                p.set_by(func);
+            });
+        }
+        return f;
     }
 
     template <typename DurationType, typename Handler>
-    void start_timer(DurationType&& duration, Handler&& callback)
+    timer_handle start_timer(DurationType&& duration, Handler&& callback)
     {
         SRV_ASSERT(_pservice);
 
@@ -109,34 +495,406 @@ public:
 
         SRV_ASSERT(ms.count() > 0, "1 millisecond is minimum timer accuracy");
 
-        auto timer = std::make_shared<boost::asio::deadline_timer>(*_pservice);
+        return add_timer(ms, small_handler { std::forward<Handler>(callback) });
+    }
+
+    // High resolution timer (microseconds) by own steady_timer.
+    // It is more expensive than timer wheel and it is for short delays
+    template <typename DurationType, typename Handler>
+    void start_hr_timer(DurationType&& duration, Handler&& callback)
+    {
+        SRV_ASSERT(_pservice);
+
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration);
 
-        timer->expires_from_now(boost::posix_time::milliseconds(ms.count()));
-        timer->async_wait(_strand.wrap([timer /*save timer object*/, callback](const boost::system::error_code& ec) {
+        SRV_ASSERT(us.count() > 0, "1 microsecond is minimum timer accuracy");
+
+        auto timer = std::allocate_shared<boost::asio::steady_timer>(handler_memory_allocator<boost::asio::steady_timer>(*_handler_memory), *_pservice);
+
+        timer->expires_from_now(us);
+        timer->async_wait(_strand.wrap(make_alloc_handler(*_handler_memory, [timer /*save timer object*/, callback = std::forward<Handler>(callback)](const boost::system::error_code& ec) mutable {
             if (!ec)
             {
                 callback();
             }
-        }));
+        })));
+    }
+
+#if BOOST_VERSION >= 107000
+    /* Sleep for asio completion token: callback, boost::asio::yield_context
+     * (coroutine from 'spawn') or boost::asio::use_awaitable (coroutine from 'co_spawn').
+     * Coroutine is suspended without blocking loop thread.
+     * Timer wheel is used thus accuracy is 1 millisecond
+    */
+    template <typename DurationType, typename CompletionToken>
+    auto async_sleep(DurationType&& duration, CompletionToken&& token)
+    {
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(duration);
+        if (ms < duration)
+            ++ms;
+        ms = std::max(ms, std::chrono::milliseconds(1));
+
+        return boost::asio::async_initiate<CompletionToken, void()>(
+            [this, ms](auto handler) {
+                this->start_timer(ms, [handler = std::move(handler)]() mutable {
+                    complete_async(std::move(handler));
+                });
+            },
+            token);
+    }
+#endif
+
+#if defined(SERVER_LIB_COROUTINES)
+    // Run stackful coroutine in this loop.
+    // Function signature is void(boost::asio::yield_context)
+    template <typename Function>
+    void spawn(Function&& function)
+    {
+        boost::asio::spawn(_pservice->get_executor(), std::forward<Function>(function));
+    }
+#endif
+
+#if defined(BOOST_ASIO_HAS_CO_AWAIT)
+    // Run C++20 coroutine (boost::asio::awaitable<void>) in this loop
+    template <typename Awaitable>
+    void co_spawn(Awaitable&& awaitable)
+    {
+        boost::asio::co_spawn(_pservice->get_executor(), std::forward<Awaitable>(awaitable), boost::asio::detached);
+    }
+#endif
+
+    // false if timer has already fired (or it is going to fire in current loop tick)
+    bool cancel_timer(const timer_handle& handle)
+    {
+        return _timers.cancel(handle);
+    }
+
+    size_t timers_count() const
+    {
+        return _timers.size();
     }
 
 protected:
+    template <typename Handler>
+    void post_impl(Handler&& handler)
+    {
+        if (_queue_type == queue_type::lockfree)
+        {
+            _lockfree_queue.push(make_task_node(*_handler_memory, std::forward<Handler>(handler)));
+
+            // pairs with fence in 'run_lockfree' before parking
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (_parked.load(std::memory_order_relaxed))
+                wakeup();
+        }
+        else
+        {
+            _pservice->post(_strand.wrap(make_alloc_handler(*_handler_memory, std::forward<Handler>(handler))));
+        }
+    }
+
+    timer_handle add_timer(const std::chrono::milliseconds& delay, small_handler&& callback);
+    void arm_timers();
+    void on_timers();
+
+    using metrics_clock = std::chrono::steady_clock;
+
+    // zero time point if metrics are disabled
+    metrics_clock::time_point enqueue_time() const
+    {
+        return _metrics_enabled.load(std::memory_order_relaxed) ? metrics_clock::now() : metrics_clock::time_point {};
+    }
+
+    metrics_clock::time_point begin_handler(const metrics_clock::time_point& enqueued)
+    {
+        bool watched = _watched.load(std::memory_order_relaxed);
+        if (enqueued == metrics_clock::time_point {} && !watched)
+            return {};
+
+        auto now = metrics_clock::now();
+        if (enqueued != metrics_clock::time_point {})
+            _queue_wait.record(now - enqueued);
+        if (watched)
+            watch_begin(now);
+        return now;
+    }
+
+    void end_handler(const metrics_clock::time_point& started)
+    {
+        _completions.fetch_add(1, std::memory_order_relaxed);
+        if (started == metrics_clock::time_point {})
+            return;
+
+        if (_metrics_enabled.load(std::memory_order_relaxed))
+            _run_time.record(metrics_clock::now() - started);
+        watch_end();
+    }
+
+    // for watchdog
+    void watch_begin(const metrics_clock::time_point& now)
+    {
+        _handler_seq.fetch_add(1, std::memory_order_relaxed);
+        _handler_started.store(now.time_since_epoch().count(), std::memory_order_release);
+    }
+
+    void watch_end()
+    {
+        _handler_started.store(0, std::memory_order_release);
+    }
+
+    void dump_metrics();
+
+    // Run handler with the same exception accounting as 'run'.
+    // It is for handlers that are run together (batch, timers of one tick)
+    template <typename Handler>
+    bool run_caught(Handler& handler)
+    {
+        try
+        {
+            handler();
+            return true;
+        }
+        catch (const std::exception& e)
+        {
+            on_handler_exception(e.what());
+        }
+        catch (...)
+        {
+            on_handler_exception(nullptr);
+        }
+        return false;
+    }
+
+    void on_handler_exception(const char* what);
+
+    // normal lane handler with queue accounting and metrics
+    template <typename Handler>
+    auto wrap_normal(Handler&& handler, const bool droppable)
+    {
+        return [this, droppable, enqueued = enqueue_time(), handler = std::forward<Handler>(handler)]() mutable {
+            {
+                queue_size_guard guard { *this, priority::normal, 1 };
+
+                if (!(droppable && drain_expired()))
+                {
+                    auto started = begin_handler(enqueued);
+                    handler();
+                    end_handler(started);
+                }
+            }
+            run_high_lane();
+        };
+    }
+
+    // Normal lane without overflow policy.
+    // Undroppable handler is neither dropped by 'drop_oldest' policy
+    // nor skipped by drain (internal handlers that somebody waits for)
+    template <typename Handler>
+    void enqueue(Handler&& handler, const bool droppable = false)
+    {
+        auto handler_ = wrap_normal(std::forward<Handler>(handler), droppable);
+        std::atomic_fetch_add<uint64_t>(&lane_queue_size(priority::normal), 1);
+        _posts.fetch_add(1, std::memory_order_relaxed);
+        if (_bounded.load(std::memory_order_relaxed))
+            push_bounded(small_handler { std::move(handler_) }, droppable);
+        else
+            post_impl(std::move(handler_));
+    }
+
+    // High or low lane without overflow policy.
+    // Undroppable handler is not skipped by drain
+    template <typename Handler>
+    void enqueue(const priority lane, Handler&& handler, const bool droppable = false)
+    {
+        SRV_ASSERT(lane != priority::normal);
+
+        std::atomic_fetch_add<uint64_t>(&lane_queue_size(lane), 1);
+        _posts.fetch_add(1, std::memory_order_relaxed);
+        lane_queue(lane).push(make_task_node(*_handler_memory, [this, droppable, enqueued = enqueue_time(), handler = std::forward<Handler>(handler)]() mutable {
+            if (droppable && drain_expired())
+                return;
+
+            auto started = begin_handler(enqueued);
+            handler();
+            end_handler(started);
+        }));
+        post_impl([this, lane]() {
+            run_lane(lane);
+        });
+    }
+
+    std::atomic_uint64_t& lane_queue_size(const priority lane)
+    {
+        return _queue_size[static_cast<size_t>(lane)];
+    }
+
+    // Queue is released and low watermark is checked even if handler throws.
+    // Otherwise producers that wait for low watermark could be stuck
+    struct queue_size_guard
+    {
+        event_loop& loop;
+        priority lane;
+        uint64_t size;
+
+        ~queue_size_guard()
+        {
+            loop.release_queue(lane, size);
+        }
+    };
+
+    mpsc_queue& lane_queue(const priority lane)
+    {
+        return lane == priority::high ? _high_lane : _low_lane;
+    }
+
+    void release_queue(const priority lane, const uint64_t size)
+    {
+        std::atomic_fetch_sub<uint64_t>(&lane_queue_size(lane), size);
+        if (lane == priority::normal)
+            _normal_executed += size;
+        if (lane != priority::high && _overloaded.load(std::memory_order_relaxed))
+            check_low_watermark_nothrow();
+    }
+
+    // high lane handlers waiting after normal one
+    void run_high_lane()
+    {
+        if (_queue_size[static_cast<size_t>(priority::high)].load(std::memory_order_relaxed))
+            run_lane(priority::high);
+    }
+
+    // handlers that are left after drain timeout are skipped
+    bool drain_expired()
+    {
+        if (!_draining.load(std::memory_order_relaxed))
+            return false;
+        if (std::chrono::steady_clock::now().time_since_epoch().count() < _drain_deadline.load(std::memory_order_relaxed))
+            return false;
+        ++_drain_skipped;
+        return true;
+    }
+
+    // normal and low lanes
+    uint64_t limited_queue_size() const
+    {
+        return queue_size(priority::normal) + queue_size(priority::low);
+    }
+
+    bool admit(const uint64_t count = 1);
+    bool admit_draining();
+    // drop oldest droppable handlers to fit 'count' new ones
+    bool make_room(const uint64_t count);
+    void push_bounded(small_handler&& handler, const bool droppable);
+    void push_bounded(std::vector<small_handler>&& handlers);
+    void run_bounded();
+    void check_low_watermark();
+    // for queue guard (watermark callback errors are logged)
+    void check_low_watermark_nothrow();
+
+    void run_lane(const priority lane);
+    bool run_lane_one(const priority lane);
+
+    void drain_step();
+    // result of drain is set once by drain step or by 'stop'
+    void complete_drain(const uint64_t dropped);
+
     void run();
+    void run_lockfree();
+    void run_polling();
+    void wakeup();
+    void arm_wakeup();
 
 protected:
     const bool _run_in_separate_thread = false;
+    const queue_type _queue_type = queue_type::asio;
     std::atomic_bool _is_running;
     std::atomic_bool _is_main;
     long _tid = 0;
     std::shared_ptr<boost::asio::io_service> _pservice;
     boost::asio::io_service::strand _strand;
+    handler_memory* _handler_memory = nullptr;
     boost::optional<boost::asio::io_service::work> _loop_maintainer;
     std::unique_ptr<std::thread> _thread;
+    // guards thread name and native thread
+    mutable std::mutex _thread_guard;
     std::string _thread_name = "io_service loop";
-    std::atomic_uint64_t _queue_size;
+    // pthread_t of thread that runs loop (0 if loop doesn't run)
+    unsigned long _native_thread = 0;
+    thread_options _thread_options;
+    std::atomic_uint64_t _queue_size[3];
     std::atomic<std::thread::id> _id;
 
+    timer_wheel _timers;
+    boost::asio::steady_timer _timers_driver;
+    std::vector<small_handler> _expired_timers;
+
+    std::atomic_bool _metrics_enabled;
+    std::atomic_uint64_t _posts;
+    std::atomic_uint64_t _completions;
+    std::atomic_uint64_t _exceptions;
+    latency_histogram _queue_wait;
+    latency_histogram _run_time;
+    std::unique_ptr<periodical_timer> _metrics_dump_timer;
+
+    // current handler start (steady clock ticks, 0 if loop is idle)
+    std::atomic<metrics_clock::rep> _handler_started;
+    std::atomic_uint64_t _handler_seq;
+    std::atomic_bool _watched;
+    std::atomic_uint64_t _stalls;
+    std::atomic_uint64_t _idle_spins;
+    std::atomic_uint64_t _wakeups;
+
+    std::atomic_uint64_t _high_watermark;
+    std::atomic_uint64_t _low_watermark;
+    overflow_policy _overflow_policy = overflow_policy::signal;
+    watermark_callback_type _watermark_callback;
+    std::atomic_bool _overloaded;
+    std::atomic_uint64_t _rejected;
+    std::atomic_uint64_t _dropped;
+    std::atomic_bool _draining;
+    std::atomic_int64_t _drain_deadline;
+    std::atomic_uint64_t _drain_skipped;
+    std::mutex _drain_guard;
+    boost::optional<promise<uint64_t>> _drain_result;
+    std::mutex _watermark_guard;
+    std::condition_variable _watermark_cond;
+    std::vector<std::function<void(void)>> _low_watermark_waiters;
+
+    // Normal lane for 'drop_oldest' policy. Handlers are kept here
+    // (not in io_service) to be dropped when new ones come.
+    // Only one 'run_bounded' call is queued in io_service at a time
+    struct bounded_handler
+    {
+        small_handler handler;
+        bool droppable = true;
+    };
+    std::atomic_bool _bounded;
+    std::mutex _bounded_guard;
+    std::deque<bounded_handler> _bounded_queue;
+    bool _bounded_scheduled = false;
+
+    mpsc_queue _high_lane;
+    mpsc_queue _low_lane;
+    // normal handlers executed (loop thread only)
+    uint64_t _normal_executed = 0;
+    uint64_t _normal_executed_at_low = 0;
+
+    mpsc_queue _lockfree_queue;
+    std::atomic_bool _parked;
+    size_t _spin_limit = 0;
+    std::atomic_size_t _polling_budget;
+#if defined(BOOST_ASIO_HAS_POSIX_STREAM_DESCRIPTOR)
+    std::unique_ptr<boost::asio::posix::stream_descriptor> _wakeup_descriptor;
+    uint64_t _wakeup_value = 0;
+#endif
+
 private:
+    friend class event_loop_watchdog;
+    template <typename, typename>
+    friend struct detail::future_state;
+    template <typename, typename>
+    friend class loop_owned;
+
     bool is_main_loop();
     void apply_thread_name();
 };
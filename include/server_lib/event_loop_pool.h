@@ -0,0 +1,130 @@
+#pragma once
+
+#include <server_lib/event_loop.h>
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace server_lib {
+
+/* Set of event loops (each one owns io_service and thread)
+ * to spread handlers between several cores.
+ *
+ * 'post' handlers are not ordered and could be stolen
+ * by any idle loop of the pool.
+ * 'post_to' handlers with the same key are ordered
+ * and always run in the same loop
+*/
+class event_loop_pool
+{
+public:
+    enum class balance_policy
+    {
+        round_robin,
+        least_loaded
+    };
+
+    // nb_loops = 0 means as many loops as hardware threads
+    event_loop_pool(const size_t nb_loops = 0, const balance_policy policy = balance_policy::round_robin);
+    ~event_loop_pool();
+
+    event_loop_pool(const event_loop_pool&) = delete;
+    event_loop_pool& operator=(const event_loop_pool&) = delete;
+
+    size_t size() const
+    {
+        return _workers.size();
+    }
+
+    event_loop& loop(const size_t index);
+
+    // next loop by balance policy
+    event_loop& next_loop();
+
+    template <typename Key>
+    event_loop& loop_for(const Key& key)
+    {
+        return loop(std::hash<Key> {}(key) % size());
+    }
+
+    // false if handler is rejected by all loops (by overflow policy or by drain)
+    template <typename Handler>
+    bool post(Handler&& handler)
+    {
+        SRV_ASSERT(!_workers.empty());
+
+        small_handler task { std::forward<Handler>(handler) };
+        auto index = next_index();
+        for (size_t ci = 0; ci < _workers.size(); ++ci)
+        {
+            // if loop has rejected task that has already been stolen
+            // it is executed by the thief
+            if (post_task(index, task) || !task)
+                return true;
+            index = (index + 1) % _workers.size();
+        }
+        return false;
+    }
+
+    template <typename Key, typename Handler>
+    bool post_to(const Key& key, Handler&& handler)
+    {
+        return loop_for(key).post(std::forward<Handler>(handler));
+    }
+
+    uint64_t queue_size() const;
+
+    // how many handlers were executed not in loop they were posted to
+    uint64_t stolen() const
+    {
+        return _stolen.load();
+    }
+
+    // Loops are named as '<name><index>'
+    void change_thread_name(const std::string&);
+
+    // start_notify (stop_notify) is invoked once when all loops are started (stopped)
+    void start(std::function<void(void)> start_notify = nullptr, std::function<void(void)> stop_notify = nullptr);
+    void stop();
+    bool is_running() const;
+
+private:
+    struct worker
+    {
+        event_loop loop;
+        std::mutex tasks_guard;
+        std::deque<small_handler> tasks;
+        std::atomic_uint64_t pending;
+        // loop has scheduled steal attempt
+        std::atomic_bool stealing;
+
+        worker()
+            : pending(0)
+            , stealing(false)
+        {
+        }
+    };
+
+    size_t next_index();
+    // false if loop has rejected task, then task is taken back
+    // (or it is left empty if it has already been stolen)
+    bool post_task(const size_t index, small_handler& task);
+    void run_one(const size_t index);
+    void wake_thief(const size_t victim_index);
+    // 'stealing' flag should be set
+    bool schedule_steal(const size_t index);
+    void run_steal(const size_t index);
+    bool pop_own(worker&, small_handler&);
+    bool steal(const size_t thief_index, small_handler&);
+
+    const balance_policy _policy;
+    std::vector<std::unique_ptr<worker>> _workers;
+    std::atomic_size_t _next;
+    std::atomic_uint64_t _stolen;
+};
+
+} // namespace server_lib
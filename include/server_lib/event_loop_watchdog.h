@@ -0,0 +1,99 @@
+#pragma once
+
+#include <server_lib/event_loop.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace server_lib {
+
+/* Thread that detects loops stuck in single handler
+ * (or in timer callbacks) longer than threshold.
+ *
+ * Every stall is logged once with loop name and counted
+ * in loop metrics. If stack capture is enabled (Linux only)
+ * stuck thread is interrupted by signal to save its backtrace
+ * by emergency_helper
+*/
+class event_loop_watchdog
+{
+public:
+    using stall_callback_type = std::function<void(const std::string& loop_name,
+                                                   const std::chrono::milliseconds& stalled,
+                                                   const std::string& stack)>;
+
+    event_loop_watchdog(const std::chrono::milliseconds& threshold = std::chrono::seconds(1),
+                        const bool capture_stack = false);
+    ~event_loop_watchdog();
+
+    event_loop_watchdog(const event_loop_watchdog&) = delete;
+    event_loop_watchdog& operator=(const event_loop_watchdog&) = delete;
+
+    // Loop should stay alive until 'unwatch' or watchdog destruction
+    void watch(event_loop&);
+    void unwatch(event_loop&);
+
+    // It is called in watchdog thread
+    void set_stall_callback(stall_callback_type);
+
+    // Directory for temporary stack dumps (system temporary one by default)
+    void set_dump_directory(const std::string&);
+
+    void start();
+    void stop();
+    bool is_running() const;
+
+    // for all loops
+    uint64_t stalls() const;
+
+private:
+    // it is shared with handler that is posted to loop
+    struct watched_loop
+    {
+        event_loop* loop = nullptr;
+        uint64_t reported_seq = 0;
+        // pthread_t of loop thread that accepts signal (0 until it is known).
+        // It differs from loop thread after loop restart
+        std::atomic_ulong native_thread { 0 };
+        // it is reset by 'unwatch' with '_capture_guard' locked
+        std::atomic_bool active { true };
+    };
+    using watched_loop_ptr = std::shared_ptr<watched_loop>;
+
+    struct stall
+    {
+        watched_loop_ptr w;
+        std::string loop_name;
+        long loop_tid = 0;
+        std::chrono::milliseconds stalled;
+    };
+
+    void run();
+    // loop thread unblocks signal for stack capture
+    void accept_signal(const watched_loop_ptr&);
+    bool check(watched_loop&, const event_loop::metrics_clock::time_point& now, stall&);
+    void report(const stall&);
+    std::string capture_stack(const stall&);
+
+    const std::chrono::milliseconds _threshold;
+    const bool _capture_stack = false;
+    std::string _dump_directory;
+    stall_callback_type _stall_callback;
+
+    mutable std::mutex _guard;
+    // stack capture of loop thread. 'unwatch' waits for it
+    std::mutex _capture_guard;
+    std::condition_variable _stop_condition;
+    std::list<watched_loop_ptr> _loops;
+    std::thread _thread;
+    bool _stop = false;
+    std::atomic_uint64_t _stalls;
+};
+
+} // namespace server_lib
@@ -0,0 +1,355 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <boost/lockfree/stack.hpp>
+#include <boost/version.hpp>
+
+#include <server_lib/asserts.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace server_lib {
+
+/* Recycling memory for asio handlers (per io_service).
+ * Blocks are grouped by size classes and reused via lock-free lists
+ * because handlers are allocated in posting thread
+ * and deallocated in loop thread.
+ *
+ * It is registered like io_service service to be alive
+ * until all pending handlers of io_service are destroyed
+*/
+class handler_memory : public boost::asio::io_service::service
+{
+public:
+    static boost::asio::io_service::id id;
+
+    static constexpr size_t min_block_size = 64;
+    static constexpr size_t size_classes = 4; // 64, 128, 256, 512
+    static constexpr size_t max_block_size = min_block_size << (size_classes - 1);
+    static constexpr size_t max_free_blocks = 1024; // per size class
+
+    explicit handler_memory(boost::asio::io_service& service)
+        : boost::asio::io_service::service(service)
+        , _allocated(0)
+        , _reused(0)
+    {
+    }
+
+    ~handler_memory() override
+    {
+        void* p = nullptr;
+        for (auto&& free_blocks : _free_blocks)
+        {
+            while (free_blocks.pop(p))
+                ::operator delete(p);
+        }
+    }
+
+    void* allocate(const size_t size)
+    {
+        auto index = size_class(size);
+        if (index < size_classes)
+        {
+            void* p = nullptr;
+            if (_free_blocks[index].pop(p))
+            {
+                ++_reused;
+                return p;
+            }
+            ++_allocated;
+            return ::operator new(min_block_size << index);
+        }
+        ++_allocated;
+        return ::operator new(size);
+    }
+
+    void deallocate(void* p, const size_t size)
+    {
+        auto index = size_class(size);
+        if (index < size_classes && _free_blocks[index].bounded_push(p))
+            return;
+        ::operator delete(p);
+    }
+
+    // blocks obtained from heap
+    uint64_t allocated() const
+    {
+        return _allocated.load(std::memory_order_relaxed);
+    }
+
+    // blocks obtained from free lists
+    uint64_t reused() const
+    {
+        return _reused.load(std::memory_order_relaxed);
+    }
+
+private:
+#if BOOST_VERSION >= 106600
+    void shutdown() override
+    {
+    }
+#else
+    void shutdown_service() override
+    {
+    }
+#endif
+
+    static size_t size_class(const size_t size)
+    {
+        size_t index = 0;
+        size_t block_size = min_block_size;
+        while (block_size < size && index < size_classes)
+        {
+            block_size <<= 1;
+            ++index;
+        }
+        return index;
+    }
+
+    using free_blocks_type = boost::lockfree::stack<void*, boost::lockfree::capacity<max_free_blocks>>;
+
+    std::array<free_blocks_type, size_classes> _free_blocks;
+    std::atomic_uint64_t _allocated;
+    std::atomic_uint64_t _reused;
+};
+
+/* Standard allocator over handler_memory
+*/
+template <typename T>
+class handler_memory_allocator
+{
+public:
+    using value_type = T;
+
+    explicit handler_memory_allocator(handler_memory& memory)
+        : _memory(memory)
+    {
+    }
+
+    template <typename U>
+    handler_memory_allocator(const handler_memory_allocator<U>& other) noexcept
+        : _memory(other._memory)
+    {
+    }
+
+    T* allocate(const size_t n)
+    {
+        return static_cast<T*>(_memory.allocate(sizeof(T) * n));
+    }
+
+    void deallocate(T* p, const size_t n)
+    {
+        _memory.deallocate(p, sizeof(T) * n);
+    }
+
+    template <typename U>
+    bool operator==(const handler_memory_allocator<U>& other) const noexcept
+    {
+        return &_memory == &other._memory;
+    }
+
+    template <typename U>
+    bool operator!=(const handler_memory_allocator<U>& other) const noexcept
+    {
+        return &_memory != &other._memory;
+    }
+
+private:
+    template <typename>
+    friend class handler_memory_allocator;
+
+    handler_memory& _memory;
+};
+
+/* Handler wrapper to use handler_memory by asio
+ * for all internal allocations of this handler
+*/
+template <typename Handler>
+class alloc_handler
+{
+public:
+    using allocator_type = handler_memory_allocator<void>;
+
+    alloc_handler(handler_memory& memory, Handler&& handler)
+        : _memory(memory)
+        , _handler(std::move(handler))
+    {
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return allocator_type { _memory };
+    }
+
+    template <typename... Args>
+    void operator()(Args&&... args)
+    {
+        _handler(std::forward<Args>(args)...);
+    }
+
+    friend void* asio_handler_allocate(std::size_t size, alloc_handler<Handler>* this_handler)
+    {
+        return this_handler->_memory.allocate(size);
+    }
+
+    friend void asio_handler_deallocate(void* pointer, std::size_t size, alloc_handler<Handler>* this_handler)
+    {
+        this_handler->_memory.deallocate(pointer, size);
+    }
+
+private:
+    handler_memory& _memory;
+    Handler _handler;
+};
+
+template <typename Handler>
+alloc_handler<typename std::decay<Handler>::type> make_alloc_handler(handler_memory& memory, Handler&& handler)
+{
+    return { memory, std::forward<Handler>(handler) };
+}
+
+/* Move-only 'void()' callable (std::function replacement)
+ * that keeps small handlers inside own buffer without heap allocation
+*/
+template <size_t BufferSize>
+class basic_small_handler
+{
+    template <typename Handler>
+    using is_inplace = std::integral_constant<bool,
+                                              sizeof(Handler) <= BufferSize
+                                                  && alignof(Handler) <= alignof(std::max_align_t)
+                                                  && std::is_nothrow_move_constructible<Handler>::value>;
+
+public:
+    basic_small_handler() = default;
+
+    basic_small_handler(std::nullptr_t)
+    {
+    }
+
+    template <typename Handler,
+              typename = typename std::enable_if<!std::is_same<typename std::decay<Handler>::type, basic_small_handler>::value>::type>
+    basic_small_handler(Handler&& handler)
+    {
+        using handler_type = typename std::decay<Handler>::type;
+
+        assign<handler_type>(std::forward<Handler>(handler), is_inplace<handler_type> {});
+    }
+
+    basic_small_handler(basic_small_handler&& other) noexcept
+    {
+        move_from(other);
+    }
+
+    basic_small_handler& operator=(basic_small_handler&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            move_from(other);
+        }
+        return *this;
+    }
+
+    basic_small_handler(const basic_small_handler&) = delete;
+    basic_small_handler& operator=(const basic_small_handler&) = delete;
+
+    ~basic_small_handler()
+    {
+        reset();
+    }
+
+    void operator()()
+    {
+        SRV_ASSERT(_vtable, "Empty handler");
+        _vtable->call(_buffer);
+    }
+
+    explicit operator bool() const
+    {
+        return _vtable != nullptr;
+    }
+
+    void reset()
+    {
+        if (_vtable)
+        {
+            _vtable->destroy(_buffer);
+            _vtable = nullptr;
+        }
+    }
+
+private:
+    struct vtable_type
+    {
+        void (*call)(void*);
+        void (*move)(void* from, void* to);
+        void (*destroy)(void*);
+    };
+
+    template <typename Handler>
+    static const vtable_type* inplace_vtable()
+    {
+        static const vtable_type vtable = {
+            [](void* p) { (*static_cast<Handler*>(p))(); },
+            [](void* from, void* to) {
+                new (to) Handler(std::move(*static_cast<Handler*>(from)));
+                static_cast<Handler*>(from)->~Handler();
+            },
+            [](void* p) { static_cast<Handler*>(p)->~Handler(); }
+        };
+        return &vtable;
+    }
+
+    template <typename Handler>
+    static const vtable_type* heap_vtable()
+    {
+        static const vtable_type vtable = {
+            [](void* p) { (**static_cast<Handler**>(p))(); },
+            [](void* from, void* to) {
+                *static_cast<Handler**>(to) = *static_cast<Handler**>(from);
+            },
+            [](void* p) { delete *static_cast<Handler**>(p); }
+        };
+        return &vtable;
+    }
+
+    template <typename Handler, typename Arg>
+    void assign(Arg&& handler, std::true_type /*in place*/)
+    {
+        new (_buffer) Handler(std::forward<Arg>(handler));
+        _vtable = inplace_vtable<Handler>();
+    }
+
+    template <typename Handler, typename Arg>
+    void assign(Arg&& handler, std::false_type /*in heap*/)
+    {
+        *reinterpret_cast<Handler**>(_buffer) = new Handler(std::forward<Arg>(handler));
+        _vtable = heap_vtable<Handler>();
+    }
+
+    void move_from(basic_small_handler& other) noexcept
+    {
+        if (other._vtable)
+        {
+            other._vtable->move(other._buffer, _buffer);
+            _vtable = other._vtable;
+            other._vtable = nullptr;
+        }
+    }
+
+    static_assert(BufferSize >= sizeof(void*), "Buffer should be able to store pointer");
+
+    alignas(std::max_align_t) unsigned char _buffer[BufferSize];
+    const vtable_type* _vtable = nullptr;
+};
+
+using small_handler = basic_small_handler<64>;
+
+} // namespace server_lib
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace server_lib {
+
+/* Log-linear (HDR-like) histogram for durations in nanoseconds.
+ * Every power of two range is split to 16 linear buckets,
+ * so relative error of percentile is less than 6.25%.
+ *
+ * Single writer is supposed (loop thread), readers could be any threads
+*/
+class latency_histogram
+{
+public:
+    using duration = std::chrono::nanoseconds;
+
+    struct snapshot
+    {
+        uint64_t count = 0;
+        duration mean { 0 };
+        duration p50 { 0 };
+        duration p90 { 0 };
+        duration p99 { 0 };
+        duration p999 { 0 };
+        duration max { 0 };
+    };
+
+    latency_histogram();
+
+    latency_histogram(const latency_histogram&) = delete;
+    latency_histogram& operator=(const latency_histogram&) = delete;
+
+    void record(const duration&);
+
+    // q in [0, 1]. Result is upper bound of bucket
+    duration percentile(const double q) const;
+
+    snapshot get_snapshot() const;
+
+    uint64_t count() const
+    {
+        return _count.load(std::memory_order_relaxed);
+    }
+
+    void reset();
+
+private:
+    static constexpr size_t sub_bucket_bits = 4;
+    static constexpr size_t sub_buckets = size_t(1) << sub_bucket_bits;
+    static constexpr size_t buckets = (64 - sub_bucket_bits + 1) * sub_buckets;
+
+    static size_t bucket_index(const uint64_t value);
+    static uint64_t bucket_upper_bound(const size_t index);
+
+    uint64_t percentile(const double q, const std::array<uint64_t, buckets>& counts, const uint64_t total) const;
+
+    std::array<std::atomic_uint64_t, buckets> _buckets;
+    std::atomic_uint64_t _count;
+    std::atomic_uint64_t _sum;
+    std::atomic_uint64_t _max;
+};
+
+} // namespace server_lib
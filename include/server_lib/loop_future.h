@@ -0,0 +1,398 @@
+#pragma once
+
+#include <server_lib/asserts.h>
+#include <server_lib/handler_allocator.h>
+#include <server_lib/wait_asynch_request.h>
+
+#include <boost/optional.hpp>
+
+#include <atomic>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace server_lib {
+
+template <typename T, typename EventLoop>
+class loop_future;
+
+template <typename T, typename EventLoop>
+class loop_promise;
+
+namespace detail {
+    template <typename T>
+    struct future_value
+    {
+        template <typename Func, typename... Args>
+        void set_by(Func& func, Args&&... args)
+        {
+            value = func(std::forward<Args>(args)...);
+        }
+
+        template <typename U>
+        void set(U&& value_)
+        {
+            value = std::forward<U>(value_);
+        }
+
+        T take()
+        {
+            return std::move(*value);
+        }
+
+        boost::optional<T> value;
+    };
+
+    template <>
+    struct future_value<void>
+    {
+        template <typename Func, typename... Args>
+        void set_by(Func& func, Args&&... args)
+        {
+            func(std::forward<Args>(args)...);
+        }
+
+        void take()
+        {
+        }
+    };
+
+    template <typename T, typename EventLoop>
+    struct future_state
+    {
+        explicit future_state(EventLoop& producer_)
+            : producer(producer_)
+        {
+        }
+
+        // Continuation runs inline if result is set in continuation loop
+        static void run_in(EventLoop& loop, small_handler&& handler)
+        {
+            if (loop.is_this_running_loop())
+            {
+                handler();
+            }
+            else
+            {
+                // asio requires copyable handlers
+                auto shared_handler = std::allocate_shared<small_handler>(handler_memory_allocator<small_handler>(*loop._handler_memory), std::move(handler));
+                loop.enqueue([shared_handler]() {
+                    (*shared_handler)();
+                });
+            }
+        }
+
+        static void complete(const std::shared_ptr<future_state>& state, future_value<T>&& value, std::exception_ptr error)
+        {
+            small_handler continuation;
+            EventLoop* continuation_loop = nullptr;
+            wait_sync::ref waiter;
+            {
+                std::lock_guard<std::mutex> lck(state->guard);
+
+                SRV_ASSERT(!state->ready, "Result is already set");
+
+                state->value = std::move(value);
+                state->error = error;
+                state->ready = true;
+                continuation = std::move(state->continuation);
+                continuation_loop = state->continuation_loop;
+                waiter = std::move(state->waiter);
+            }
+
+            if (waiter)
+            {
+                std::lock_guard<std::mutex> lck(waiter->guard);
+                waiter->done = true;
+                waiter->done_cond.notify_one();
+            }
+
+            if (continuation)
+                run_in(*continuation_loop, std::move(continuation));
+        }
+
+        // Result is not going to be set (the last promise is destroyed
+        // with dropped handler or with stopped loop queue).
+        // Waiter gets 'broken_promise' error
+        static void abandon(const std::shared_ptr<future_state>& state)
+        {
+            // continuation is not run but destroyed out of lock.
+            // It breaks the next promise of chain
+            small_handler continuation;
+            wait_sync::ref waiter;
+            {
+                std::lock_guard<std::mutex> lck(state->guard);
+
+                if (state->ready)
+                    return;
+
+                state->error = std::make_exception_ptr(std::future_error(std::future_errc::broken_promise));
+                state->ready = true;
+                continuation = std::move(state->continuation);
+                waiter = std::move(state->waiter);
+            }
+
+            if (waiter)
+            {
+                std::lock_guard<std::mutex> lck(waiter->guard);
+                waiter->done = true;
+                waiter->done_cond.notify_one();
+            }
+        }
+
+        // loop that sets result
+        EventLoop& producer;
+        // copies of promise
+        std::atomic_size_t promises { 1 };
+
+        std::mutex guard;
+        bool ready = false;
+        future_value<T> value;
+        std::exception_ptr error;
+        small_handler continuation;
+        EventLoop* continuation_loop = nullptr;
+        wait_sync::ref waiter;
+    };
+
+    template <typename Func, typename T>
+    struct continuation_result
+    {
+        using type = typename std::result_of<Func(T)>::type;
+    };
+
+    template <typename Func>
+    struct continuation_result<Func, void>
+    {
+        using type = typename std::result_of<Func()>::type;
+    };
+} // namespace detail
+
+/* Result of asynchronous call in event loop.
+ * Unlike wait_async it does not block caller.
+ * Result is taken once either by 'get' (blocking)
+ * or by 'then' (continuation in chosen loop)
+*/
+template <typename T, typename EventLoop>
+class loop_future
+{
+    using state_type = detail::future_state<T, EventLoop>;
+
+public:
+    loop_future() = default;
+
+    loop_future(loop_future&&) = default;
+    loop_future& operator=(loop_future&&) = default;
+
+    loop_future(const loop_future&) = delete;
+    loop_future& operator=(const loop_future&) = delete;
+
+    bool valid() const
+    {
+        return _state != nullptr;
+    }
+
+    bool is_ready() const
+    {
+        SRV_ASSERT(_state);
+
+        std::lock_guard<std::mutex> lck(_state->guard);
+        return _state->ready;
+    }
+
+    // Block until result is set. It rethrows exception of asynchronous call
+    // (std::future_error with 'broken_promise' if result is never going to be set).
+    // Waiting in the loop that should set result is deadlock thus it is asserted
+    T get()
+    {
+        SRV_ASSERT(_state);
+
+        auto state = std::move(_state);
+        {
+            std::unique_lock<std::mutex> lck(state->guard);
+            if (!state->ready)
+            {
+                SRV_ASSERT(!state->producer.is_this_running_loop(), "Future is waited in its own loop");
+                SRV_ASSERT(!state->continuation, "Future has continuation");
+
+                auto sync = wait_sync::acquire();
+                state->waiter = sync;
+                lck.unlock();
+
+                std::unique_lock<std::mutex> sync_lck(sync->guard);
+                sync->done_cond.wait(sync_lck, [&sync]() { return sync->done; });
+            }
+        }
+
+        if (state->error)
+            std::rethrow_exception(state->error);
+        return state->value.take();
+    }
+
+    // Run 'func' with result in 'loop' when result is set.
+    // It runs inline if result is set in 'loop' (or it is ready and 'then' is called in 'loop').
+    // Exception of asynchronous call is passed to returned future without 'func' call
+    template <typename Func>
+    loop_future<typename detail::continuation_result<typename std::decay<Func>::type, T>::type, EventLoop>
+    then(EventLoop& loop, Func&& func)
+    {
+        using result_type = typename detail::continuation_result<typename std::decay<Func>::type, T>::type;
+
+        SRV_ASSERT(_state);
+
+        loop_promise<result_type, EventLoop> next(loop);
+        auto result = next.get_future();
+
+        auto state = std::move(_state);
+        small_handler continuation { [state, next, func = typename std::decay<Func>::type(std::forward<Func>(func))]() mutable {
+            if (state->error)
+                next.set_exception(state->error);
+            else
+                next.set_by_value(func, state->value);
+        } };
+
+        {
+            std::unique_lock<std::mutex> lck(state->guard);
+
+            SRV_ASSERT(!state->continuation, "Future has continuation");
+
+            if (!state->ready)
+            {
+                state->continuation = std::move(continuation);
+                state->continuation_loop = &loop;
+                return result;
+            }
+        }
+
+        state_type::run_in(loop, std::move(continuation));
+        return result;
+    }
+
+private:
+    friend class loop_promise<T, EventLoop>;
+
+    explicit loop_future(const std::shared_ptr<state_type>& state)
+        : _state(state)
+    {
+    }
+
+    std::shared_ptr<state_type> _state;
+};
+
+/* Setter of loop_future result.
+ * It is copyable to be captured by handlers.
+ * If the last copy is destroyed without result the future is broken
+*/
+template <typename T, typename EventLoop>
+class loop_promise
+{
+    using state_type = detail::future_state<T, EventLoop>;
+
+public:
+    // 'producer' is the loop where result is going to be set
+    explicit loop_promise(EventLoop& producer)
+        : _state(std::make_shared<state_type>(producer))
+    {
+    }
+
+    loop_promise(const loop_promise& other)
+        : _state(other._state)
+    {
+        if (_state)
+            ++_state->promises;
+    }
+
+    loop_promise(loop_promise&& other) noexcept
+        : _state(std::move(other._state))
+    {
+    }
+
+    loop_promise& operator=(loop_promise other) noexcept
+    {
+        std::swap(_state, other._state);
+        return *this;
+    }
+
+    ~loop_promise()
+    {
+        if (_state && --_state->promises == 0)
+            state_type::abandon(_state);
+    }
+
+    loop_future<T, EventLoop> get_future()
+    {
+        return loop_future<T, EventLoop> { _state };
+    }
+
+    template <typename U = T, typename = typename std::enable_if<!std::is_void<U>::value>::type>
+    void set_value(U&& value)
+    {
+        detail::future_value<T> result;
+        result.set(std::forward<U>(value));
+        state_type::complete(_state, std::move(result), nullptr);
+    }
+
+    template <typename U = T, typename = typename std::enable_if<std::is_void<U>::value>::type>
+    void set_value()
+    {
+        state_type::complete(_state, {}, nullptr);
+    }
+
+    void set_exception(std::exception_ptr error)
+    {
+        state_type::complete(_state, {}, error);
+    }
+
+    // set result of 'func' call or its exception
+    template <typename Func>
+    void set_by(Func& func)
+    {
+        detail::future_value<T> result;
+        std::exception_ptr error;
+        try
+        {
+            result.set_by(func);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        state_type::complete(_state, std::move(result), error);
+    }
+
+    // set result of 'func' call with value of previous future
+    template <typename Func, typename U>
+    void set_by_value(Func& func, detail::future_value<U>& value)
+    {
+        detail::future_value<T> result;
+        std::exception_ptr error;
+        try
+        {
+            set_by_value_impl(result, func, value);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        state_type::complete(_state, std::move(result), error);
+    }
+
+private:
+    template <typename Func, typename U>
+    static void set_by_value_impl(detail::future_value<T>& result, Func& func, detail::future_value<U>& value)
+    {
+        result.set_by(func, value.take());
+    }
+
+    template <typename Func>
+    static void set_by_value_impl(detail::future_value<T>& result, Func& func, detail::future_value<void>&)
+    {
+        result.set_by(func);
+    }
+
+    std::shared_ptr<state_type> _state;
+};
+
+} // namespace server_lib
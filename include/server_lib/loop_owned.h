@@ -0,0 +1,146 @@
+#pragma once
+
+#include <server_lib/asserts.h>
+
+#include <memory>
+#include <utility>
+
+namespace server_lib {
+
+/* Owner of object that lives in 'home' event loop.
+ * Object is destroyed by handler queued to home loop, thus
+ * it is destroyed after all handlers that were posted before
+ * (to any priority lane).
+ *
+ * It lets handlers posted to home loop capture raw pointer ('get')
+ * instead of shared_ptr copy (two atomic refcount operations per post).
+ * Pointer is valid in handler if it was posted to home loop
+ * while owner (or shared_ptr from 'share') was alive.
+ *
+ * Owner is move-only. If home loop is not running object waits
+ * for its start and it is destroyed with loop queues if loop
+ * is destroyed before
+*/
+template <typename T, typename EventLoop>
+class loop_owned
+{
+public:
+    loop_owned() = default;
+
+    loop_owned(EventLoop& home, std::unique_ptr<T>&& object)
+        : _home(&home)
+        , _object(object.release())
+    {
+    }
+
+    ~loop_owned()
+    {
+        reset();
+    }
+
+    loop_owned(loop_owned&& other)
+        : _home(other._home)
+        , _object(other._object)
+    {
+        other._object = nullptr;
+    }
+
+    loop_owned& operator=(loop_owned&& other)
+    {
+        if (this != &other)
+        {
+            reset();
+            _home = other._home;
+            _object = other._object;
+            other._object = nullptr;
+        }
+        return *this;
+    }
+
+    loop_owned(const loop_owned&) = delete;
+    loop_owned& operator=(const loop_owned&) = delete;
+
+    explicit operator bool() const
+    {
+        return _object != nullptr;
+    }
+
+    T* get() const
+    {
+        return _object;
+    }
+
+    T* operator->() const
+    {
+        SRV_ASSERT(_object);
+        return _object;
+    }
+
+    T& operator*() const
+    {
+        SRV_ASSERT(_object);
+        return *_object;
+    }
+
+    EventLoop& home() const
+    {
+        SRV_ASSERT(_home);
+        return *_home;
+    }
+
+    // deferred destruction of owned object
+    void reset()
+    {
+        if (!_object)
+            return;
+
+        destroy(*_home, _object);
+        _object = nullptr;
+    }
+
+    /* Shared ownership for API that works with shared_ptr.
+     * The last shared_ptr destroys object in home loop
+     * (it supports enable_shared_from_this)
+    */
+    std::shared_ptr<T> share() &&
+    {
+        SRV_ASSERT(_object);
+
+        auto* home = _home;
+        auto* object = _object;
+        _object = nullptr;
+        return std::shared_ptr<T>(object, [home](T* object_) {
+            destroy(*home, object_);
+        });
+    }
+
+    static void destroy(EventLoop& home, T* object)
+    {
+        // Object is destroyed even if handler is dropped by loop
+        // (it is destroyed with handler then).
+        // Every lane is FIFO, so handler passes through lanes one by one
+        // (high, normal and low) to be behind handlers of all lanes.
+        // Hops are undroppable, so drain timeout doesn't skip them
+        // ahead of undroppable handlers that are still queued
+        std::shared_ptr<T> holder { object };
+        home.enqueue(EventLoop::priority::high, [&home, holder]() {
+            home.enqueue([&home, holder]() {
+                home.enqueue(EventLoop::priority::low, [holder]() mutable {
+                    holder.reset();
+                });
+            });
+        });
+    }
+
+private:
+    EventLoop* _home = nullptr;
+    T* _object = nullptr;
+};
+
+template <typename T, typename EventLoop, typename... Args>
+loop_owned<T, EventLoop> make_loop_owned(EventLoop& home, Args&&... args)
+{
+    return { home, std::unique_ptr<T>(new T(std::forward<Args>(args)...)) };
+}
+
+} // namespace server_lib
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <server_lib/handler_allocator.h>
+
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace server_lib {
+
+/* Node of intrusive MPSC queue.
+ * Handler is stored in the same memory block just after the node
+*/
+struct task_node
+{
+    std::atomic<task_node*> next { nullptr };
+
+    // run (or only destroy if 'run' is false) and release node memory
+    void (*complete)(task_node*, bool run) = nullptr;
+};
+
+template <typename Handler>
+struct handler_task_node : public task_node
+{
+    template <typename Arg>
+    handler_task_node(handler_memory& memory_, Arg&& handler_)
+        : memory(memory_)
+        , handler(std::forward<Arg>(handler_))
+    {
+        complete = &handler_task_node::complete_impl;
+    }
+
+    static void complete_impl(task_node* base, bool run)
+    {
+        auto* node = static_cast<handler_task_node*>(base);
+        auto& memory = node->memory;
+
+        // node memory is released even if handler throws
+        struct node_guard
+        {
+            handler_task_node* node;
+            handler_memory& memory;
+
+            ~node_guard()
+            {
+                node->~handler_task_node();
+                memory.deallocate(node, sizeof(handler_task_node));
+            }
+        } guard { node, memory };
+
+        if (run)
+            node->handler();
+    }
+
+    handler_memory& memory;
+    Handler handler;
+};
+
+template <typename Handler>
+task_node* make_task_node(handler_memory& memory, Handler&& handler)
+{
+    using node_type = handler_task_node<typename std::decay<Handler>::type>;
+
+    void* p = memory.allocate(sizeof(node_type));
+    try
+    {
+        return new (p) node_type(memory, std::forward<Handler>(handler));
+    }
+    catch (...)
+    {
+        memory.deallocate(p, sizeof(node_type));
+        throw;
+    }
+}
+
+/* Intrusive lock-free queue for multiple producers and single consumer
+ * (D. Vyukov algorithm). Push is wait-free (single exchange),
+ * pop is lock-free and is allowed for consumer thread only
+*/
+class mpsc_queue
+{
+public:
+    mpsc_queue()
+        : _head(&_stub)
+        , _tail(&_stub)
+    {
+    }
+
+    ~mpsc_queue()
+    {
+        clear();
+    }
+
+    mpsc_queue(const mpsc_queue&) = delete;
+    mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+    void push(task_node* node)
+    {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        task_node* prev = _head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // nullptr if queue is empty or producer has not finished push yet
+    task_node* pop()
+    {
+        task_node* tail = _tail;
+        task_node* next = tail->next.load(std::memory_order_acquire);
+        if (tail == &_stub)
+        {
+            if (!next)
+                return nullptr;
+            _tail = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next)
+        {
+            _tail = next;
+            return tail;
+        }
+        if (tail != _head.load(std::memory_order_acquire))
+            return nullptr;
+        push(&_stub);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next)
+        {
+            _tail = next;
+            return tail;
+        }
+        return nullptr;
+    }
+
+    // for consumer thread only
+    bool empty() const
+    {
+        return _tail->next.load(std::memory_order_acquire) == nullptr
+            && _head.load(std::memory_order_acquire) == _tail;
+    }
+
+    // destroy nodes without running. For consumer thread only
+    void clear()
+    {
+        while (auto* node = pop())
+            node->complete(node, false);
+    }
+
+private:
+    std::atomic<task_node*> _head;
+    task_node* _tail;
+    task_node _stub;
+};
+
+} // namespace server_lib
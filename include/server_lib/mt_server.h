@@ -46,6 +46,11 @@ public:
             control_callback_type control_callback = nullptr);
     void stop(main_loop& e);
 
+    // Default exit callback (for SIGTERM, SIGINT) drains main loop:
+    // queued handlers are finished before stop but not longer than timeout.
+    // Zero timeout means immediate stop
+    void set_drain_timeout(const std::chrono::milliseconds&);
+
     void wait_started(main_loop& e, std::function<void(void)>&&);
 
 private:
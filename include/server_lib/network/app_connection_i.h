@@ -8,9 +8,37 @@
 #include <string>
 #include <vector>
 
+#ifndef SERVER_LIB_TCP_CLIENT_READ_SIZE
+#define SERVER_LIB_TCP_CLIENT_READ_SIZE 4096
+#endif /* SERVER_LIB_TCP_CLIENT_READ_SIZE */
+
 namespace server_lib {
 namespace network {
 
+    /**
+     * @brief size of socket reads of connection
+     */
+    struct read_options
+    {
+        /**
+         * bytes requested by every read (initial size for adaptive mode)
+         *
+         */
+        size_t size = SERVER_LIB_TCP_CLIENT_READ_SIZE;
+
+        /**
+         * read size is doubled when read fills whole buffer and it is halved
+         * when several reads in a row fill less than quarter of buffer.
+         * So bulk transfers need fewer reads and callbacks but idle
+         * connections don't keep large buffers
+         *
+         */
+        bool adaptive = false;
+
+        size_t min_size = 512;
+        size_t max_size = 1024 * 1024;
+    };
+
     /**
      * @brief wrapper for TCP connetion (used by both server and client) for app_unit
      */
@@ -32,6 +60,16 @@ namespace network {
 
         virtual app_connection_i& commit() = 0;
 
+        /**
+         * In auto-flush mode sent units are written at the end of current
+         * event loop tick without 'commit'. Units sent while previous write
+         * is in progress are joined to the next write. Connection joins units
+         * itself, so TCP_NODELAY is set and socket is corked while writes
+         * follow each other
+         *
+         */
+        virtual void set_auto_flush(bool) = 0;
+
         using receive_callback_type = std::function<void(app_connection_i&, app_unit&)>;
 
         virtual void set_on_receive_handler(const receive_callback_type&) = 0;
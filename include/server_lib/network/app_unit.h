@@ -1,5 +1,7 @@
 #pragma once
 
+#include <server_lib/network/buffer_chain.h>
+
 #include <boost/variant/variant.hpp>
 
 #include <iostream>
@@ -29,6 +31,12 @@ namespace network {
         {
         }
 
+        /**
+         * string unit that references received data (without copying)
+         *
+         */
+        app_unit(const buffer_view& value, const bool success = true);
+
         using integer_type = uint32_t;
 
         app_unit(const integer_type value, const bool success = true);
@@ -62,11 +70,17 @@ namespace network {
 
         bool is_null() const;
 
+        /**
+         * string unit references shared bytes (received data)
+         *
+         */
+        bool is_view() const;
+
         friend bool operator==(const app_unit& a, const app_unit& b)
         {
             if (a._success != b._success)
                 return false;
-            if (a._data != b._data)
+            if (!equal_data(a, b))
                 return false;
             return a._nested_content == b._nested_content;
         }
@@ -77,11 +91,19 @@ namespace network {
         explicit operator bool() const;
 
     public:
-        const std::string& error() const;
+        std::string error() const;
 
         const std::vector<app_unit>& get_nested() const;
 
-        const std::string& as_string() const;
+        /**
+         * string unit built from received data references receive
+         * buffer. String is copied from it at every call
+         * (use 'as_view' to read it without copying)
+         *
+         */
+        std::string as_string() const;
+
+        buffer_view as_view() const;
 
         integer_type as_integer() const;
 
@@ -95,6 +117,8 @@ namespace network {
 
         void set(const std::string& value, const bool success = true);
 
+        void set(const buffer_view& value, const bool success = true);
+
         void set(const integer_type value, const bool success = true);
 
         void set(const std::vector<app_unit>& nested, const bool success = true);
@@ -109,9 +133,12 @@ namespace network {
         app_unit& operator<<(const app_unit& unit);
 
     private:
+        static bool equal_data(const app_unit& a, const app_unit& b);
+
         using variant_type = boost::variant<std::string,
                                             integer_type,
-                                            bool>;
+                                            bool,
+                                            buffer_view>;
 
         bool _success = false;
         variant_type _data;
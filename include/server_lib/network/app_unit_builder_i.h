@@ -1,6 +1,7 @@
 #pragma once
 
 #include <server_lib/network/app_unit.h>
+#include <server_lib/network/buffer_chain.h>
 
 #include <memory>
 #include <string>
@@ -45,6 +46,25 @@ namespace network {
          */
         virtual app_unit_builder_i& operator<<(std::string& data) = 0;
 
+        /**
+         * the same for received data. Builder should consume used bytes
+         * from the front of chain and could take unit as slice of it
+         * (buffer_chain::slice) without copying.
+         * By default data is passed to string version
+         *
+         * @param data data to be consumed
+         * @return current instance
+         *
+         */
+        virtual app_unit_builder_i& operator<<(buffer_chain& data)
+        {
+            auto network_data = data.to_string();
+            auto sz = network_data.size();
+            *this << network_data;
+            data.consume(sz - network_data.size());
+            return *this;
+        }
+
         /**
          * @return whether the unit could be built
          *
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <server_lib/network/tcp_server_i.h>
+#include <server_lib/network/tcp_client_i.h>
+
+#include <memory>
+
+namespace server_lib {
+
+class event_loop;
+class event_loop_pool;
+
+namespace network {
+
+    /**
+     * @brief settings of Boost.Asio server
+     */
+    struct asio_server_options
+    {
+        /**
+         * every I/O loop listens own SO_REUSEPORT socket, so kernel
+         * spreads accepts between loops and whole connection lifecycle
+         * (accept, I/O, callbacks) stays in the loop that accepted it.
+         * It is ignored for single I/O loop (callback thread) and for
+         * platforms without SO_REUSEPORT
+         *
+         */
+        bool sharded_listen = false;
+    };
+
+    /**
+     * Boost.Asio transport for network_server and network_client
+     * (it plugs by their transport_layer constructors).
+     * Sockets are served directly by io_service of event_loop,
+     * so if transport runs in callback loop packets are not
+     * passed between threads at all.
+     *
+     * Server I/O runs:
+     *  - in 'callback_thread' of start if it is not 'nullptr',
+     *  - in own loops (set_nb_workers, one by default) otherwise
+     */
+    std::shared_ptr<tcp_server_i> create_asio_server(const asio_server_options& options = {});
+
+    /**
+     * Server I/O is spread between pool loops (by pool balance policy).
+     * Start network_server with the same pool to run callbacks
+     * of connection in loop of its socket.
+     * With 'sharded_listen' every pool loop accepts connections
+     * for itself
+     */
+    std::shared_ptr<tcp_server_i> create_asio_server(event_loop_pool& io_loops, const asio_server_options& options = {});
+
+    /**
+     * Client I/O runs in 'io_loop'. Pass the same loop like
+     * callback thread to network_client::connect to avoid
+     * passing packets between threads.
+     * If 'io_loop' is 'nullptr' client uses own loop
+     */
+    std::shared_ptr<tcp_client_i> create_asio_client(event_loop* io_loop = nullptr);
+
+} // namespace network
+} // namespace server_lib
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace server_lib {
+namespace network {
+
+    /**
+     * @brief slice of ref-counted byte block
+     *
+     * Copy of view shares block. It is used to pass received
+     * data from transport to units without copying bytes
+     */
+    class buffer_view
+    {
+    public:
+        using block_type = std::shared_ptr<const std::vector<char>>;
+
+        buffer_view() = default;
+
+        /**
+         * take received bytes (without copying)
+         *
+         */
+        explicit buffer_view(std::vector<char>&& data);
+
+        /**
+         * copy bytes to new block
+         *
+         */
+        explicit buffer_view(const std::string& data);
+
+        buffer_view(const block_type& block, size_t offset, size_t size);
+
+        const char* data() const
+        {
+            return _block ? _block->data() + _offset : nullptr;
+        }
+
+        size_t size() const
+        {
+            return _size;
+        }
+
+        bool empty() const
+        {
+            return _size == 0;
+        }
+
+        /**
+         * @return view of part of this one (it shares block)
+         *
+         */
+        buffer_view slice(size_t pos, size_t len) const;
+
+        std::string to_string() const;
+
+        friend bool operator==(const buffer_view& a, const buffer_view& b);
+
+        friend bool operator!=(const buffer_view& a, const buffer_view& b)
+        {
+            return !(a == b);
+        }
+
+    private:
+        block_type _block;
+        size_t _offset = 0;
+        size_t _size = 0;
+    };
+
+    /**
+     * @brief sequence of received views (byte stream)
+     *
+     * Builders parse stream in place and take units as slices of it.
+     * Slice inside single view is not copied, slice that crosses
+     * view bounds is merged to new block
+     */
+    class buffer_chain
+    {
+    public:
+        static constexpr size_t npos = std::string::npos;
+
+        void append(const buffer_view& view);
+
+        size_t size() const
+        {
+            return _size;
+        }
+
+        bool empty() const
+        {
+            return _size == 0;
+        }
+
+        char at(size_t pos) const;
+
+        /**
+         * @return position of 'pattern' or 'npos'
+         *
+         */
+        size_t find(const std::string& pattern, size_t from = 0) const;
+
+        buffer_view slice(size_t pos, size_t len) const;
+
+        /**
+         * remove 'len' bytes from the front
+         *
+         */
+        void consume(size_t len);
+
+        void clear();
+
+        std::string to_string() const;
+
+    private:
+        std::deque<buffer_view> _views;
+        size_t _size = 0;
+    };
+
+} // namespace network
+} // namespace server_lib
@@ -27,6 +27,8 @@ namespace network {
 
         app_unit_builder_i& operator<<(std::string& network_data) override;
 
+        app_unit_builder_i& operator<<(buffer_chain& network_data) override;
+
         bool unit_ready() const override
         {
             return _buffer_unit.ok();
@@ -32,6 +32,8 @@ namespace network {
 
         app_unit_builder_i& operator<<(std::string& network_data) override;
 
+        app_unit_builder_i& operator<<(buffer_chain& network_data) override;
+
         bool unit_ready() const override
         {
             return _ready;
@@ -45,6 +47,9 @@ namespace network {
         void reset() override;
 
     private:
+        template <typename Data>
+        void parse(Data& network_data);
+
         const size_t _msg_max_size;
 
         bool _ready = false;
@@ -62,6 +62,15 @@ namespace network {
 
         void set_nb_workers(uint8_t nb_threads);
 
+        // CPU affinity, NUMA node and scheduling policy for transport workers
+        void set_worker_options(const thread_options&);
+
+        // size of socket reads for connection (it is applied to new connections)
+        void set_read_options(const read_options&);
+
+        // send units without 'commit' (see app_connection_i::set_auto_flush)
+        void set_auto_flush(bool);
+
         void disconnect(bool wait_for_removal = true);
 
         bool is_connected() const;
@@ -81,6 +90,8 @@ namespace network {
         receive_callback_type _receive_callback = nullptr;
         std::shared_ptr<tcp_client_i> _transport_layer;
         std::shared_ptr<app_connection_i> _connection;
+        read_options _read_options;
+        bool _auto_flush = false;
     };
 
 } // namespace network
@@ -4,6 +4,8 @@
 #include <server_lib/network/app_connection_i.h>
 #include <server_lib/network/app_unit_builder_i.h>
 
+#include <server_lib/event_loop_pool.h>
+
 #include <string>
 #include <functional>
 #include <memory>
@@ -54,8 +56,31 @@ namespace network {
                    const on_new_connection_callback_type& callback = nullptr,
                    uint8_t nb_threads = 0);
 
+        /**
+         * start the TCP server with callbacks spread between pool loops
+         *
+         * @param callback_threads for callbacks:
+         *        Every new connection is bound to the next pool loop
+         *        (by pool balance policy) or to pool loop that serves
+         *        its socket (see create_asio_server). All callbacks
+         *        of this connection including 'callback' run in its loop
+         *
+         */
+        bool start(const std::string& host,
+                   uint16_t port,
+                   const app_unit_builder_i* protocol,
+                   event_loop_pool& callback_threads,
+                   const on_new_connection_callback_type& callback,
+                   uint8_t nb_threads = 0);
+
         void set_nb_workers(uint8_t nb_threads);
 
+        // CPU affinity, NUMA node and scheduling policy for transport workers
+        void set_worker_options(const thread_options&);
+
+        // size of socket reads for client connections (it is applied to new connections)
+        void set_read_options(const read_options&);
+
         void stop(bool wait_for_removal = false, bool recursive_wait_for_removal = true);
 
         bool is_running(void) const;
@@ -63,14 +88,26 @@ namespace network {
         app_unit_builder_i& protocol();
 
     private:
+        bool start_impl(const std::string& host,
+                        uint16_t port,
+                        const app_unit_builder_i* protocol,
+                        event_loop* callback_thread,
+                        event_loop_pool* callback_threads,
+                        const on_new_connection_callback_type& callback,
+                        uint8_t nb_threads);
+
+        event_loop& pool_loop(const tcp_connection_i&);
+
         void on_new_connection(const std::shared_ptr<tcp_connection_i>&);
 
         std::shared_ptr<tcp_server_i> _transport_layer;
 
         event_loop* _callback_thread = nullptr;
+        event_loop_pool* _callback_threads = nullptr;
         on_new_connection_callback_type _new_connection_handler = nullptr;
 
         std::shared_ptr<app_unit_builder_i> _protocol;
+        read_options _read_options;
     };
 } // namespace network
 } // namespace server_lib
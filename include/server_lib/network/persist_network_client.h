@@ -82,6 +82,12 @@ namespace network {
 
         void set_nb_workers(uint8_t nb_threads);
 
+        // CPU affinity, NUMA node and scheduling policy for transport workers
+        void set_worker_options(const thread_options&);
+
+        // size of socket reads for connection (it is applied to new connections)
+        void set_read_options(const read_options&);
+
         void disconnect(bool wait_for_removal = true);
 
         bool is_connected() const;
@@ -98,6 +104,29 @@ namespace network {
 
         std::future<app_unit> send(const app_unit& cmd);
 
+#if BOOST_VERSION >= 107000
+        /**
+         * Send and commit command for asio completion token
+         * (see event_loop::async_sleep). Completion signature is void(app_unit).
+         * Network failure completes request like it does for 'send(cmd, callback)'
+         * For example: auto reply = co_await client.async_request(cmd, boost::asio::use_awaitable);
+         */
+        template <typename CompletionToken>
+        auto async_request(const app_unit& cmd, CompletionToken&& token)
+        {
+            return boost::asio::async_initiate<CompletionToken, void(app_unit)>(
+                [this](auto handler, const app_unit& cmd) {
+                    // receive callback should be copyable
+                    auto handler_ = std::make_shared<decltype(handler)>(std::move(handler));
+                    this->send(cmd, [handler_](app_unit& unit) {
+                        complete_async(std::move(*handler_), unit);
+                    });
+                    this->commit();
+                },
+                token, cmd);
+        }
+#endif
+
         persist_network_client& commit();
 
         persist_network_client& sync_commit();
@@ -151,6 +180,7 @@ namespace network {
         uint32_t _reconnect_interval_ms = 0;
         uint8_t _nb_threads = 1;
         std::shared_ptr<app_unit_builder_i> _protocol;
+        read_options _read_options;
 
         std::shared_ptr<tcp_client_i> _transport_layer;
         std::shared_ptr<app_connection_i> _connection;
@@ -34,9 +34,11 @@ namespace network {
 
         app_unit_builder_i& operator<<(std::string& network_data) override;
 
+        app_unit_builder_i& operator<<(buffer_chain& network_data) override;
+
         bool unit_ready() const override
         {
-            return !_buffer.empty();
+            return !_buffer.empty() || !_view.empty();
         }
 
         app_unit get_unit() const override;
@@ -44,10 +46,12 @@ namespace network {
         void reset() override
         {
             _buffer.clear();
+            _view = {};
         }
 
     private:
         std::string _buffer;
+        buffer_view _view;
     };
 
 } // namespace network
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <server_lib/network/tcp_connection_i.h>
+#include <server_lib/thread_options.h>
 
 #include <cstdint>
 #include <memory>
@@ -56,6 +57,14 @@ namespace network {
         */
         virtual void set_nb_workers(uint8_t nb_threads) = 0;
 
+        /**
+        * set CPU affinity, NUMA node and scheduling policy for threads of the thread pool
+        * options are applied by every worker thread itself when it runs the next callback
+        *
+        * \param options thread options
+        */
+        virtual void set_worker_options(const thread_options& options) = 0;
+
     public:
         /**
          *
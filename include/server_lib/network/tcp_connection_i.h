@@ -1,10 +1,15 @@
 #pragma once
 
+#include <server_lib/network/buffer_chain.h>
+
 #include <functional>
 #include <string>
 #include <vector>
 
 namespace server_lib {
+
+class event_loop;
+
 namespace network {
 
     /**
@@ -21,6 +26,16 @@ namespace network {
          */
         virtual bool is_connected() const = 0;
 
+        /**
+         * @return loop that runs I/O of connection
+         * (if transport works in event_loop)
+         *
+         */
+        virtual event_loop* io_loop() const
+        {
+            return nullptr;
+        }
+
     public:
         /**
          * structure to store read requests result
@@ -112,8 +127,34 @@ namespace network {
              *
              */
             async_write_callback_type async_write_callback;
+
+            /**
+             * bytes to write after 'buffer' by pieces without joining
+             * (it is sent by single gather write if transport supports it)
+             *
+             */
+            std::vector<buffer_view> buffers;
         };
 
+        /**
+         * join 'buffers' of request to its 'buffer'
+         * (for transport without gather write)
+         *
+         */
+        static void flatten(write_request& request)
+        {
+            if (request.buffers.empty())
+                return;
+
+            auto sz = request.buffer.size();
+            for (auto&& view : request.buffers)
+                sz += view.size();
+            request.buffer.reserve(sz);
+            for (auto&& view : request.buffers)
+                request.buffer.insert(request.buffer.end(), view.data(), view.data() + view.size());
+            request.buffers.clear();
+        }
+
     public:
         /**
          * async read operation
@@ -131,6 +172,31 @@ namespace network {
          */
         virtual void async_write(write_request& request) = 0;
 
+        /**
+         * set TCP_NODELAY option of socket
+         * (it is ignored if transport doesn't support it)
+         *
+         */
+        virtual void set_no_delay(bool)
+        {
+        }
+
+        /**
+         * set TCP_CORK option of socket. Corked socket sends only full
+         * segments until it is uncorked
+         * (it is ignored if transport or platform doesn't support it)
+         *
+         */
+        virtual void set_cork(bool)
+        {
+        }
+
+        /**
+         * close socket. Pending operations are failed
+         *
+         */
+        virtual void disconnect() = 0;
+
     public:
         using disconnection_callback_type = std::function<void(tcp_connection_i&)>;
 
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <server_lib/network/tcp_server_i.h>
+#include <server_lib/network/tcp_client_i.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace server_lib {
+namespace network {
+
+    /**
+     * @brief settings of io_uring transport
+     */
+    struct uring_options
+    {
+        /**
+         * submission queue size of ring. Every worker thread has own ring
+         *
+         */
+        uint32_t queue_depth = 1024;
+    };
+
+    /**
+     * Linux io_uring transport for network_server and network_client
+     * (it plugs by their transport_layer constructors).
+     * Listener uses multishot accept. Read goes to own buffer
+     * that is passed to app without copying.
+     * All requests prepared by worker thread in one pass
+     * are submitted by single system call.
+     *
+     * It is available if library is built with SERVER_LIB_IO_URING option.
+     * Kernel 5.19+ is required
+     */
+    bool is_uring_supported();
+
+    std::shared_ptr<tcp_server_i> create_uring_server(const uring_options& options = {});
+
+    /**
+     * Client works with single ring (worker thread)
+     */
+    std::shared_ptr<tcp_client_i> create_uring_client(const uring_options& options = {});
+
+} // namespace network
+} // namespace server_lib
@@ -2,6 +2,7 @@
 
 #include <server_lib/event_loop.h>
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 #include <mutex>
@@ -83,7 +84,12 @@ protected:
 
     void notify_impl(const sink_member& memf)
     {
+        using pending_type = std::function<void(void)>;
+
         std::lock_guard<std::mutex> lck(_guard_for_observers);
+
+        //all notifications for the same loop are posted by single batch
+        std::vector<std::pair<event_loop*, std::vector<pending_type>>> pendings;
         for (auto&& item : _observers)
         {
             observer_i* psink = reinterpret_cast<observer_i*>(item.first);
@@ -93,14 +99,27 @@ protected:
             event_loop* p_el = item.second;
             if (p_el && !p_el->is_this_loop())
             {
-                auto pending = [memf, psink]() {
+                auto it = std::find_if(pendings.begin(), pendings.end(), [p_el](const auto& pending) {
+                    return pending.first == p_el;
+                });
+                if (it == pendings.end())
+                    it = pendings.emplace(pendings.end(), p_el, std::vector<pending_type> {});
+
+                it->second.emplace_back([memf, psink]() {
                     memf(psink);
-                };
-                p_el->post(pending);
+                });
             }
             else
                 memf(psink);
         }
+
+        for (auto&& pending : pendings)
+        {
+            if (pending.second.size() > 1)
+                pending.first->post_bulk(std::move(pending.second));
+            else
+                pending.first->post(std::move(pending.second.front()));
+        }
     }
 
 private:
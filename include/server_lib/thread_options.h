@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace server_lib {
+
+/* Placement and scheduling of thread.
+ * Default options change nothing.
+ * Options are supported for Linux only
+*/
+struct thread_options
+{
+    enum class sched_policy
+    {
+        other = 0,
+        fifo,
+        rr
+    };
+
+    // pin thread to these CPUs (or to CPUs of 'numa_node' if it is empty)
+    std::vector<int> cpus;
+    // bind thread allocations to NUMA node (-1 if not bound)
+    int numa_node = -1;
+    sched_policy policy = sched_policy::other;
+    // for 'fifo' and 'rr' policies (1..99)
+    int priority = 0;
+    // for 'other' policy (-20..19)
+    int nice = 0;
+
+    bool empty() const
+    {
+        return cpus.empty() && numa_node < 0 && policy == sched_policy::other && !nice;
+    }
+};
+
+// Apply options to the current thread. They replace previously
+// applied options: thread state is restored first (empty options
+// only restore it).
+// If some option can't be applied it is skipped with warning
+// and false is returned
+bool apply_thread_options(const thread_options&);
+
+/* Options for threads that are not created by this library
+ * (like tacopie workers). Thread applies set options itself
+ * when it calls 'apply' after change. 'apply' is cheap if options
+ * were not changed. Thread that serves several owners applies
+ * options of every owner once after its change
+*/
+class deferred_thread_options
+{
+public:
+    deferred_thread_options();
+
+    deferred_thread_options(const deferred_thread_options&) = delete;
+    deferred_thread_options& operator=(const deferred_thread_options&) = delete;
+
+    void set(const thread_options&);
+
+    // call from target thread
+    void apply();
+
+private:
+    const uint64_t _id;
+    std::mutex _guard;
+    thread_options _options;
+    // 0 if options were not set
+    std::atomic_uint64_t _generation { 0 };
+    // threads that have applied current generation
+    std::set<uint64_t> _applied_threads;
+};
+
+} // namespace server_lib
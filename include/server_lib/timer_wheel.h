@@ -0,0 +1,130 @@
+#pragma once
+
+#include <server_lib/handler_allocator.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace server_lib {
+
+/* Hierarchical timing wheel with millisecond ticks.
+ *
+ * Every level has 256 slots. Entry is placed to the level of the highest
+ * tick digit that differs from current tick, thus it moves to lower levels
+ * (cascades) only when wheel reaches slot of this entry. Add and cancel are O(1).
+ * Entries are recycled and addressed by handle with generation
+ * to make cancel of already fired timer harmless.
+ *
+ * Wheel is thread safe but it does not run callbacks itself.
+ * Owner calls 'advance' and runs expired callbacks
+*/
+class timer_wheel
+{
+    struct entry
+    {
+        entry* prev = nullptr;
+        entry* next = nullptr;
+        size_t level_index = 0;
+        size_t slot_index = 0;
+        bool linked = false;
+        uint64_t expiry = 0;
+        uint64_t generation = 0;
+        small_handler callback;
+    };
+
+public:
+    using clock = std::chrono::steady_clock;
+    using tick_type = uint64_t;
+
+    static constexpr tick_type no_expiry = std::numeric_limits<tick_type>::max();
+
+    class handle
+    {
+    public:
+        handle() = default;
+
+        explicit operator bool() const
+        {
+            return _entry != nullptr;
+        }
+
+    private:
+        friend class timer_wheel;
+
+        handle(entry* e, uint64_t generation)
+            : _entry(e)
+            , _generation(generation)
+        {
+        }
+
+        entry* _entry = nullptr;
+        uint64_t _generation = 0;
+    };
+
+    timer_wheel();
+
+    timer_wheel(const timer_wheel&) = delete;
+    timer_wheel& operator=(const timer_wheel&) = delete;
+
+    // ticks from wheel creation
+    tick_type to_tick(const clock::time_point&) const;
+    clock::time_point to_time_point(const tick_type) const;
+
+    // 'earliest' is set if this timer should fire before
+    // wakeup that was requested by last 'next_expiry' call
+    handle add(const std::chrono::milliseconds& delay, small_handler&& callback, bool& earliest);
+
+    // false if timer already fired or canceled
+    bool cancel(const handle&);
+
+    // Move wheel to 'now' and collect callbacks of expired timers
+    void advance(const tick_type now, std::vector<small_handler>& expired);
+
+    // First tick when wheel should be advanced (no_expiry if it is empty).
+    // Result is remembered as requested wakeup
+    tick_type next_expiry();
+
+    size_t size() const;
+
+private:
+    static constexpr size_t level_bits = 8;
+    static constexpr size_t slots_per_level = size_t(1) << level_bits;
+    static constexpr size_t levels = 64 / level_bits;
+    static constexpr size_t bitmap_words = slots_per_level / 64;
+
+    struct level
+    {
+        std::array<entry*, slots_per_level> slots {};
+        std::array<uint64_t, bitmap_words> occupied {};
+    };
+
+    static size_t digit(const tick_type tick, const size_t level_index)
+    {
+        return static_cast<size_t>(tick >> (level_index * level_bits)) & (slots_per_level - 1);
+    }
+
+    entry* acquire();
+    void release(entry*);
+    void link(entry*);
+    void unlink(entry*);
+    entry* take_slot(const size_t level_index, const size_t slot_index);
+    void process(std::vector<small_handler>& expired);
+    tick_type next_event(const tick_type limit) const;
+
+    const clock::time_point _epoch;
+
+    mutable std::mutex _guard;
+    std::vector<level> _levels;
+    std::deque<entry> _entries;
+    entry* _free = nullptr;
+    tick_type _current = 0;
+    tick_type _requested_wakeup = no_expiry;
+    size_t _size = 0;
+};
+
+} // namespace server_lib
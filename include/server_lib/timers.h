@@ -1,9 +1,12 @@
 #pragma once
 
+#include <algorithm>
 #include <chrono>
+#include <functional>
 #include <memory>
 
 #include <server_lib/types.h>
+#include <server_lib/asserts.h>
 
 namespace server_lib {
 
@@ -35,7 +38,8 @@ public:
         int timer_id = ++_current_timer_id->value;
         auto id = _current_timer_id;
 
-        _el.start_timer(std::forward<DurationType>(duration), [=]() {
+        _el.cancel_timer(_handle);
+        _handle = _el.start_timer(std::forward<DurationType>(duration), [=]() {
             if (id->value == timer_id)
                 callback();
         });
@@ -43,6 +47,58 @@ public:
 
 
     virtual void stop()
+    {
+        ++_current_timer_id->value;
+        _el.cancel_timer(_handle);
+        _handle = {};
+    }
+
+private:
+    EventLoop& _el;
+    id_ptr _current_timer_id;
+    typename EventLoop::timer_handle _handle;
+};
+
+
+/* Timer with microseconds resolution.
+ * Every start creates own system timer so it is for short delays
+ * where 'timer' accuracy (1 millisecond) is not enough
+*/
+template <typename EventLoop>
+class hr_timer
+{
+    DECLARE_PTR(id)
+    class id
+    {
+    public:
+        int value = 0;
+    };
+
+public:
+    hr_timer(EventLoop& el)
+        : _el(el)
+        , _current_timer_id(std::make_shared<id>())
+    {
+    }
+
+    ~hr_timer()
+    {
+        stop();
+    }
+
+    template <typename DurationType, typename Callback>
+    void start(DurationType&& duration, Callback&& callback)
+    {
+        int timer_id = ++_current_timer_id->value;
+        auto id = _current_timer_id;
+
+        _el.start_hr_timer(std::forward<DurationType>(duration), [=]() {
+            if (id->value == timer_id)
+                callback();
+        });
+    }
+
+    void stop()
     {
         ++_current_timer_id->value;
     }
@@ -56,28 +112,175 @@ private:
 template <typename EventLoop>
 class periodical_timer
 {
+    using clock = std::chrono::steady_clock;
+
 public:
+    /* What to do with fixed rate ticks that are overdue
+     * for whole period and more (because loop was busy)
+    */
+    enum class catch_up_policy
+    {
+        // drop overdue ticks, call back for the current one
+        // and wait for the next tick by schedule
+        skip,
+        // single callback stands for all overdue ticks
+        // and the current one ('ticks' tells how many)
+        coalesce,
+        // callback for every overdue tick one by one
+        burst
+    };
+
+    /* Lateness of fixed rate ticks from their schedule
+    */
+    struct lateness_stats
+    {
+        uint64_t wakeups = 0; // timer handler calls
+        uint64_t invoked = 0; // callback calls
+        uint64_t missed = 0; // ticks dropped (skip) or merged (coalesce)
+        std::chrono::microseconds last { 0 };
+        std::chrono::microseconds max { 0 };
+        std::chrono::microseconds total { 0 };
+
+        std::chrono::microseconds average() const
+        {
+            return wakeups ? total / static_cast<int64_t>(wakeups) : std::chrono::microseconds { 0 };
+        }
+    };
+
     periodical_timer(EventLoop& el)
         : _timer(el)
     {
     }
 
+    // Period is counted from callback call (it drifts by callback latency)
     template <typename DurationType, typename Callback>
     void start(DurationType&& duration, Callback&& callback)
     {
-        _timer.start(std::forward<DurationType>(duration), [=]() {
-            this->start(duration, callback);
-            callback();
-        });
+        _fixed_rate.reset();
+
+        auto period = std::chrono::duration_cast<std::chrono::milliseconds>(duration);
+        // shared to keep timer handler small and to be able to restart timer from callback
+        schedule(period, std::make_shared<std::function<void()>>(std::forward<Callback>(callback)));
+    }
+
+    // Ticks are scheduled at 'start + N * period' by steady clock
+    template <typename DurationType, typename Callback>
+    void start_fixed_rate(DurationType&& duration, Callback&& callback, const catch_up_policy policy = catch_up_policy::skip)
+    {
+        auto state = std::make_shared<fixed_rate_state>();
+        state->period = std::chrono::duration_cast<clock::duration>(duration);
+        state->deadline = clock::now() + state->period;
+        state->policy = policy;
+        state->callback = std::forward<Callback>(callback);
+
+        SRV_ASSERT(state->period >= std::chrono::milliseconds(1), "1 millisecond is minimum timer accuracy");
+
+        _stats = {};
+        _fixed_rate = state;
+        schedule_fixed_rate(state);
     }
 
     void stop()
     {
+        _fixed_rate.reset();
         _timer.stop();
     }
 
+    // for fixed rate mode. It is updated in loop thread
+    const lateness_stats& stats() const
+    {
+        return _stats;
+    }
+
+    // Ticks that current fixed rate callback stands for.
+    // It is more than 1 for coalesced call only
+    uint64_t ticks() const
+    {
+        return _ticks;
+    }
+
 private:
+    struct fixed_rate_state
+    {
+        clock::duration period;
+        clock::time_point deadline;
+        catch_up_policy policy = catch_up_policy::skip;
+        std::function<void()> callback;
+    };
+    using fixed_rate_state_ptr = std::shared_ptr<fixed_rate_state>;
+
+    void schedule(const std::chrono::milliseconds& period, const std::shared_ptr<std::function<void()>>& callback)
+    {
+        _timer.start(period, [this, period, callback]() {
+            this->schedule(period, callback);
+            (*callback)();
+        });
+    }
+
+    void schedule_fixed_rate(const fixed_rate_state_ptr& state)
+    {
+        auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(state->deadline - clock::now());
+        // timer wheel rounds up, so it is not going to be early
+        if (delay < std::chrono::milliseconds(1))
+            delay = std::chrono::milliseconds(1);
+
+        _timer.start(delay, [this, state]() {
+            this->on_fixed_rate(state);
+        });
+    }
+
+    void on_fixed_rate(const fixed_rate_state_ptr& state)
+    {
+        auto now = clock::now();
+        if (now < state->deadline)
+        {
+            schedule_fixed_rate(state);
+            return;
+        }
+
+        auto lateness = std::chrono::duration_cast<std::chrono::microseconds>(now - state->deadline);
+        // overdue ticks beside the current one
+        auto overdue = static_cast<uint64_t>((now - state->deadline) / state->period);
+
+        ++_stats.wakeups;
+        _stats.last = lateness;
+        _stats.max = std::max(_stats.max, lateness);
+        _stats.total += lateness;
+
+        state->deadline += state->period * static_cast<int64_t>(overdue + 1);
+
+        // current tick fires, deadline is realigned to the next tick
+        uint64_t calls = 1;
+        uint64_t ticks = 1;
+        switch (state->policy)
+        {
+        case catch_up_policy::skip:
+            _stats.missed += overdue;
+            break;
+        case catch_up_policy::coalesce:
+            _stats.missed += overdue;
+            ticks += overdue;
+            break;
+        case catch_up_policy::burst:
+            calls += overdue;
+            break;
+        }
+
+        // next tick is scheduled before callback to allow restart or stop from it
+        schedule_fixed_rate(state);
+
+        for (uint64_t ci = 0; ci < calls && _fixed_rate == state; ++ci)
+        {
+            ++_stats.invoked;
+            _ticks = ticks;
+            state->callback();
+        }
+    }
+
     timer<EventLoop> _timer;
+    fixed_rate_state_ptr _fixed_rate;
+    lateness_stats _stats;
+    uint64_t _ticks = 1;
 };
 
 
@@ -1,62 +1,162 @@
 #pragma once
 
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
 #include <functional>
+#include <memory>
+#include <type_traits>
 
 namespace server_lib {
 
-template <typename Result, typename CallerFunc, typename AsynchFunc>
-Result wait_preliminary_async_call(const Result initial_result, CallerFunc&& caller_func, AsynchFunc&& asynch_func, int32_t timeout_ms = -1)
+/* Synchronization object for waiting of asynchronous call.
+ * Objects are taken from the process-wide pool and they are returned
+ * to it when the last reference (waiting or asynchronous side) is released.
+ * Thus waiting does not allocate after warm up
+*/
+class wait_sync
 {
-    std::condition_variable _donecheck;
-    std::mutex _cond_data_guard;
-    Result result = initial_result;
-    bool _done_request = false;
+public:
+    class ref
+    {
+    public:
+        ref() = default;
 
-    std::unique_lock<std::mutex> lck(_cond_data_guard); //guard _done_request and result variables
+        ref(const ref& other)
+            : _sync(other._sync)
+        {
+            if (_sync)
+                _sync->_refs.fetch_add(1, std::memory_order_relaxed);
+        }
 
-    auto _asynch = [&asynch_func, &result, &_done_request, &_cond_data_guard, &_donecheck]() {
-        std::unique_lock<std::mutex> lck(_cond_data_guard);
+        ref(ref&& other) noexcept
+            : _sync(other._sync)
+        {
+            other._sync = nullptr;
+        }
 
-        result = asynch_func();
-        _done_request = true;
-        lck.unlock();
-        _donecheck.notify_one(); //internally lock _cond_data_guard
-    };
+        ref& operator=(ref other) noexcept
+        {
+            std::swap(_sync, other._sync);
+            return *this;
+        }
 
-    result = caller_func(_asynch);
+        ~ref()
+        {
+            if (_sync && _sync->_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                wait_sync::release(_sync);
+        }
 
-    while (!_done_request) //for OS interruptions case
-    {
-        auto done = [&_done_request]() {
-            return _done_request;
-        };
+        wait_sync* operator->() const
+        {
+            return _sync;
+        }
 
-        if (timeout_ms > 0)
+        explicit operator bool() const
         {
-            if (!_donecheck.wait_for(lck, std::chrono::milliseconds(timeout_ms), done))
-                break;
+            return _sync != nullptr;
         }
-        else
+
+    private:
+        friend class wait_sync;
+
+        explicit ref(wait_sync* sync)
+            : _sync(sync)
         {
-            _donecheck.wait(lck, done); //internally unlock _cond_data_guard
         }
+
+        wait_sync* _sync = nullptr;
+    };
+
+    static ref acquire();
+
+    // objects are created by pool only
+    wait_sync(const wait_sync&) = delete;
+    wait_sync& operator=(const wait_sync&) = delete;
+
+    std::mutex guard;
+    std::condition_variable done_cond;
+    bool done = false;
+    // waiting side has gone (by timeout)
+    bool abandoned = false;
+
+private:
+    wait_sync() = default;
+
+    static void release(wait_sync*);
+
+    std::atomic_int _refs { 0 };
+};
+
+// timeout <= 0 means infinite waiting
+template <typename Result, typename CallerFunc, typename AsynchFunc>
+Result wait_preliminary_async_call(const Result initial_result, CallerFunc&& caller_func, AsynchFunc&& asynch_func, const std::chrono::microseconds& timeout)
+{
+    // Result is written to the waiting side only if it has not gone by timeout.
+    // Synchronization object is shared with asynchronous call
+    // because it could be executed after timeout
+    Result result = initial_result;
+    auto sync = wait_sync::acquire();
+
+    std::unique_lock<std::mutex> lck(sync->guard); //guard done and result variables
+
+    auto _asynch = [sync, presult = &result, func = typename std::decay<AsynchFunc>::type(std::forward<AsynchFunc>(asynch_func))]() mutable {
+        // not under lock to not block waiting with timeout
+        Result result = func();
+
+        std::lock_guard<std::mutex> lck(sync->guard);
+
+        if (!sync->abandoned)
+        {
+            *presult = std::move(result);
+            sync->done = true;
+            sync->done_cond.notify_one();
+        }
+    };
+
+    result = caller_func(std::move(_asynch));
+
+    auto done = [&sync]() {
+        return sync->done;
+    };
+
+    if (timeout.count() > 0)
+    {
+        if (!sync->done_cond.wait_for(lck, timeout, done))
+            sync->abandoned = true;
+    }
+    else
+    {
+        sync->done_cond.wait(lck, done); //internally unlock guard
     }
 
     return result;
 }
 
 template <typename Result, typename CallerFunc, typename AsynchFunc>
-Result wait_async_call(const Result initial_result, CallerFunc&& caller_func, AsynchFunc&& asynch_func, int32_t timeout_ms = -1)
+Result wait_preliminary_async_call(const Result initial_result, CallerFunc&& caller_func, AsynchFunc&& asynch_func, int32_t timeout_ms = -1)
+{
+    return wait_preliminary_async_call(initial_result, std::forward<CallerFunc>(caller_func), std::forward<AsynchFunc>(asynch_func),
+                                       std::chrono::microseconds(std::chrono::milliseconds(timeout_ms)));
+}
+
+template <typename Result, typename CallerFunc, typename AsynchFunc>
+Result wait_async_call(const Result initial_result, CallerFunc&& caller_func, AsynchFunc&& asynch_func, const std::chrono::microseconds& timeout)
 {
     // ignore preliminary check
     auto caller_func_wrapper = [&initial_result, &caller_func](auto asynch_func) -> Result {
-        caller_func(asynch_func);
+        caller_func(std::move(asynch_func));
         return initial_result;
     };
-    return wait_preliminary_async_call(initial_result, caller_func_wrapper, asynch_func, timeout_ms);
+    return wait_preliminary_async_call(initial_result, caller_func_wrapper, std::forward<AsynchFunc>(asynch_func), timeout);
+}
+
+template <typename Result, typename CallerFunc, typename AsynchFunc>
+Result wait_async_call(const Result initial_result, CallerFunc&& caller_func, AsynchFunc&& asynch_func, int32_t timeout_ms = -1)
+{
+    return wait_async_call(initial_result, std::forward<CallerFunc>(caller_func), std::forward<AsynchFunc>(asynch_func),
+                           std::chrono::microseconds(std::chrono::milliseconds(timeout_ms)));
 }
 
 } // namespace server_lib
@@ -4,9 +4,13 @@
 
 #include <boost/utility/in_place_factory.hpp>
 
+#include <algorithm>
+
 #if defined(SERVER_LIB_PLATFORM_LINUX)
 #include <pthread.h>
 #include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 #endif
 
 #ifdef SRV_LOG_CONTEXT_
@@ -21,13 +25,60 @@ namespace server_lib {
 static std::thread::id MAIN_THREAD_ID = std::this_thread::get_id();
 #endif
 
-event_loop::event_loop(bool in_separate_thread /*= true*/)
+namespace {
+    // maximum handlers from lock-free queue between io_service polls
+    constexpr size_t LOCKFREE_BATCH = 256;
+    // adaptive spinning bounds (in pause instructions)
+    constexpr size_t MIN_SPIN_LIMIT = 64;
+    constexpr size_t MAX_SPIN_LIMIT = 16 * 1024;
+
+    inline void cpu_relax()
+    {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_ia32_pause();
+#else
+        std::this_thread::yield();
+#endif
+    }
+} // namespace
+
+constexpr size_t event_loop::high_lane_weight;
+constexpr size_t event_loop::low_lane_weight;
+
+event_loop::event_loop(bool in_separate_thread /*= true*/, queue_type queue /*= queue_type::asio*/)
     : _run_in_separate_thread(in_separate_thread)
+    , _queue_type(queue)
     , _pservice(std::make_shared<boost::asio::io_service>())
     , _strand(*_pservice)
-    , _queue_size(0)
+    , _handler_memory(&boost::asio::use_service<handler_memory>(*_pservice))
     , _id(std::this_thread::get_id())
+    , _timers_driver(*_pservice)
+    , _metrics_enabled(false)
+    , _posts(0)
+    , _completions(0)
+    , _exceptions(0)
+    , _handler_started(0)
+    , _handler_seq(0)
+    , _watched(false)
+    , _stalls(0)
+    , _idle_spins(0)
+    , _wakeups(0)
+    , _high_watermark(0)
+    , _low_watermark(0)
+    , _overloaded(false)
+    , _rejected(0)
+    , _dropped(0)
+    , _draining(false)
+    , _drain_deadline(0)
+    , _drain_skipped(0)
+    , _bounded(false)
+    , _parked(false)
+    , _spin_limit(MIN_SPIN_LIMIT)
+    , _polling_budget(0)
 {
+    for (auto&& lane_size : _queue_size)
+        lane_size.store(0);
+
     if (_run_in_separate_thread)
     {
         SRV_LOGC_TRACE(SRV_FUNCTION_NAME_ << " in separate thread");
@@ -71,23 +122,48 @@ bool event_loop::is_main_loop()
 void event_loop::apply_thread_name()
 {
 #if defined(SERVER_LIB_PLATFORM_LINUX)
-    SRV_ASSERT(0 == pthread_setname_np(pthread_self(), _thread_name.c_str()));
+    auto name = thread_name();
+    SRV_ASSERT(0 == pthread_setname_np(pthread_self(), name.c_str()));
 #endif
 }
 
 void event_loop::change_thread_name(const std::string& name)
 {
     static int MAX_THREAD_NAME_SZ = 15;
-    if (name.length() > MAX_THREAD_NAME_SZ)
-        _thread_name = name.substr(0, MAX_THREAD_NAME_SZ);
-    else
-        _thread_name = name;
+    {
+        std::lock_guard<std::mutex> lck(_thread_guard);
+        if (name.length() > MAX_THREAD_NAME_SZ)
+            _thread_name = name.substr(0, MAX_THREAD_NAME_SZ);
+        else
+            _thread_name = name;
+    }
     if (_is_running.load())
     {
         apply_thread_name();
     }
 }
 
+std::string event_loop::thread_name() const
+{
+    std::lock_guard<std::mutex> lck(_thread_guard);
+    return _thread_name;
+}
+
+void event_loop::set_thread_options(const thread_options& options)
+{
+    if (_is_running.load())
+    {
+        post(priority::high, [this, options]() {
+            _thread_options = options;
+            apply_thread_options(_thread_options);
+        });
+    }
+    else
+    {
+        _thread_options = options;
+    }
+}
+
 void event_loop::start(std::function<void(void)> start_notify, std::function<void(void)> stop_notify)
 {
     if (is_running())
@@ -97,9 +173,36 @@ void event_loop::start(std::function<void(void)> start_notify, std::function<voi
 
     _is_main.store(is_main_loop());
 
+    // loop is restarted after 'stop'
+    if (_pservice->stopped())
+    {
+#if BOOST_VERSION >= 106600
+        _pservice->restart();
+#else
+        _pservice->reset();
+#endif
+    }
+
     _loop_maintainer = boost::in_place(std::ref(*_pservice));
+    _draining = false;
+
+#if defined(SERVER_LIB_PLATFORM_LINUX) && defined(BOOST_ASIO_HAS_POSIX_STREAM_DESCRIPTOR)
+    if (_queue_type == queue_type::lockfree && !_wakeup_descriptor)
+    {
+        int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (fd >= 0)
+        {
+            _wakeup_descriptor.reset(new boost::asio::posix::stream_descriptor(*_pservice, fd));
+            arm_wakeup();
+        }
+        else
+        {
+            SRV_LOGC_WARN("Can't create eventfd. Wakeup by io_service is used");
+        }
+    }
+#endif
 
-    post([this, start_notify]() {
+    post(priority::high, [this, start_notify]() {
         SRV_LOGC_TRACE("Event loop is started");
 
         _is_running.store(true);
@@ -156,10 +259,31 @@ void event_loop::stop()
     _thread.reset();
 
     _is_running.store(false);
+    _draining = false;
+
+    // drain step won't come if loop is stopped while draining.
+    // Handlers left in queue are dropped
+    complete_drain(queue_size());
+
+    // release blocked producers. Low watermark won't come,
+    // waiters are released without invocation
+    std::vector<std::function<void(void)>> waiters;
+    {
+        std::lock_guard<std::mutex> lck(_watermark_guard);
+        waiters.swap(_low_watermark_waiters);
+    }
+    _watermark_cond.notify_all();
 }
 
 void event_loop::run()
 {
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    {
+        std::lock_guard<std::mutex> lck(_thread_guard);
+        _native_thread = static_cast<unsigned long>(pthread_self());
+    }
+#endif
+
     int cloop = 0;
     for (;;)
     {
@@ -167,22 +291,652 @@ void event_loop::run()
 
         _id.store(std::this_thread::get_id());
         apply_thread_name();
+        apply_thread_options(_thread_options);
 
         try
         {
-            _pservice->run();
+            if (_queue_type == queue_type::lockfree)
+                run_lockfree();
+            else if (_polling_budget.load())
+                run_polling();
+            else
+                _pservice->run();
             break; // run() exited normally
         }
         catch (const std::exception& e)
         {
+            ++_exceptions;
+            watch_end();
             // Deal with exception as appropriate.
             SRV_LOGC_ERROR("Catched unexpected exception: " << e.what());
         }
         catch (...)
         {
+            ++_exceptions;
+            watch_end();
             SRV_LOGC_ERROR("Unknown exception catched");
         }
     }
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    // thread is not interrupted by watchdog since then
+    std::lock_guard<std::mutex> lck(_thread_guard);
+    _native_thread = 0;
+#endif
+}
+
+event_loop::metrics event_loop::get_metrics() const
+{
+    metrics result;
+    result.posts = _posts.load();
+    result.completions = _completions.load();
+    result.exceptions = _exceptions.load();
+    result.stalls = _stalls.load();
+    result.idle_spins = _idle_spins.load();
+    result.wakeups = _wakeups.load();
+    result.queue_size = queue_size();
+    result.queue_wait = _queue_wait.get_snapshot();
+    result.run_time = _run_time.get_snapshot();
+    return result;
+}
+
+void event_loop::reset_metrics()
+{
+    _posts = 0;
+    _completions = 0;
+    _exceptions = 0;
+    _stalls = 0;
+    _idle_spins = 0;
+    _wakeups = 0;
+    _queue_wait.reset();
+    _run_time.reset();
+}
+
+void event_loop::start_metrics_dump(const std::chrono::milliseconds& period)
+{
+    enable_metrics();
+
+    if (!_metrics_dump_timer)
+        _metrics_dump_timer.reset(new periodical_timer(*this));
+    _metrics_dump_timer->start(period, [this]() {
+        dump_metrics();
+    });
+}
+
+void event_loop::stop_metrics_dump()
+{
+    if (_metrics_dump_timer)
+        _metrics_dump_timer->stop();
+}
+
+void event_loop::on_handler_exception(const char* what)
+{
+    ++_exceptions;
+    if (what)
+    {
+        SRV_LOGC_ERROR("Catched unexpected exception: " << what);
+    }
+    else
+    {
+        SRV_LOGC_ERROR("Unknown exception catched");
+    }
+}
+
+void event_loop::dump_metrics()
+{
+    auto m = get_metrics();
+
+    auto us = [](const latency_histogram::duration& d) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+    };
+
+    SRV_LOGC_INFO("'" << thread_name() << "' metrics: posts = " << m.posts
+                      << ", completions = " << m.completions
+                      << ", exceptions = " << m.exceptions
+                      << ", stalls = " << m.stalls
+                      << ", idle spins = " << m.idle_spins
+                      << ", wakeups = " << m.wakeups
+                      << ", queue size = " << m.queue_size
+                      << "; queue wait (us) p50 = " << us(m.queue_wait.p50)
+                      << ", p99 = " << us(m.queue_wait.p99)
+                      << ", max = " << us(m.queue_wait.max)
+                      << "; run time (us) p50 = " << us(m.run_time.p50)
+                      << ", p99 = " << us(m.run_time.p99)
+                      << ", max = " << us(m.run_time.max));
+}
+
+bool event_loop::run_lane_one(const priority lane)
+{
+    auto* node = lane_queue(lane).pop();
+    if (!node)
+        return false;
+
+    queue_size_guard guard { *this, lane, 1 };
+
+    node->complete(node, true);
+    return true;
+}
+
+void event_loop::run_lane(const priority lane)
+{
+    // Every lane handler has own 'run_lane' call posted after it.
+    // If lane handler is not available yet (producer has not finished push)
+    // call is posted again
+    if (lane == priority::high)
+    {
+        for (size_t ci = 0; ci < high_lane_weight; ++ci)
+        {
+            if (!run_lane_one(priority::high))
+            {
+                if (queue_size(priority::high))
+                {
+                    post_impl([this]() {
+                        run_lane(priority::high);
+                    });
+                }
+                break;
+            }
+        }
+        return;
+    }
+
+    SRV_ASSERT(lane == priority::low);
+
+    bool give_way = queue_size(priority::normal) > 0
+                    && _normal_executed - _normal_executed_at_low < low_lane_weight;
+    if (give_way || !run_lane_one(priority::low))
+    {
+        post_impl([this]() {
+            run_lane(priority::low);
+        });
+        return;
+    }
+    _normal_executed_at_low = _normal_executed;
+}
+
+void event_loop::set_watermarks(const uint64_t high_watermark,
+                                const uint64_t low_watermark,
+                                const overflow_policy policy,
+                                watermark_callback_type callback)
+{
+    SRV_ASSERT(!high_watermark || low_watermark < high_watermark, "Low watermark should be less than high one");
+
+    _overflow_policy = policy;
+    _watermark_callback = callback;
+    _low_watermark.store(low_watermark);
+    _high_watermark.store(high_watermark);
+    _bounded.store(high_watermark && policy == overflow_policy::drop_oldest);
+
+    if (!high_watermark)
+        check_low_watermark();
+}
+
+void event_loop::on_low_watermark(std::function<void(void)> callback)
+{
+    SRV_ASSERT(callback);
+
+    {
+        std::lock_guard<std::mutex> lck(_watermark_guard);
+        if (_overloaded.load())
+        {
+            _low_watermark_waiters.emplace_back(std::move(callback));
+            return;
+        }
+    }
+    callback();
+}
+
+bool event_loop::admit(const uint64_t count)
+{
+    if (limited_queue_size() + count <= _high_watermark.load())
+        return true;
+
+    if (!_overloaded.exchange(true))
+    {
+        SRV_LOGC_WARN("Queue has reached high watermark " << _high_watermark.load());
+
+        if (_watermark_callback)
+            _watermark_callback(true);
+
+        // loop could have drained queue before flag was set
+        check_low_watermark();
+    }
+
+    switch (_overflow_policy)
+    {
+    case overflow_policy::block:
+        if (!is_this_loop() && is_running())
+        {
+            std::unique_lock<std::mutex> lck(_watermark_guard);
+            _watermark_cond.wait(lck, [this]() {
+                return !_overloaded.load() || !is_running();
+            });
+        }
+        break;
+    case overflow_policy::reject:
+        _rejected += count;
+        return false;
+    case overflow_policy::drop_oldest:
+        if (!make_room(count))
+        {
+            _rejected += count;
+            return false;
+        }
+        break;
+    case overflow_policy::signal:
+        break;
+    }
+    return true;
+}
+
+bool event_loop::admit_draining()
+{
+    // queued handlers could continue their work
+    if (is_this_loop())
+        return true;
+
+    ++_rejected;
+    return false;
+}
+
+uint64_t event_loop::drain(const std::chrono::milliseconds& timeout)
+{
+    if (!is_running())
+        return 0;
+
+    SRV_LOGC_INFO(SRV_FUNCTION_NAME_ << " with timeout " << timeout.count() << " ms");
+
+    bool in_loop = is_this_loop();
+
+    SRV_ASSERT(!in_loop || !_run_in_separate_thread, "Loop with own thread can't be drained from itself");
+
+    promise<uint64_t> dropped(*this);
+    auto result = dropped.get_future();
+    {
+        std::lock_guard<std::mutex> lck(_drain_guard);
+        _drain_result = std::move(dropped);
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    _drain_deadline = deadline.time_since_epoch().count();
+    _drain_skipped = 0;
+    _draining = true;
+
+    // drain step is queued behind all posted handlers
+    // and it is not counted as handler
+    post_impl([this]() {
+        drain_step();
+    });
+
+    if (in_loop)
+        return 0;
+
+    uint64_t result_ = 0;
+    try
+    {
+        result_ = result.get();
+    }
+    catch (const std::future_error&)
+    {
+        // the other drain has taken result over
+        result_ = queue_size();
+    }
+    if (_run_in_separate_thread)
+        stop();
+    return result_;
+}
+
+void event_loop::drain_step()
+{
+    auto queued = queue_size();
+    if (queued > 0 && std::chrono::steady_clock::now().time_since_epoch().count() < _drain_deadline.load())
+    {
+        // it gives way to handlers that were queued after previous step
+        post_impl([this]() {
+            drain_step();
+        });
+        return;
+    }
+
+    queued += _drain_skipped.load();
+    if (queued > 0)
+    {
+        SRV_LOGC_WARN("Drain timeout. " << queued << " handlers are dropped");
+    }
+    else
+    {
+        SRV_LOGC_TRACE("Loop is drained");
+    }
+
+    if (_run_in_separate_thread)
+    {
+        // waiting thread joins loop thread
+        _loop_maintainer = boost::none;
+        _pservice->stop();
+        complete_drain(queued);
+    }
+    else
+    {
+        complete_drain(queued);
+        stop();
+    }
+}
+
+void event_loop::complete_drain(const uint64_t dropped)
+{
+    boost::optional<promise<uint64_t>> result;
+    {
+        std::lock_guard<std::mutex> lck(_drain_guard);
+        result.swap(_drain_result);
+    }
+    if (result)
+        result->set_value(dropped);
+}
+
+bool event_loop::make_room(const uint64_t count)
+{
+    // handlers are destroyed out of lock
+    std::vector<small_handler> dropped;
+    bool result = false;
+    {
+        std::lock_guard<std::mutex> lck(_bounded_guard);
+
+        auto it = _bounded_queue.begin();
+        while (limited_queue_size() + count > _high_watermark.load())
+        {
+            it = std::find_if(it, _bounded_queue.end(), [](const bounded_handler& item) {
+                return item.droppable;
+            });
+            if (it == _bounded_queue.end())
+                break;
+
+            dropped.emplace_back(std::move(it->handler));
+            it = _bounded_queue.erase(it);
+            std::atomic_fetch_sub<uint64_t>(&lane_queue_size(priority::normal), 1);
+            ++_dropped;
+        }
+        result = limited_queue_size() + count <= _high_watermark.load();
+    }
+    return result;
+}
+
+void event_loop::push_bounded(small_handler&& handler, const bool droppable)
+{
+    bool schedule = false;
+    {
+        std::lock_guard<std::mutex> lck(_bounded_guard);
+        _bounded_queue.push_back({ std::move(handler), droppable });
+        schedule = !_bounded_scheduled;
+        _bounded_scheduled = true;
+    }
+    if (schedule)
+    {
+        post_impl([this]() {
+            run_bounded();
+        });
+    }
+}
+
+void event_loop::push_bounded(std::vector<small_handler>&& handlers)
+{
+    bool schedule = false;
+    {
+        std::lock_guard<std::mutex> lck(_bounded_guard);
+        for (auto&& handler : handlers)
+            _bounded_queue.push_back({ std::move(handler), true });
+        schedule = !_bounded_scheduled;
+        _bounded_scheduled = true;
+    }
+    if (schedule)
+    {
+        post_impl([this]() {
+            run_bounded();
+        });
+    }
+}
+
+void event_loop::run_bounded()
+{
+    small_handler handler;
+    bool more = false;
+    {
+        std::lock_guard<std::mutex> lck(_bounded_guard);
+        if (!_bounded_queue.empty())
+        {
+            handler = std::move(_bounded_queue.front().handler);
+            _bounded_queue.pop_front();
+        }
+        more = !_bounded_queue.empty();
+        _bounded_scheduled = more;
+    }
+
+    // next call is queued before handler that could throw.
+    // It gives way to handlers queued in io_service meanwhile
+    if (more)
+    {
+        post_impl([this]() {
+            run_bounded();
+        });
+    }
+
+    if (handler)
+        handler();
+}
+
+void event_loop::check_low_watermark()
+{
+    if (_high_watermark.load() && limited_queue_size() > _low_watermark.load())
+        return;
+
+    if (!_overloaded.exchange(false))
+        return;
+
+    SRV_LOGC_TRACE("Queue is back to low watermark");
+
+    std::vector<std::function<void(void)>> waiters;
+    {
+        std::lock_guard<std::mutex> lck(_watermark_guard);
+        waiters.swap(_low_watermark_waiters);
+    }
+    _watermark_cond.notify_all();
+
+    if (_watermark_callback)
+        _watermark_callback(false);
+
+    for (auto&& waiter : waiters)
+        waiter();
+}
+
+void event_loop::check_low_watermark_nothrow()
+{
+    try
+    {
+        check_low_watermark();
+    }
+    catch (const std::exception& e)
+    {
+        ++_exceptions;
+        SRV_LOGC_ERROR("Catched exception in low watermark callback: " << e.what());
+    }
+    catch (...)
+    {
+        ++_exceptions;
+        SRV_LOGC_ERROR("Unknown exception catched in low watermark callback");
+    }
+}
+
+timer_wheel::handle event_loop::add_timer(const std::chrono::milliseconds& delay, small_handler&& callback)
+{
+    bool earliest = false;
+    auto result = _timers.add(delay, std::move(callback), earliest);
+    if (earliest)
+    {
+        // driver is touched in loop thread only
+        if (is_this_loop())
+            arm_timers();
+        else
+            _pservice->post(_strand.wrap(make_alloc_handler(*_handler_memory, [this]() {
+                arm_timers();
+            })));
+    }
+    return result;
+}
+
+void event_loop::arm_timers()
+{
+    auto next = _timers.next_expiry();
+    if (next == timer_wheel::no_expiry)
+    {
+        _timers_driver.cancel();
+        return;
+    }
+
+    _timers_driver.expires_at(_timers.to_time_point(next));
+    _timers_driver.async_wait(_strand.wrap(make_alloc_handler(*_handler_memory, [this](const boost::system::error_code& ec) {
+        if (!ec)
+            on_timers();
+    })));
+}
+
+void event_loop::on_timers()
+{
+    _expired_timers.clear();
+    _timers.advance(_timers.to_tick(timer_wheel::clock::now()), _expired_timers);
+
+    arm_timers();
+
+    bool watched = _watched.load(std::memory_order_relaxed);
+    if (watched)
+        watch_begin(metrics_clock::now());
+    // timer that throws doesn't cancel others of this tick
+    for (auto&& callback : _expired_timers)
+    {
+        run_caught(callback);
+    }
+    if (watched)
+        watch_end();
+    _expired_timers.clear();
+}
+
+void event_loop::run_lockfree()
+{
+    // fixed spin limit in polling mode
+    const size_t polling_budget = _polling_budget.load();
+    if (polling_budget)
+        _spin_limit = polling_budget;
+
+    size_t spins = 0;
+    while (!_pservice->stopped())
+    {
+        size_t executed = 0;
+        while (executed < LOCKFREE_BATCH)
+        {
+            auto* node = _lockfree_queue.pop();
+            if (!node)
+                break;
+            ++executed;
+            node->complete(node, true);
+        }
+
+        // timers and other io_service handlers
+        executed += _pservice->poll();
+
+        if (executed)
+        {
+            if (spins > 0)
+            {
+                _idle_spins.fetch_add(spins, std::memory_order_relaxed);
+                // work came while spinning, so spinning pays off
+                if (!polling_budget)
+                    _spin_limit = std::min(_spin_limit * 2, MAX_SPIN_LIMIT);
+            }
+            spins = 0;
+            continue;
+        }
+
+        if (spins < _spin_limit)
+        {
+            ++spins;
+            cpu_relax();
+            continue;
+        }
+
+        _idle_spins.fetch_add(spins, std::memory_order_relaxed);
+        _wakeups.fetch_add(1, std::memory_order_relaxed);
+        if (!polling_budget)
+            _spin_limit = std::max(_spin_limit / 2, MIN_SPIN_LIMIT);
+        spins = 0;
+
+        // park until wakeup, timer or stop
+        _parked.store(true, std::memory_order_relaxed);
+        // pairs with fence in 'post_impl' after push
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_lockfree_queue.empty())
+            _pservice->run_one();
+        _parked.store(false, std::memory_order_relaxed);
+    }
+}
+
+void event_loop::run_polling()
+{
+    const size_t budget = _polling_budget.load();
+
+    // counters are updated in batch to not pay for atomic on every spin
+    size_t spins = 0;
+    while (!_pservice->stopped())
+    {
+        if (_pservice->poll())
+        {
+            if (spins > 0)
+                _idle_spins.fetch_add(spins, std::memory_order_relaxed);
+            spins = 0;
+            continue;
+        }
+
+        if (spins < budget)
+        {
+            ++spins;
+            cpu_relax();
+            continue;
+        }
+
+        _idle_spins.fetch_add(spins, std::memory_order_relaxed);
+        _wakeups.fetch_add(1, std::memory_order_relaxed);
+        spins = 0;
+
+        // block until any handler
+        _pservice->run_one();
+    }
+}
+
+void event_loop::wakeup()
+{
+    if (!_parked.exchange(false))
+        return; // someone has already woken up the loop
+
+#if defined(SERVER_LIB_PLATFORM_LINUX) && defined(BOOST_ASIO_HAS_POSIX_STREAM_DESCRIPTOR)
+    if (_wakeup_descriptor)
+    {
+        uint64_t value = 1;
+        if (::write(_wakeup_descriptor->native_handle(), &value, sizeof(value)) == sizeof(value))
+            return;
+    }
+#endif
+    _pservice->post([]() {});
+}
+
+void event_loop::arm_wakeup()
+{
+#if defined(BOOST_ASIO_HAS_POSIX_STREAM_DESCRIPTOR)
+    if (!_wakeup_descriptor)
+        return;
+
+    _wakeup_descriptor->async_read_some(boost::asio::buffer(&_wakeup_value, sizeof(_wakeup_value)),
+                                        make_alloc_handler(*_handler_memory, [this](const boost::system::error_code& ec, size_t) {
+                                            if (!ec)
+                                                arm_wakeup();
+                                        }));
+#endif
 }
 
 main_loop::main_loop(const std::string& name)
@@ -206,7 +960,7 @@ void main_loop::exit(const int exit_code)
 #endif
     if (is_running())
     {
-        post([this, exit_code]() {
+        post(priority::high, [this, exit_code]() {
 #ifndef NDEBUG
             fprintf(stderr, "Exit main loop with code %d\n", exit_code);
 #endif
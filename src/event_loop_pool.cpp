@@ -0,0 +1,289 @@
+#include <server_lib/event_loop_pool.h>
+#include <server_lib/logging_helper.h>
+#include <server_lib/asserts.h>
+
+#include <thread>
+
+#ifdef SRV_LOG_CONTEXT_
+#undef SRV_LOG_CONTEXT_
+#endif // #ifdef SRV_LOG_CONTEXT_
+
+#define SRV_LOG_CONTEXT_ "elp> "
+
+namespace server_lib {
+
+event_loop_pool::event_loop_pool(const size_t nb_loops, const balance_policy policy)
+    : _policy(policy)
+    , _next(0)
+    , _stolen(0)
+{
+    size_t nb_loops_ = nb_loops;
+    if (!nb_loops_)
+        nb_loops_ = std::max(1u, std::thread::hardware_concurrency());
+
+    _workers.reserve(nb_loops_);
+    for (size_t ci = 0; ci < nb_loops_; ++ci)
+    {
+        _workers.emplace_back(new worker);
+    }
+
+    change_thread_name("io_pool");
+
+    SRV_LOGC_TRACE(SRV_FUNCTION_NAME_ << " for " << nb_loops_ << " loops");
+}
+
+event_loop_pool::~event_loop_pool()
+{
+    SRV_LOGC_TRACE(SRV_FUNCTION_NAME_);
+
+    stop();
+}
+
+event_loop& event_loop_pool::loop(const size_t index)
+{
+    SRV_ASSERT(index < _workers.size());
+
+    return _workers[index]->loop;
+}
+
+event_loop& event_loop_pool::next_loop()
+{
+    return loop(next_index());
+}
+
+uint64_t event_loop_pool::queue_size() const
+{
+    uint64_t result = 0;
+    for (auto&& w : _workers)
+        result += w->loop.queue_size();
+    return result;
+}
+
+void event_loop_pool::change_thread_name(const std::string& name)
+{
+    for (size_t ci = 0; ci < _workers.size(); ++ci)
+    {
+        _workers[ci]->loop.change_thread_name(name + std::to_string(ci));
+    }
+}
+
+void event_loop_pool::start(std::function<void(void)> start_notify, std::function<void(void)> stop_notify)
+{
+    if (is_running())
+        return;
+
+    SRV_LOGC_INFO(SRV_FUNCTION_NAME_);
+
+    auto started = std::make_shared<std::atomic_size_t>(0);
+    auto stopped = std::make_shared<std::atomic_size_t>(0);
+    auto total = _workers.size();
+
+    for (auto&& w : _workers)
+    {
+        w->loop.start(
+            [started, total, start_notify]() {
+                if (++(*started) == total && start_notify)
+                    start_notify();
+            },
+            [stopped, total, stop_notify]() {
+                if (++(*stopped) == total && stop_notify)
+                    stop_notify();
+            });
+    }
+}
+
+void event_loop_pool::stop()
+{
+    SRV_LOGC_INFO(SRV_FUNCTION_NAME_);
+
+    for (auto&& w : _workers)
+    {
+        w->loop.stop();
+
+        std::lock_guard<std::mutex> lck(w->tasks_guard);
+        w->tasks.clear();
+        w->pending = 0;
+        w->stealing = false;
+    }
+}
+
+bool event_loop_pool::is_running() const
+{
+    for (auto&& w : _workers)
+    {
+        if (w->loop.is_running())
+            return true;
+    }
+    return false;
+}
+
+size_t event_loop_pool::next_index()
+{
+    if (_policy == balance_policy::least_loaded)
+    {
+        size_t result = 0;
+        auto min_load = _workers[0]->loop.queue_size();
+        for (size_t ci = 1; ci < _workers.size() && min_load > 0; ++ci)
+        {
+            auto load = _workers[ci]->loop.queue_size();
+            if (load < min_load)
+            {
+                min_load = load;
+                result = ci;
+            }
+        }
+        return result;
+    }
+
+    return _next++ % _workers.size();
+}
+
+bool event_loop_pool::post_task(const size_t index, small_handler& task)
+{
+    auto& w = *_workers[index];
+    uint64_t pending = 0;
+    {
+        std::lock_guard<std::mutex> lck(w.tasks_guard);
+        w.tasks.emplace_back(std::move(task));
+        pending = ++w.pending;
+    }
+    // task must not be lost with 'run_one' call by 'drop_oldest' policy
+    if (w.loop.post_undroppable([this, index]() {
+            run_one(index);
+        }))
+    {
+        // tasks are queued in loop, idle one could help
+        if (pending > 1)
+            wake_thief(index);
+        return true;
+    }
+
+    // Roll back. Tasks are not ordered, so any queued task is taken
+    // to keep single task per 'run_one' call
+    std::lock_guard<std::mutex> lck(w.tasks_guard);
+    if (!w.tasks.empty())
+    {
+        task = std::move(w.tasks.back());
+        w.tasks.pop_back();
+        --w.pending;
+    }
+    return false;
+}
+
+void event_loop_pool::run_one(const size_t index)
+{
+    small_handler task;
+
+    // Every 'post' adds single task and single 'run_one' call.
+    // Thus task is executed either by own loop or by the thief
+    // that found it first (idle loops are woken to steal by 'post').
+    // If it was stolen 'run_one' helps other loops or does nothing
+    auto& w = *_workers[index];
+    if (pop_own(w, task) || steal(index, task))
+    {
+        task();
+    }
+
+    // own queue is empty, loop looks for work of others
+    if (!w.pending.load() && !w.stealing.exchange(true))
+        schedule_steal(index);
+}
+
+void event_loop_pool::wake_thief(const size_t victim_index)
+{
+    // the first idle loop that doesn't steal yet
+    for (size_t ci = 0; ci < _workers.size(); ++ci)
+    {
+        if (ci == victim_index)
+            continue;
+
+        auto& w = *_workers[ci];
+        if (w.pending.load() || w.stealing.exchange(true))
+            continue;
+
+        if (schedule_steal(ci))
+            return;
+    }
+}
+
+bool event_loop_pool::schedule_steal(const size_t index)
+{
+    auto& w = *_workers[index];
+    // 'stealing' flag is reset by 'run_steal' only,
+    // so it must not be lost by 'drop_oldest' policy
+    if (w.loop.post_undroppable([this, index]() {
+            run_steal(index);
+        }))
+        return true;
+
+    w.stealing = false;
+    return false;
+}
+
+void event_loop_pool::run_steal(const size_t index)
+{
+    auto& w = *_workers[index];
+    small_handler task;
+
+    // Idle loop steals while there are queued tasks in other loops.
+    // Own tasks go first, so the next attempt is posted after them
+    if (!w.pending.load() && steal(index, task))
+    {
+        task();
+
+        schedule_steal(index);
+        return;
+    }
+
+    w.stealing = false;
+}
+
+bool event_loop_pool::pop_own(worker& w, small_handler& task)
+{
+    if (!w.pending.load())
+        return false;
+
+    std::lock_guard<std::mutex> lck(w.tasks_guard);
+    if (w.tasks.empty())
+        return false;
+
+    task = std::move(w.tasks.front());
+    w.tasks.pop_front();
+    --w.pending;
+    return true;
+}
+
+bool event_loop_pool::steal(const size_t thief_index, small_handler& task)
+{
+    // victim is the most overloaded loop
+    worker* victim = nullptr;
+    uint64_t max_pending = 0;
+    for (size_t ci = 0; ci < _workers.size(); ++ci)
+    {
+        if (ci == thief_index)
+            continue;
+
+        auto pending = _workers[ci]->pending.load();
+        if (pending > max_pending)
+        {
+            max_pending = pending;
+            victim = _workers[ci].get();
+        }
+    }
+
+    if (!victim)
+        return false;
+
+    std::lock_guard<std::mutex> lck(victim->tasks_guard);
+    if (victim->tasks.empty())
+        return false;
+
+    // the owner takes the oldest task, the thief takes the newest one
+    task = std::move(victim->tasks.back());
+    victim->tasks.pop_back();
+    --victim->pending;
+    ++_stolen;
+    return true;
+}
+
+} // namespace server_lib
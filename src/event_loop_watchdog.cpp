@@ -0,0 +1,341 @@
+#include <server_lib/event_loop_watchdog.h>
+#include <server_lib/platform_config.h>
+#include <server_lib/emergency_helper.h>
+#include <server_lib/logging_helper.h>
+#include <server_lib/asserts.h>
+
+#include <boost/filesystem.hpp>
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+#ifdef SRV_LOG_CONTEXT_
+#undef SRV_LOG_CONTEXT_
+#endif // #ifdef SRV_LOG_CONTEXT_
+
+#define SRV_LOG_CONTEXT_ "watchdog> "
+
+namespace server_lib {
+
+#if defined(SERVER_LIB_PLATFORM_LINUX) && !defined(STACKTRACE_DISABLED)
+#define SERVER_LIB_WATCHDOG_STACK_CAPTURE
+
+namespace {
+    // dump is requested for single thread at a time
+    char g_dump_file_path[PATH_MAX] = { 0 };
+    std::atomic_bool g_dump_done(false);
+    std::mutex g_dump_guard;
+    std::once_flag g_signal_handler_installed;
+
+    int watchdog_signal()
+    {
+        return SIGRTMIN + 3;
+    }
+
+    void on_watchdog_signal(int)
+    {
+        emergency_helper::save_dump(g_dump_file_path);
+        g_dump_done.store(true);
+    }
+
+    void install_signal_handler()
+    {
+        std::call_once(g_signal_handler_installed, []() {
+            struct sigaction action;
+            std::memset(&action, 0, sizeof(action));
+            action.sa_handler = on_watchdog_signal;
+            action.sa_flags = SA_RESTART;
+            sigemptyset(&action.sa_mask);
+            sigaction(watchdog_signal(), &action, nullptr);
+        });
+    }
+} // namespace
+#endif
+
+event_loop_watchdog::event_loop_watchdog(const std::chrono::milliseconds& threshold, const bool capture_stack)
+    : _threshold(threshold)
+    , _capture_stack(capture_stack)
+    , _stalls(0)
+{
+    SRV_ASSERT(_threshold.count() > 0);
+
+    try
+    {
+        _dump_directory = boost::filesystem::temp_directory_path().string();
+    }
+    catch (const std::exception&)
+    {
+        _dump_directory = ".";
+    }
+}
+
+event_loop_watchdog::~event_loop_watchdog()
+{
+    stop();
+
+    std::lock_guard<std::mutex> lck(_guard);
+    for (auto&& w : _loops)
+        w->loop->_watched = false;
+}
+
+void event_loop_watchdog::watch(event_loop& loop)
+{
+    std::lock_guard<std::mutex> lck(_guard);
+
+    for (auto&& w : _loops)
+    {
+        if (w->loop == &loop)
+            return;
+    }
+
+    auto w = std::make_shared<watched_loop>();
+    w->loop = &loop;
+    w->reported_seq = loop._handler_seq.load();
+    _loops.emplace_back(w);
+    loop._watched = true;
+
+#if defined(SERVER_LIB_WATCHDOG_STACK_CAPTURE)
+    if (_capture_stack)
+    {
+        install_signal_handler();
+        accept_signal(w);
+    }
+#endif
+}
+
+void event_loop_watchdog::accept_signal(const watched_loop_ptr& w)
+{
+#if defined(SERVER_LIB_WATCHDOG_STACK_CAPTURE)
+    w->loop->post(event_loop::priority::high, [w]() {
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigaddset(&mask, watchdog_signal());
+        pthread_sigmask(SIG_UNBLOCK, &mask, nullptr);
+
+        w->native_thread.store(static_cast<unsigned long>(pthread_self()), std::memory_order_release);
+    });
+#else
+    (void)w;
+#endif
+}
+
+void event_loop_watchdog::unwatch(event_loop& loop)
+{
+    // loop could be destroyed after 'unwatch' thus
+    // its thread is not interrupted since then
+    std::lock_guard<std::mutex> capture_lck(_capture_guard);
+    std::lock_guard<std::mutex> lck(_guard);
+
+    _loops.remove_if([&loop](const watched_loop_ptr& w) {
+        if (w->loop != &loop)
+            return false;
+        w->active = false;
+        return true;
+    });
+    loop._watched = false;
+    loop.watch_end();
+}
+
+void event_loop_watchdog::set_stall_callback(stall_callback_type callback)
+{
+    std::lock_guard<std::mutex> lck(_guard);
+
+    _stall_callback = callback;
+}
+
+void event_loop_watchdog::set_dump_directory(const std::string& dump_directory)
+{
+    std::lock_guard<std::mutex> lck(_guard);
+
+    _dump_directory = dump_directory;
+}
+
+void event_loop_watchdog::start()
+{
+    if (is_running())
+        return;
+
+    SRV_LOGC_INFO(SRV_FUNCTION_NAME_ << " with threshold " << _threshold.count() << " ms");
+
+    {
+        std::lock_guard<std::mutex> lck(_guard);
+        _stop = false;
+    }
+    _thread = std::thread([this]() { run(); });
+}
+
+void event_loop_watchdog::stop()
+{
+    if (!is_running())
+        return;
+
+    SRV_LOGC_INFO(SRV_FUNCTION_NAME_);
+
+    {
+        std::lock_guard<std::mutex> lck(_guard);
+        _stop = true;
+    }
+    _stop_condition.notify_all();
+
+    _thread.join();
+}
+
+bool event_loop_watchdog::is_running() const
+{
+    return _thread.joinable();
+}
+
+uint64_t event_loop_watchdog::stalls() const
+{
+    return _stalls.load();
+}
+
+void event_loop_watchdog::run()
+{
+    // stall is detected with delay no more than quarter of threshold
+    auto period = std::max(_threshold / 4, std::chrono::milliseconds(1));
+
+    std::unique_lock<std::mutex> lck(_guard);
+    while (!_stop)
+    {
+        if (_stop_condition.wait_for(lck, period, [this]() { return _stop; }))
+            break;
+
+        auto now = event_loop::metrics_clock::now();
+        std::vector<stall> stalls;
+        for (auto&& w : _loops)
+        {
+            stall s;
+            if (check(*w, now, s))
+            {
+                s.w = w;
+                stalls.emplace_back(std::move(s));
+            }
+        }
+
+        if (stalls.empty())
+            continue;
+
+        // stack capture and callback are slow
+        lck.unlock();
+        for (auto&& s : stalls)
+            report(s);
+        lck.lock();
+    }
+}
+
+bool event_loop_watchdog::check(watched_loop& w, const event_loop::metrics_clock::time_point& now, stall& s)
+{
+    auto& loop = *w.loop;
+
+    auto seq = loop._handler_seq.load(std::memory_order_acquire);
+    auto started = loop._handler_started.load(std::memory_order_acquire);
+    if (!started || seq == w.reported_seq)
+        return false;
+
+    auto stalled = std::chrono::duration_cast<std::chrono::milliseconds>(now - event_loop::metrics_clock::time_point(event_loop::metrics_clock::duration(started)));
+    if (stalled < _threshold)
+        return false;
+
+    // stall is reported once per handler
+    w.reported_seq = seq;
+    ++loop._stalls;
+    ++_stalls;
+
+    s.loop_name = loop.thread_name();
+    s.loop_tid = loop._tid;
+    s.stalled = stalled;
+    return true;
+}
+
+void event_loop_watchdog::report(const stall& s)
+{
+    SRV_LOGC_WARN("Loop '" << s.loop_name << "' (" << s.loop_tid << ") is stuck in handler for " << s.stalled.count() << " ms");
+
+    std::string stack;
+    if (_capture_stack)
+    {
+        stack = capture_stack(s);
+        if (!stack.empty())
+            SRV_LOGC_WARN("Loop '" << s.loop_name << "' stack:\n"
+                                   << stack);
+    }
+
+    stall_callback_type callback;
+    {
+        std::lock_guard<std::mutex> lck(_guard);
+        callback = _stall_callback;
+    }
+
+    if (callback)
+        callback(s.loop_name, s.stalled, stack);
+}
+
+std::string event_loop_watchdog::capture_stack(const stall& s)
+{
+#if defined(SERVER_LIB_WATCHDOG_STACK_CAPTURE)
+    std::string dump_directory;
+    {
+        std::lock_guard<std::mutex> lck(_guard);
+        dump_directory = _dump_directory;
+    }
+
+    auto path = (boost::filesystem::path(dump_directory) / ("stall_" + std::to_string(s.loop_tid) + ".dump")).string();
+    if (path.size() >= sizeof(g_dump_file_path))
+        return {};
+
+    // loop thread is alive while loop is watched
+    std::lock_guard<std::mutex> capture_lck(_capture_guard);
+    if (!s.w->active)
+        return {};
+
+    // dump file is global for signal handler
+    std::lock_guard<std::mutex> dump_lck(g_dump_guard);
+
+    std::strncpy(g_dump_file_path, path.c_str(), sizeof(g_dump_file_path) - 1);
+
+    g_dump_done = false;
+    {
+        // loop thread doesn't exit while it is interrupted
+        auto& loop = *s.w->loop;
+        std::lock_guard<std::mutex> thread_lck(loop._thread_guard);
+
+        auto native_thread = loop._native_thread;
+        if (!native_thread)
+            return {};
+
+        if (native_thread != s.w->native_thread.load(std::memory_order_acquire))
+        {
+            // loop has been restarted in new thread
+            accept_signal(s.w);
+            return {};
+        }
+
+        if (pthread_kill(static_cast<pthread_t>(native_thread), watchdog_signal()) != 0)
+            return {};
+    }
+
+    for (size_t ci = 0; ci < 100 && !g_dump_done; ++ci)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    if (!g_dump_done)
+    {
+        SRV_LOGC_WARN("Can't capture stack of stuck loop");
+        return {};
+    }
+
+    return emergency_helper::load_dump(g_dump_file_path, true);
+#else
+    (void)s;
+    return {};
+#endif
+}
+
+} // namespace server_lib
@@ -0,0 +1,12 @@
+#include <server_lib/handler_allocator.h>
+
+namespace server_lib {
+
+boost::asio::io_service::id handler_memory::id;
+
+constexpr size_t handler_memory::min_block_size;
+constexpr size_t handler_memory::size_classes;
+constexpr size_t handler_memory::max_block_size;
+constexpr size_t handler_memory::max_free_blocks;
+
+} // namespace server_lib
@@ -0,0 +1,133 @@
+#include <server_lib/latency_histogram.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace server_lib {
+
+constexpr size_t latency_histogram::sub_bucket_bits;
+constexpr size_t latency_histogram::sub_buckets;
+constexpr size_t latency_histogram::buckets;
+
+namespace {
+    size_t highest_bit(uint64_t value)
+    {
+#if defined(__GNUC__)
+        return 63 - static_cast<size_t>(__builtin_clzll(value));
+#else
+        size_t result = 0;
+        while (value >>= 1)
+            ++result;
+        return result;
+#endif
+    }
+} // namespace
+
+latency_histogram::latency_histogram()
+{
+    reset();
+}
+
+size_t latency_histogram::bucket_index(const uint64_t value)
+{
+    if (value < sub_buckets)
+        return static_cast<size_t>(value);
+
+    auto exponent = highest_bit(value);
+    auto sub_bucket = static_cast<size_t>(value >> (exponent - sub_bucket_bits)) & (sub_buckets - 1);
+    return (exponent - sub_bucket_bits + 1) * sub_buckets + sub_bucket;
+}
+
+uint64_t latency_histogram::bucket_upper_bound(const size_t index)
+{
+    if (index < sub_buckets)
+        return index;
+
+    auto exponent = index / sub_buckets + sub_bucket_bits - 1;
+    auto sub_bucket = index % sub_buckets;
+    auto shift = exponent - sub_bucket_bits;
+    auto lower = (uint64_t(sub_buckets + sub_bucket)) << shift;
+    auto width = uint64_t(1) << shift;
+    if (lower > std::numeric_limits<uint64_t>::max() - width)
+        return std::numeric_limits<uint64_t>::max();
+    return lower + width - 1;
+}
+
+void latency_histogram::record(const duration& value)
+{
+    auto v = static_cast<uint64_t>(std::max<int64_t>(value.count(), 0));
+
+    _buckets[bucket_index(v)].fetch_add(1, std::memory_order_relaxed);
+    _count.fetch_add(1, std::memory_order_relaxed);
+    _sum.fetch_add(v, std::memory_order_relaxed);
+
+    // single writer
+    if (v > _max.load(std::memory_order_relaxed))
+        _max.store(v, std::memory_order_relaxed);
+}
+
+latency_histogram::duration latency_histogram::percentile(const double q) const
+{
+    std::array<uint64_t, buckets> counts;
+    uint64_t total = 0;
+    for (size_t ci = 0; ci < buckets; ++ci)
+    {
+        counts[ci] = _buckets[ci].load(std::memory_order_relaxed);
+        total += counts[ci];
+    }
+    return duration(static_cast<int64_t>(percentile(q, counts, total)));
+}
+
+latency_histogram::snapshot latency_histogram::get_snapshot() const
+{
+    std::array<uint64_t, buckets> counts;
+    uint64_t total = 0;
+    for (size_t ci = 0; ci < buckets; ++ci)
+    {
+        counts[ci] = _buckets[ci].load(std::memory_order_relaxed);
+        total += counts[ci];
+    }
+
+    snapshot result;
+    result.count = total;
+    if (!total)
+        return result;
+
+    result.mean = duration(static_cast<int64_t>(_sum.load(std::memory_order_relaxed) / total));
+    result.p50 = duration(static_cast<int64_t>(percentile(0.5, counts, total)));
+    result.p90 = duration(static_cast<int64_t>(percentile(0.9, counts, total)));
+    result.p99 = duration(static_cast<int64_t>(percentile(0.99, counts, total)));
+    result.p999 = duration(static_cast<int64_t>(percentile(0.999, counts, total)));
+    result.max = duration(static_cast<int64_t>(_max.load(std::memory_order_relaxed)));
+    return result;
+}
+
+void latency_histogram::reset()
+{
+    for (auto&& bucket : _buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    _count.store(0, std::memory_order_relaxed);
+    _sum.store(0, std::memory_order_relaxed);
+    _max.store(0, std::memory_order_relaxed);
+}
+
+uint64_t latency_histogram::percentile(const double q, const std::array<uint64_t, buckets>& counts, const uint64_t total) const
+{
+    if (!total)
+        return 0;
+
+    auto rank = static_cast<uint64_t>(std::ceil(std::min(std::max(q, 0.0), 1.0) * static_cast<double>(total)));
+    rank = std::max<uint64_t>(rank, 1);
+
+    uint64_t accumulated = 0;
+    for (size_t ci = 0; ci < buckets; ++ci)
+    {
+        accumulated += counts[ci];
+        if (accumulated >= rank)
+            return std::min(bucket_upper_bound(ci), _max.load(std::memory_order_relaxed));
+    }
+    return _max.load(std::memory_order_relaxed);
+}
+
+} // namespace server_lib
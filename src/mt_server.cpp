@@ -118,6 +118,21 @@ public:
         e.stop();
     }
 
+    void drain(main_loop& e)
+    {
+        SRV_ASSERT(e.is_main(), "Only main loop accepted");
+
+        if (_drain_timeout.count() > 0)
+            e.drain(_drain_timeout);
+        else
+            e.stop();
+    }
+
+    void set_drain_timeout(const std::chrono::milliseconds& timeout)
+    {
+        _drain_timeout = timeout;
+    }
+
     void wait_started(main_loop& e, std::function<void(void)>&& start_notify)
     {
         SRV_ASSERT(e.is_main(), "Only main loop accepted");
@@ -149,7 +164,7 @@ protected:
                 }
                 else
                 {
-                    _e->post([exit_callback]() {
+                    _e->post(event_loop::priority::high, [exit_callback]() {
                         exit_callback();
                     });
                 }
@@ -227,7 +242,7 @@ protected:
                 else
                 {
                     // pointer dump_file_path should be stay valid in main thread because was created from alternative stack area
-                    _e->post([fail_callback, dump_file_path]() { fail_callback(dump_file_path); });
+                    _e->post(event_loop::priority::high, [fail_callback, dump_file_path]() { fail_callback(dump_file_path); });
                 }
             }
         };
@@ -250,6 +265,7 @@ private:
     main_loop* _e = nullptr;
     std::mutex _process_exit_config_lock;
     exit_callback_type _exit_callback = nullptr;
+    std::chrono::milliseconds _drain_timeout = std::chrono::seconds(5);
     std::mutex _process_fail_config_lock;
     fail_callback_type _fail_callback = nullptr;
 }; // namespace server_lib
@@ -296,7 +312,7 @@ void mt_server_impl::run_impl(main_loop& e,
 #ifndef NDEBUG
                 fprintf(stderr, "Got signal in default exit callback\n");
 #endif
-                stop(*_e);
+                drain(*_e);
             };
         }
     }
@@ -338,7 +354,7 @@ void mt_server_impl::run_impl(main_loop& e,
             if (Callbackdata_type::usersignal == _callback_data.type && control_callback)
             {
                 auto data = _callback_data.data.signal;
-                e.post([control_callback, data]() { control_callback(data); });
+                e.post(event_loop::priority::high, [control_callback, data]() { control_callback(data); });
             }
         }
         SRV_LOG_TRACE("Signal thread is stopped");
@@ -392,6 +408,11 @@ void mt_server::stop(main_loop& e)
     _impl->stop(e);
 }
 
+void mt_server::set_drain_timeout(const std::chrono::milliseconds& timeout)
+{
+    _impl->set_drain_timeout(timeout);
+}
+
 void mt_server::wait_started(main_loop& e, std::function<void(void)>&& start_notify)
 {
     _impl->wait_started(e, std::forward<std::function<void(void)>>(start_notify));
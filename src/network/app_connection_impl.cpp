@@ -1,5 +1,9 @@
 #include "app_connection_impl.h"
 
+#include <server_lib/network/integer_builder.h>
+
+#include <algorithm>
+
 #include <server_lib/asserts.h>
 #include <server_lib/logging_helper.h>
 
@@ -9,38 +13,72 @@
 
 #define SRV_LOG_CONTEXT_ "tcp-app-con (" << reinterpret_cast<uint64_t>(this) << ")> " << SRV_FUNCTION_NAME_ << ": "
 
-#ifndef SERVER_LIB_TCP_CLIENT_READ_SIZE
-#define SERVER_LIB_TCP_CLIENT_READ_SIZE 4096
-#endif /* SERVER_LIB_TCP_CLIENT_READ_SIZE */
+// smaller pieces of units are joined before sending
+#ifndef SERVER_LIB_TCP_WRITE_PIECE_MIN_SIZE
+#define SERVER_LIB_TCP_WRITE_PIECE_MIN_SIZE 1024
+#endif /* SERVER_LIB_TCP_WRITE_PIECE_MIN_SIZE */
 
 namespace server_lib {
 namespace network {
 
+    namespace {
+        // adaptive read size is decreased after several short reads in a row
+        constexpr size_t SMALL_READS_TO_SHRINK = 4;
+    } // namespace
+
     app_connection_impl::app_connection_impl(const std::shared_ptr<tcp_connection_i>& raw_connection,
-                                             const std::shared_ptr<app_unit_builder_i>& protocol)
+                                             const std::shared_ptr<app_unit_builder_i>& protocol,
+                                             event_loop* callback_thread,
+                                             const read_options& read_options)
         : _raw_connection(raw_connection)
+        , _read_options(read_options)
+        , _read_size(read_options.size)
+        , _callback_thread(callback_thread)
     {
         SRV_ASSERT(_raw_connection);
         SRV_ASSERT(protocol);
+        SRV_ASSERT(_read_size > 0);
+        SRV_ASSERT(!_read_options.adaptive || (_read_options.min_size > 0 && _read_options.min_size <= _read_options.max_size));
+
+        if (_read_options.adaptive)
+            _read_size = std::min(std::max(_read_size, _read_options.min_size), _read_options.max_size);
 
         _protocol.set_builder(protocol);
 
-        _raw_connection->set_on_disconnect_handler(std::bind(&app_connection_impl::on_diconnected, this,
-                                                             std::placeholders::_1));
+        SRV_LOGC_TRACE("created");
+    }
+
+    std::shared_ptr<app_connection_impl> app_connection_impl::create(const std::shared_ptr<tcp_connection_i>& raw_connection,
+                                                                     const std::shared_ptr<app_unit_builder_i>& protocol,
+                                                                     event_loop* callback_thread,
+                                                                     const read_options& read_options)
+    {
+        std::shared_ptr<app_connection_impl> connection;
+        if (!callback_thread)
+            connection = std::make_shared<app_connection_impl>(raw_connection, protocol, nullptr, read_options);
+        else
+            connection = make_loop_owned<app_connection_impl>(*callback_thread, raw_connection, protocol, callback_thread, read_options).share();
+
+        connection->start();
+        return connection;
+    }
+
+    void app_connection_impl::start()
+    {
+        std::weak_ptr<app_connection_impl> weak_this = shared_from_this();
+        _raw_connection->set_on_disconnect_handler([weak_this](tcp_connection_i& raw_connection) {
+            if (auto this_ = weak_this.lock())
+                this_->on_diconnected(raw_connection);
+        });
 
         try
         {
-            tcp_connection_i::read_request request = { SERVER_LIB_TCP_CLIENT_READ_SIZE,
-                                                       std::bind(&app_connection_impl::on_raw_receive, this,
-                                                                 std::placeholders::_1) };
-            _raw_connection->async_read(request);
+            async_read(shared_from_this());
         }
         catch (const std::exception& e)
         {
             SRV_LOGC_ERROR(e.what());
         }
-
-        SRV_LOGC_TRACE("created");
     }
 
     app_connection_impl::~app_connection_impl()
@@ -64,34 +102,239 @@ namespace network {
 
     app_connection_i& app_connection_impl::send(const app_unit& unit)
     {
-        std::lock_guard<std::mutex> lock(_buffer_mutex);
+        event_loop* flush_loop = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(_buffer_mutex);
 
-        _buffer += unit.to_network_string();
-        SRV_LOGC_TRACE("stored new unit");
+            append(unit);
+            SRV_LOGC_TRACE("stored new unit");
+
+            if (_auto_flush && !schedule_flush(flush_loop))
+                return *this;
+        }
+
+        // posting could block (by overflow policy) thus it is unlocked
+        if (!flush_loop || !post_flush(*flush_loop))
+            flush();
 
         return *this;
     }
 
+    void app_connection_impl::append(const app_unit& unit)
+    {
+        // the same as app_unit::to_network_string but
+        // large strings are not joined (received data is not copied at all)
+        if (unit.is_string())
+        {
+            auto view = unit.as_view();
+            if (view.size() >= SERVER_LIB_TCP_WRITE_PIECE_MIN_SIZE)
+            {
+                flush_small_buffer();
+                _buffers.emplace_back(std::move(view));
+            }
+            else
+            {
+                _small_buffer.insert(_small_buffer.end(), view.data(), view.data() + view.size());
+            }
+        }
+        else if (unit.is_integer())
+        {
+            auto data = integer_builder::pack(unit.as_integer());
+            _small_buffer.insert(_small_buffer.end(), data.begin(), data.end());
+        }
+
+        for (auto&& nested : unit.get_nested())
+            append(nested);
+    }
+
+    void app_connection_impl::flush_small_buffer()
+    {
+        if (_small_buffer.empty())
+            return;
+
+        _buffers.emplace_back(std::move(_small_buffer));
+        _small_buffer.clear();
+    }
+
     app_connection_i& app_connection_impl::commit()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_buffer_mutex);
+
+            if (!_auto_flush)
+            {
+                SRV_LOGC_TRACE("attempts to send pipelined units");
+                flush_small_buffer();
+
+                try
+                {
+                    tcp_connection_i::write_request request;
+                    request.buffers = std::move(_buffers);
+                    _buffers.clear();
+                    _raw_connection->async_write(request);
+                }
+                catch (const std::exception& e)
+                {
+                    SRV_LOGC_ERROR(e.what());
+                }
+
+                SRV_LOGC_TRACE("sent pipelined units");
+
+                return *this;
+            }
+        }
+
+        // write now (or join units to the next write if it is in progress)
+        flush();
+
+        return *this;
+    }
+
+    void app_connection_impl::set_auto_flush(bool enable)
     {
         std::lock_guard<std::mutex> lock(_buffer_mutex);
 
-        SRV_LOGC_TRACE("attempts to send pipelined units");
-        std::string buffer = std::move(_buffer);
+        if (_auto_flush == enable)
+            return;
+
+        SRV_LOGC_TRACE("auto-flush is " << (enable ? "enabled" : "disabled"));
+
+        _auto_flush = enable;
+
+        // units are joined by connection, so Nagle's delay is not needed
+        _raw_connection->set_no_delay(enable);
+        if (!enable && _corked)
+        {
+            _raw_connection->set_cork(false);
+            _corked = false;
+        }
+    }
+
+    bool app_connection_impl::schedule_flush(event_loop*& loop)
+    {
+        if (_write_in_progress)
+        {
+            // units are joined to the next write. Socket keeps partial
+            // segment of current write to join it with them
+            if (!_corked)
+            {
+                _raw_connection->set_cork(true);
+                _corked = true;
+            }
+            return false;
+        }
+
+        if (_flush_scheduled)
+            return false;
+
+        _flush_scheduled = true;
+
+        loop = flush_loop();
+        return true;
+    }
+
+    bool app_connection_impl::post_flush(event_loop& loop)
+    {
+        // Flush must not be dropped after admission. Otherwise flag
+        // of scheduled flush is never reset and connection stops sending
+        std::weak_ptr<app_connection_impl> weak_this = shared_from_this();
+        return loop.post_undroppable([weak_this]() {
+            if (auto this_ = weak_this.lock())
+                this_->flush();
+        });
+    }
+
+    event_loop* app_connection_impl::flush_loop() const
+    {
+        // the end of tick of sender loop
+        if (_callback_thread && _callback_thread->is_this_loop())
+            return _callback_thread;
+
+        auto io_loop = _raw_connection->io_loop();
+        if (io_loop)
+            return io_loop;
+
+        return _callback_thread;
+    }
+
+    void app_connection_impl::flush()
+    {
+        tcp_connection_i::write_request request;
+        {
+            std::lock_guard<std::mutex> lock(_buffer_mutex);
+
+            _flush_scheduled = false;
+
+            if (_write_in_progress || !take_buffers(request))
+                return;
+
+            _write_in_progress = true;
+        }
+
+        write(request);
+    }
+
+    bool app_connection_impl::take_buffers(tcp_connection_i::write_request& request)
+    {
+        flush_small_buffer();
+
+        if (_buffers.empty())
+            return false;
+
+        request.buffers = std::move(_buffers);
+        _buffers.clear();
+
+        std::weak_ptr<app_connection_impl> weak_this = shared_from_this();
+        request.async_write_callback = [weak_this](tcp_connection_i::write_result& result) {
+            if (auto this_ = weak_this.lock())
+                this_->on_write(result);
+        };
+        return true;
+    }
+
+    void app_connection_impl::write(tcp_connection_i::write_request& request)
+    {
+        SRV_LOGC_TRACE("attempts to send " << request.buffers.size() << " pieces");
 
         try
         {
-            tcp_connection_i::write_request request = { std::vector<char> { buffer.begin(), buffer.end() }, nullptr };
             _raw_connection->async_write(request);
         }
         catch (const std::exception& e)
         {
             SRV_LOGC_ERROR(e.what());
+
+            std::lock_guard<std::mutex> lock(_buffer_mutex);
+            _write_in_progress = false;
         }
+    }
 
-        SRV_LOGC_TRACE("sent pipelined units");
+    void app_connection_impl::on_write(const tcp_connection_i::write_result& result)
+    {
+        tcp_connection_i::write_request request;
+        {
+            std::lock_guard<std::mutex> lock(_buffer_mutex);
 
-        return *this;
+            _write_in_progress = false;
+
+            if (!result.success)
+                return;
+
+            if (!take_buffers(request))
+            {
+                // nothing to join any more. Partial segment is sent right now
+                if (_corked)
+                {
+                    _raw_connection->set_cork(false);
+                    _corked = false;
+                }
+                return;
+            }
+
+            _write_in_progress = true;
+        }
+
+        write(request);
     }
 
     void app_connection_impl::set_on_receive_handler(const receive_callback_type& callback)
@@ -104,11 +347,6 @@ namespace network {
         _disconnection_callback = callback;
     }
 
-    void app_connection_impl::set_callback_thread(event_loop* callback_thread)
-    {
-        _callback_thread = callback_thread;
-    }
-
     void app_connection_impl::call_disconnection_handler()
     {
         if (_disconnection_callback)
@@ -120,19 +358,23 @@ namespace network {
 
     void app_connection_impl::on_diconnected(tcp_connection_i&)
     {
+        // It is called with locked connection. Handler holds it because
+        // it could be posted later at low watermark (it is once per connection)
         auto hold_this = shared_from_this();
         auto call_ = [this, hold_this]() {
             SRV_LOGC_TRACE("has been disconnected");
 
-            _buffer.clear();
+            _buffers.clear();
+            _small_buffer.clear();
 
             _protocol.reset();
 
             call_disconnection_handler();
         };
-        if (_callback_thread)
+        // transport could run in callback thread
+        if (_callback_thread && !_callback_thread->is_this_loop())
         {
-            _callback_thread->post(call_);
+            _callback_thread->post_or_defer(call_);
         }
         else
         {
@@ -140,59 +382,140 @@ namespace network {
         }
     }
 
-    void app_connection_impl::on_raw_receive(const tcp_connection_i::read_result& result)
+    void app_connection_impl::on_raw_receive(holder_type&& hold_this, tcp_connection_i::read_result& result)
     {
         if (!result.success)
         {
             return;
         }
 
-        auto hold_this = shared_from_this();
-        auto call_ = [this, hold_this](const tcp_connection_i::read_result& result) {
-            try
-            {
-                SRV_LOGC_TRACE("receives packet, attempts to build unit");
-                _protocol << std::string(result.buffer.begin(), result.buffer.end());
-            }
-            catch (const std::exception& e)
+        adapt_read_size(result.buffer.size());
+
+        // received bytes are not copied. Units reference them
+        post_data(std::move(hold_this), buffer_view { std::move(result.buffer) });
+    }
+
+    void app_connection_impl::post_data(holder_type&& hold_this, const buffer_view& data)
+    {
+        if (_callback_thread && !_callback_thread->is_this_loop())
+        {
+            // Data can't be lost (or stream framing breaks).
+            // Thus reading is paused before admission fails
+            // and data is never dropped by overflow policy.
+            // Handler doesn't hold connection. It is destroyed
+            // in callback thread after posted handlers
+            if (_callback_thread->is_overloaded() || !_callback_thread->post_undroppable([this, data]() {
+                    process_data(data);
+                }))
             {
-                SRV_LOGC_ERROR("Could not build unit (invalid format), disconnecting: " << e.what());
-                call_disconnection_handler();
+                if (!_callback_thread->is_overloaded())
+                {
+                    SRV_LOGC_WARN("callback thread doesn't accept data, reading is stopped");
+                    return;
+                }
+
+                SRV_LOGC_TRACE("callback thread is overloaded, data is deferred");
+
+                _callback_thread->on_low_watermark([this, hold_this = std::move(hold_this), data]() mutable {
+                    post_data(std::move(hold_this), data);
+                });
                 return;
             }
+        }
+        else
+        {
+            process_data(data);
+        }
+
+        if (_callback_thread && _callback_thread->is_overloaded())
+        {
+            SRV_LOGC_TRACE("callback thread is overloaded, reading is paused");
+
+            // resume reading when callback thread has processed queue
+            _callback_thread->on_low_watermark([this, hold_this = std::move(hold_this)]() mutable {
+                SRV_LOGC_TRACE("reading is resumed");
+                resume_read(std::move(hold_this));
+            });
+            return;
+        }
+
+        resume_read(std::move(hold_this));
+    }
+
+    void app_connection_impl::process_data(const buffer_view& data)
+    {
+        try
+        {
+            SRV_LOGC_TRACE("receives packet, attempts to build unit");
+            _protocol << data;
+        }
+        catch (const std::exception& e)
+        {
+            SRV_LOGC_ERROR("Could not build unit (invalid format), disconnecting: " << e.what());
+            call_disconnection_handler();
+            return;
+        }
 
-            while (_protocol.receive_available())
+        while (_protocol.receive_available())
+        {
+            SRV_LOGC_TRACE("unit fully built");
+
+            auto unit = _protocol.get_front();
+            _protocol.pop_front();
+
+            if (_receive_callback)
             {
-                SRV_LOGC_TRACE("unit fully built");
+                SRV_LOGC_TRACE("executes unit callback");
+                _receive_callback(*this, unit);
+            }
+        }
+    }
 
-                auto unit = _protocol.get_front();
-                _protocol.pop_front();
+    void app_connection_impl::adapt_read_size(size_t received)
+    {
+        if (!_read_options.adaptive)
+            return;
 
-                if (_receive_callback)
-                {
-                    SRV_LOGC_TRACE("executes unit callback");
-                    _receive_callback(*this, unit);
-                }
+        if (received >= _read_size)
+        {
+            _small_reads = 0;
+            if (_read_size < _read_options.max_size)
+            {
+                _read_size = std::min(_read_size * 2, _read_options.max_size);
+                SRV_LOGC_TRACE("read size is increased to " << _read_size);
             }
-        };
-        if (_callback_thread)
+        }
+        else if (received < _read_size / 4)
         {
-            auto call_copy_result = [call_, result_ = result]() {
-                call_(result_);
-            };
-            _callback_thread->post(std::move(call_copy_result));
+            if (++_small_reads >= SMALL_READS_TO_SHRINK && _read_size > _read_options.min_size)
+            {
+                _small_reads = 0;
+                _read_size = std::max(_read_size / 2, _read_options.min_size);
+                SRV_LOGC_TRACE("read size is decreased to " << _read_size);
+            }
         }
         else
         {
-            call_(result);
+            _small_reads = 0;
         }
+    }
 
+    void app_connection_impl::async_read(holder_type&& hold_this)
+    {
+        // Read in progress holds connection. The reference is moved
+        // from read to read, so it costs nothing per packet
+        tcp_connection_i::read_request request = { _read_size,
+                                                   [this, hold_this = std::move(hold_this)](tcp_connection_i::read_result& result) mutable {
+                                                       on_raw_receive(std::move(hold_this), result);
+                                                   } };
+        _raw_connection->async_read(request);
+    }
+
+    void app_connection_impl::resume_read(holder_type&& hold_this)
+    {
         try
         {
-            tcp_connection_i::read_request request = { SERVER_LIB_TCP_CLIENT_READ_SIZE,
-                                                       std::bind(&app_connection_impl::on_raw_receive, this,
-                                                                 std::placeholders::_1) };
-            _raw_connection->async_read(request);
+            async_read(std::move(hold_this));
         }
         catch (const std::exception&)
         {
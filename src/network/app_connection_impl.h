@@ -19,7 +19,17 @@ namespace network {
     {
     public:
         app_connection_impl(const std::shared_ptr<tcp_connection_i>&,
-                            const std::shared_ptr<app_unit_builder_i>&);
+                            const std::shared_ptr<app_unit_builder_i>&,
+                            event_loop* callback_thread = nullptr,
+                            const read_options& = {});
+
+        // Connection with callback thread is destroyed in callback thread
+        // after handlers posted there, so they don't hold it.
+        // Connection is held by owner and by read in progress
+        static std::shared_ptr<app_connection_impl> create(const std::shared_ptr<tcp_connection_i>&,
+                                                           const std::shared_ptr<app_unit_builder_i>&,
+                                                           event_loop* callback_thread,
+                                                           const read_options& = {});
 
         ~app_connection_impl() override;
 
@@ -31,26 +41,66 @@ namespace network {
 
         app_connection_i& commit() override;
 
+        void set_auto_flush(bool) override;
+
         void set_on_receive_handler(const receive_callback_type&) override;
 
         void set_on_disconnect_handler(const disconnection_callback_type&) override;
 
-        void set_callback_thread(event_loop*);
-
     private:
-        void on_raw_receive(const tcp_connection_i::read_result& result);
+        using holder_type = std::shared_ptr<app_connection_impl>;
+
+        // connection is owned already (disconnection handler holds it weakly)
+        void start();
+
+        // reference of read in progress is passed through
+        void on_raw_receive(holder_type&& hold_this, tcp_connection_i::read_result& result);
+        // reading is resumed when data is accepted by callback thread
+        void post_data(holder_type&& hold_this, const buffer_view& data);
+        void process_data(const buffer_view& data);
+        void adapt_read_size(size_t received);
+        void async_read(holder_type&& hold_this);
+        void resume_read(holder_type&& hold_this);
         void on_diconnected(tcp_connection_i&);
 
         void call_disconnection_handler();
 
+        void append(const app_unit& unit);
+        void flush_small_buffer();
+
+        // false if units go with scheduled flush or with the next write.
+        // 'loop' is set if flush should be posted there
+        // (it is flushed at once otherwise)
+        bool schedule_flush(event_loop*& loop);
+        bool post_flush(event_loop&);
+        event_loop* flush_loop() const;
+        void flush();
+        bool take_buffers(tcp_connection_i::write_request&);
+        void write(tcp_connection_i::write_request&);
+        void on_write(const tcp_connection_i::write_result&);
+
         std::shared_ptr<tcp_connection_i> _raw_connection;
 
+        // transport thread only
+        const read_options _read_options;
+        size_t _read_size;
+        size_t _small_reads = 0;
+
         app_units_builder _protocol;
 
-        std::string _buffer;
+        // units to send by pieces
+        std::vector<buffer_view> _buffers;
+        // small pieces are joined
+        std::vector<char> _small_buffer;
 
         std::mutex _buffer_mutex;
 
+        // auto-flush state (it is guarded by buffer mutex)
+        bool _auto_flush = false;
+        bool _write_in_progress = false;
+        bool _flush_scheduled = false;
+        bool _corked = false;
+
         event_loop* _callback_thread = nullptr;
         receive_callback_type _receive_callback = nullptr;
         disconnection_callback_type _disconnection_callback = nullptr;
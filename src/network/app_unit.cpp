@@ -5,7 +5,9 @@
 
 #include <boost/variant/get.hpp>
 
+#include <algorithm>
 #include <type_traits>
+#include <utility>
 
 namespace server_lib {
 namespace network {
@@ -22,6 +24,12 @@ namespace network {
     {
     }
 
+    app_unit::app_unit(const buffer_view& value, const bool success)
+        : _success(success)
+        , _data(value)
+    {
+    }
+
     app_unit::app_unit(const integer_type value, const bool success)
         : _success(success)
         , _data(value)
@@ -60,8 +68,7 @@ namespace network {
         return !is_error();
     }
 
-    const std::string&
-    app_unit::error() const
+    std::string app_unit::error() const
     {
         SRV_ASSERT(is_error(), "Logic unit is not an error");
 
@@ -85,6 +92,12 @@ namespace network {
         _data = value;
     }
 
+    void app_unit::set(const buffer_view& value, const bool success)
+    {
+        _success = success;
+        _data = value;
+    }
+
     void app_unit::set(const integer_type value, const bool success)
     {
         _success = success;
@@ -125,6 +138,10 @@ namespace network {
             {
                 return std::is_same<bool, T>::value;
             }
+            auto operator()(const buffer_view&)
+            {
+                return std::is_same<buffer_view, T>::value;
+            }
         };
 
         class lunit_data_to_string : public boost::static_visitor<std::string>
@@ -144,6 +161,10 @@ namespace network {
             {
                 return std::to_string(data);
             }
+            auto operator()(const buffer_view& data)
+            {
+                return data.to_string();
+            }
         };
 
         class lunit_data_to_network_string : public boost::static_visitor<std::string>
@@ -163,6 +184,10 @@ namespace network {
             {
                 return std::string {}; //this type is not been sending by
             }
+            auto operator()(const buffer_view& data)
+            {
+                return data.to_string();
+            }
         };
     } // namespace impl
 
@@ -174,7 +199,8 @@ namespace network {
     bool app_unit::is_string() const
     {
         impl::is_lunit_type<std::string> check;
-        return boost::apply_visitor(check, _data);
+        impl::is_lunit_type<buffer_view> check_view;
+        return boost::apply_visitor(check, _data) || boost::apply_visitor(check_view, _data);
     }
 
     bool app_unit::is_error() const
@@ -194,19 +220,56 @@ namespace network {
         return boost::apply_visitor(check, _data);
     }
 
+    bool app_unit::is_view() const
+    {
+        impl::is_lunit_type<buffer_view> check;
+        return boost::apply_visitor(check, _data);
+    }
+
     const std::vector<app_unit>& app_unit::get_nested() const
     {
         return _nested_content;
     }
 
-    const std::string&
-    app_unit::as_string() const
+    std::string app_unit::as_string() const
     {
         SRV_ASSERT(is_string(), "Logic unit is not a string");
 
+        if (auto* view = boost::get<buffer_view>(&_data))
+            return view->to_string();
+
         return boost::get<std::string>(_data);
     }
 
+    buffer_view app_unit::as_view() const
+    {
+        SRV_ASSERT(is_string(), "Logic unit is not a string");
+
+        if (auto* view = boost::get<buffer_view>(&_data))
+            return *view;
+
+        return buffer_view { boost::get<std::string>(_data) };
+    }
+
+    bool app_unit::equal_data(const app_unit& a, const app_unit& b)
+    {
+        // received and created strings are the same
+        if (a.is_string() && b.is_string())
+        {
+            auto bytes = [](const variant_type& data) {
+                if (auto* view = boost::get<buffer_view>(&data))
+                    return std::make_pair(view->data(), view->size());
+                auto& str = boost::get<std::string>(data);
+                return std::make_pair(str.data(), str.size());
+            };
+            auto a_bytes = bytes(a._data);
+            auto b_bytes = bytes(b._data);
+            return a_bytes.second == b_bytes.second && std::equal(a_bytes.first, a_bytes.first + a_bytes.second, b_bytes.first);
+        }
+
+        return a._data == b._data;
+    }
+
     app_unit::integer_type app_unit::as_integer() const
     {
         SRV_ASSERT(is_integer(), "Logic unit is not a integer");
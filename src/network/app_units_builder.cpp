@@ -25,7 +25,13 @@ namespace network {
     app_units_builder&
     app_units_builder::operator<<(const std::string& data)
     {
-        _buffer += data;
+        return *this << buffer_view { data };
+    }
+
+    app_units_builder&
+    app_units_builder::operator<<(const buffer_view& data)
+    {
+        _buffer.append(data);
 
         while (build_unit())
             ;
@@ -54,6 +54,12 @@ namespace network {
      */
         app_units_builder& operator<<(const std::string& data);
 
+        /**
+     * the same for received data (it is not copied)
+     *
+     */
+        app_units_builder& operator<<(const buffer_view& data);
+
         /**
      * similar as get_front, store unit in the passed parameter
      *
@@ -97,10 +103,11 @@ namespace network {
 
     private:
         /**
-     * buffer to be used to build data
+     * received data to be used to build units.
+     * Units could reference its blocks
      *
      */
-        std::string _buffer;
+        buffer_chain _buffer;
 
         /**
      * builder used to build replies
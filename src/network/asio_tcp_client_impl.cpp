@@ -0,0 +1,179 @@
+#include "asio_tcp_client_impl.h"
+
+#include "asio_tcp_connection_impl.h"
+
+#include <server_lib/asserts.h>
+#include <server_lib/logging_helper.h>
+
+#include <boost/version.hpp>
+
+#include <chrono>
+
+#ifdef SRV_LOG_CONTEXT_
+#undef SRV_LOG_CONTEXT_
+#endif // #ifdef SRV_LOG_CONTEXT_
+
+#define SRV_LOG_CONTEXT_ "asio-cli-impl> " << SRV_FUNCTION_NAME_ << ": "
+
+namespace server_lib {
+namespace network {
+
+    namespace {
+        using boost::asio::ip::tcp;
+
+        // connect to socket of 'service'
+        tcp::socket connect_socket(boost::asio::io_service& service, const std::string& addr, uint16_t port, uint32_t timeout_ms)
+        {
+            // private io_service to wait for connection with timeout
+            // (it can't be waited in loop if it is called from this loop)
+            boost::asio::io_service connect_service;
+
+            tcp::resolver resolver(connect_service);
+            auto endpoints = resolver.resolve(tcp::resolver::query(addr, std::to_string(port)));
+
+#if BOOST_VERSION >= 106700
+            tcp::socket socket(connect_service);
+            boost::system::error_code ec = boost::asio::error::would_block;
+            boost::asio::async_connect(socket, endpoints, [&ec](const boost::system::error_code& ec_, const auto&) {
+                ec = ec_;
+            });
+            if (timeout_ms)
+                connect_service.run_for(std::chrono::milliseconds(timeout_ms));
+            else
+                connect_service.run();
+            if (ec == boost::asio::error::would_block)
+                ec = boost::asio::error::timed_out;
+            if (ec)
+                SRV_THROW_EXCEPTION(std::runtime_error, "Can't connect to " + addr + ":" + std::to_string(port) + ": " + ec.message());
+
+            auto protocol = socket.local_endpoint().protocol();
+            return tcp::socket(service, protocol, socket.release());
+#else
+            // timeout is not supported
+            tcp::socket socket(service);
+            boost::asio::connect(socket, endpoints);
+            return socket;
+#endif
+        }
+    } // namespace
+
+    asio_tcp_client_impl::asio_tcp_client_impl(event_loop* io_loop)
+        : _io_loop(io_loop)
+    {
+    }
+
+    asio_tcp_client_impl::~asio_tcp_client_impl()
+    {
+        disconnect(true);
+    }
+
+    void asio_tcp_client_impl::connect(const std::string& addr, uint16_t port, uint32_t timeout_ms)
+    {
+        SRV_LOGC_TRACE("attempts to connect");
+
+        SRV_ASSERT(!is_connected(), "Client is already connected");
+
+        auto* loop = _io_loop;
+        if (!loop)
+        {
+            if (!_own_loop)
+            {
+                _own_loop = std::make_shared<event_loop>();
+                _own_loop->change_thread_name("asio-cli");
+                if (!_worker_options.empty())
+                    _own_loop->set_thread_options(_worker_options);
+                _own_loop->start();
+            }
+            loop = _own_loop.get();
+        }
+
+        auto socket = connect_socket(*loop->service(), addr, port, timeout_ms);
+
+        {
+            std::lock_guard<std::mutex> lock(_connection_mutex);
+            _connection = std::make_shared<asio_tcp_connection_impl>(
+                std::move(socket), *loop, [this](asio_tcp_connection_impl&) {
+                    on_diconnected();
+                },
+                loop == _own_loop.get() ? _own_loop : nullptr);
+        }
+
+        SRV_LOGC_TRACE("connected");
+    }
+
+    void asio_tcp_client_impl::disconnect(bool wait_for_removal)
+    {
+        SRV_LOGC_TRACE("attempts to disconnect");
+
+        clear_connection();
+
+        // all callbacks are completed with own loop
+        if (wait_for_removal && _own_loop && !_own_loop->is_this_loop())
+        {
+            stop_asio_loop(*_own_loop);
+            _own_loop.reset();
+        }
+
+        SRV_LOGC_TRACE("disconnected");
+    }
+
+    bool asio_tcp_client_impl::is_connected() const
+    {
+        std::lock_guard<std::mutex> lock(_connection_mutex);
+        return _connection && _connection->is_connected();
+    }
+
+    void asio_tcp_client_impl::set_nb_workers(uint8_t)
+    {
+    }
+
+    void asio_tcp_client_impl::set_worker_options(const thread_options& options)
+    {
+        _worker_options = options;
+
+        if (_own_loop)
+            _own_loop->set_thread_options(options);
+    }
+
+    std::shared_ptr<tcp_connection_i> asio_tcp_client_impl::create_connection()
+    {
+        SRV_LOGC_TRACE("attempts to create connection");
+
+        SRV_ASSERT(is_connected());
+
+        std::lock_guard<std::mutex> lock(_connection_mutex);
+        return std::static_pointer_cast<tcp_connection_i>(_connection);
+    }
+
+    void asio_tcp_client_impl::set_on_disconnection_handler(const disconnection_callback_type& disconnection_handler)
+    {
+        _disconnection_callback = disconnection_handler;
+    }
+
+    void asio_tcp_client_impl::on_diconnected()
+    {
+        SRV_LOGC_TRACE("handle client disconnection");
+
+        clear_connection();
+
+        if (_disconnection_callback)
+            _disconnection_callback();
+    }
+
+    void asio_tcp_client_impl::clear_connection()
+    {
+        std::shared_ptr<asio_tcp_connection_impl> connection;
+        {
+            std::lock_guard<std::mutex> lock(_connection_mutex);
+            connection = std::move(_connection);
+        }
+
+        if (connection)
+        {
+            connection->disconnect();
+            connection->notify_disconnected();
+        }
+    }
+
+} // namespace network
+} // namespace server_lib
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <server_lib/network/tcp_client_i.h>
+#include <server_lib/event_loop.h>
+
+#include <memory>
+#include <mutex>
+
+namespace server_lib {
+namespace network {
+
+    class asio_tcp_connection_impl;
+
+    class asio_tcp_client_impl : public tcp_client_i
+    {
+    public:
+        asio_tcp_client_impl(event_loop* io_loop = nullptr);
+
+        ~asio_tcp_client_impl() override;
+
+        void connect(const std::string& addr, uint16_t port, uint32_t timeout_ms = 0) override;
+
+        void disconnect(bool wait_for_removal = false) override;
+
+        bool is_connected() const override;
+
+        // client uses single loop
+        void set_nb_workers(uint8_t nb_threads) override;
+
+        // for own loop only
+        void set_worker_options(const thread_options& options) override;
+
+        std::shared_ptr<tcp_connection_i> create_connection() override;
+
+        void set_on_disconnection_handler(const disconnection_callback_type& disconnection_handler) override;
+
+    private:
+        void on_diconnected();
+        void clear_connection();
+
+        event_loop* _io_loop = nullptr;
+        // if I/O loop is not set
+        // (connection holds it too)
+        std::shared_ptr<event_loop> _own_loop;
+        thread_options _worker_options;
+
+        disconnection_callback_type _disconnection_callback;
+        std::shared_ptr<asio_tcp_connection_impl> _connection;
+        mutable std::mutex _connection_mutex;
+    };
+
+} // namespace network
+} // namespace server_lib
@@ -0,0 +1,231 @@
+#include "asio_tcp_connection_impl.h"
+
+#include <server_lib/asserts.h>
+#include <server_lib/logging_helper.h>
+
+#ifdef SRV_LOG_CONTEXT_
+#undef SRV_LOG_CONTEXT_
+#endif // #ifdef SRV_LOG_CONTEXT_
+
+#define SRV_LOG_CONTEXT_ "asio-con (" << reinterpret_cast<uint64_t>(this) << ")> " << SRV_FUNCTION_NAME_ << ": "
+
+namespace server_lib {
+namespace network {
+
+    void stop_asio_loop(event_loop& loop)
+    {
+        loop.stop();
+
+        auto service = loop.service();
+        service->reset();
+        service->poll();
+    }
+
+    asio_tcp_connection_impl::asio_tcp_connection_impl(boost::asio::ip::tcp::socket&& socket, event_loop& loop, const closed_callback_type& closed_callback, const std::shared_ptr<event_loop>& own_loop)
+        : _own_loop(own_loop)
+        , _socket(std::move(socket))
+        , _loop(loop)
+        , _closed_callback(closed_callback)
+        , _connected(true)
+        , _disconnection_notified(false)
+    {
+        SRV_ASSERT(_socket.is_open());
+
+        SRV_LOGC_TRACE("created");
+    }
+
+    asio_tcp_connection_impl::~asio_tcp_connection_impl()
+    {
+        SRV_LOGC_TRACE("destroyed");
+    }
+
+    bool asio_tcp_connection_impl::is_connected() const
+    {
+        return _connected.load();
+    }
+
+    void asio_tcp_connection_impl::async_read(read_request& request)
+    {
+        SRV_ASSERT(is_connected(), "Connection is closed");
+
+        dispatch([this, size = request.size, callback = std::move(request.async_read_callback)]() mutable {
+            start_read(size, std::move(callback));
+        });
+    }
+
+    void asio_tcp_connection_impl::async_write(write_request& request)
+    {
+        SRV_ASSERT(is_connected(), "Connection is closed");
+
+        dispatch([this, buffer = std::move(request.buffer), callback = std::move(request.async_write_callback), buffers = std::move(request.buffers)]() mutable {
+            _writes.push_back({ std::move(buffer), std::move(callback), std::move(buffers) });
+            // the front one is in progress
+            if (_writes.size() == 1)
+                start_write();
+        });
+    }
+
+    void asio_tcp_connection_impl::set_on_disconnect_handler(const disconnection_callback_type& callback)
+    {
+        _disconnection_callback = callback;
+    }
+
+    void asio_tcp_connection_impl::set_no_delay(bool enable)
+    {
+        dispatch([this, enable]() {
+            boost::system::error_code ec;
+            _socket.set_option(boost::asio::ip::tcp::no_delay(enable), ec);
+            if (ec)
+                SRV_LOGC_TRACE("can't set TCP_NODELAY: " << ec.message());
+        });
+    }
+
+    void asio_tcp_connection_impl::set_cork(bool enable)
+    {
+#if defined(TCP_CORK)
+        dispatch([this, enable]() {
+            using cork = boost::asio::detail::socket_option::boolean<IPPROTO_TCP, TCP_CORK>;
+
+            boost::system::error_code ec;
+            _socket.set_option(cork(enable), ec);
+            if (ec)
+                SRV_LOGC_TRACE("can't set TCP_CORK: " << ec.message());
+        });
+#else
+        (void)enable;
+#endif
+    }
+
+    void asio_tcp_connection_impl::disconnect()
+    {
+        if (!_connected.exchange(false))
+            return;
+
+        SRV_LOGC_TRACE("disconnect");
+
+        // pending operations are finished with error
+        dispatch([this]() {
+            boost::system::error_code ec;
+            _socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+            _socket.close(ec);
+        });
+    }
+
+    void asio_tcp_connection_impl::notify_disconnected()
+    {
+        if (_disconnection_notified.exchange(true))
+            return;
+
+        if (_disconnection_callback)
+            _disconnection_callback(*this);
+    }
+
+    template <typename Handler>
+    void asio_tcp_connection_impl::dispatch(Handler&& handler)
+    {
+        if (_loop.is_this_loop())
+        {
+            handler();
+            return;
+        }
+
+        _loop.service()->post([hold_this = shared_from_this(), handler = std::move(handler)]() mutable {
+            handler();
+        });
+    }
+
+    void asio_tcp_connection_impl::start_read(size_t size, async_read_callback_type&& callback)
+    {
+        if (!_socket.is_open())
+        {
+            read_result result = { false, {} };
+            if (callback)
+                callback(result);
+            return;
+        }
+
+        // vector data is not moved with vector
+        std::vector<char> buffer(size);
+        auto data = boost::asio::buffer(buffer);
+        _socket.async_read_some(data, [this, hold_this = shared_from_this(), buffer = std::move(buffer), callback = std::move(callback)](const boost::system::error_code& ec, size_t transferred) mutable {
+            read_result result = { !ec, {} };
+            if (!ec)
+            {
+                buffer.resize(transferred);
+                result.buffer = std::move(buffer);
+            }
+
+            if (callback)
+                callback(result);
+
+            // eof is closed by peer
+            if (ec)
+                close();
+        });
+    }
+
+    void asio_tcp_connection_impl::start_write()
+    {
+        SRV_ASSERT(!_writes.empty());
+
+        auto& operation = _writes.front();
+
+        // pieces are owned by operation until completion
+        std::vector<boost::asio::const_buffer> buffers;
+        buffers.reserve(operation.buffers.size() + 1);
+        if (!operation.buffer.empty())
+            buffers.emplace_back(boost::asio::buffer(operation.buffer));
+        for (auto&& view : operation.buffers)
+            buffers.emplace_back(view.data(), view.size());
+
+        boost::asio::async_write(_socket, buffers,
+                                 [this, hold_this = shared_from_this()](const boost::system::error_code& ec, size_t transferred) {
+                                     on_write(ec, transferred);
+                                 });
+    }
+
+    void asio_tcp_connection_impl::on_write(const boost::system::error_code& ec, size_t transferred)
+    {
+        if (ec)
+        {
+            auto writes = std::move(_writes);
+            _writes.clear();
+            for (auto&& queued : writes)
+            {
+                write_result result = { false, 0 };
+                if (queued.callback)
+                    queued.callback(result);
+            }
+            close();
+            return;
+        }
+
+        auto written = std::move(_writes.front());
+        _writes.pop_front();
+
+        // callback could push new write
+        if (!_writes.empty())
+            start_write();
+
+        write_result result = { true, transferred };
+        if (written.callback)
+            written.callback(result);
+    }
+
+    void asio_tcp_connection_impl::close()
+    {
+        if (!_connected.exchange(false))
+            return;
+
+        SRV_LOGC_TRACE("closed");
+
+        boost::system::error_code ec;
+        _socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+        _socket.close(ec);
+
+        if (_closed_callback)
+            _closed_callback(*this);
+    }
+
+} // namespace network
+} // namespace server_lib
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <server_lib/network/tcp_connection_i.h>
+#include <server_lib/event_loop.h>
+
+#include <boost/asio.hpp>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+
+namespace server_lib {
+namespace network {
+
+    /**
+     * stop own loop of transport and complete aborted operations
+     * of closed sockets (they hold connections that hold loop)
+     */
+    void stop_asio_loop(event_loop&);
+
+    /**
+     * @brief TCP connection of Boost.Asio transport
+     *
+     * Socket belongs to io_service of connection loop. All operations
+     * are started and completed in this loop. Writes are sent one by one
+     * in request order. Pieces of write request are sent by gather write
+     */
+    class asio_tcp_connection_impl : public tcp_connection_i,
+                                     public std::enable_shared_from_this<asio_tcp_connection_impl>
+    {
+    public:
+        /**
+         * callback for transport (server or client) when connection is closed
+         * by peer or by error
+         */
+        using closed_callback_type = std::function<void(asio_tcp_connection_impl&)>;
+
+        /**
+         * @param own_loop loop is created by transport (or nullptr for foreign loop).
+         * Transport could release it before connection, so connection holds it
+         */
+        asio_tcp_connection_impl(boost::asio::ip::tcp::socket&&, event_loop&, const closed_callback_type&, const std::shared_ptr<event_loop>& own_loop);
+
+        ~asio_tcp_connection_impl() override;
+
+        bool is_connected() const override;
+
+        void async_read(read_request& request) override;
+
+        void async_write(write_request& request) override;
+
+        void set_on_disconnect_handler(const disconnection_callback_type&) override;
+
+        void set_no_delay(bool) override;
+
+        void set_cork(bool) override;
+
+        event_loop* io_loop() const override
+        {
+            return &_loop;
+        }
+
+        // close socket. Pending operations are failed
+        void disconnect() override;
+
+        // call disconnection handler (only once)
+        void notify_disconnected();
+
+    private:
+        struct write_operation
+        {
+            std::vector<char> buffer;
+            async_write_callback_type callback;
+            std::vector<buffer_view> buffers;
+        };
+
+        template <typename Handler>
+        void dispatch(Handler&& handler);
+
+        void start_read(size_t size, async_read_callback_type&& callback);
+
+        void start_write();
+        void on_write(const boost::system::error_code&, size_t);
+
+        void close();
+
+        std::shared_ptr<event_loop> _own_loop;
+        boost::asio::ip::tcp::socket _socket;
+        event_loop& _loop;
+        closed_callback_type _closed_callback;
+
+        std::atomic_bool _connected;
+        std::atomic_bool _disconnection_notified;
+        disconnection_callback_type _disconnection_callback = nullptr;
+
+        // loop thread only
+        std::deque<write_operation> _writes;
+    };
+
+} // namespace network
+} // namespace server_lib
@@ -0,0 +1,351 @@
+#include "asio_tcp_server_impl.h"
+
+#include "asio_tcp_connection_impl.h"
+
+#include <server_lib/asserts.h>
+#include <server_lib/logging_helper.h>
+
+#include <algorithm>
+#include <thread>
+
+#ifdef SRV_LOG_CONTEXT_
+#undef SRV_LOG_CONTEXT_
+#endif // #ifdef SRV_LOG_CONTEXT_
+
+#define SRV_LOG_CONTEXT_ "asio-srv-impl> " << SRV_FUNCTION_NAME_ << ": "
+
+namespace server_lib {
+namespace network {
+
+    namespace {
+        bool support_reuse_port()
+        {
+#if defined(SO_REUSEPORT)
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        template <typename Handler>
+        void dispatch_to(event_loop& loop, Handler&& handler)
+        {
+            if (loop.is_this_loop())
+                handler();
+            else
+                loop.service()->post(std::forward<Handler>(handler));
+        }
+    } // namespace
+
+    asio_tcp_server_impl::asio_tcp_server_impl(const asio_server_options& options, event_loop_pool* io_loops)
+        : _options(options)
+        , _io_loops(io_loops)
+        , _running(false)
+    {
+    }
+
+    asio_tcp_server_impl::~asio_tcp_server_impl()
+    {
+        stop(true);
+    }
+
+    void asio_tcp_server_impl::start(const std::string& host, uint16_t port, event_loop* callback_thread, const on_new_connection_callback_type& callback)
+    {
+        SRV_ASSERT(!is_running());
+        SRV_ASSERT(callback);
+
+        try
+        {
+            SRV_LOGC_TRACE("attempts to start");
+
+            _callback_thread = callback_thread;
+            _new_connection_handler = callback;
+
+            if (!_io_loops && !_callback_thread)
+            {
+                for (size_t ci = 0; ci < _nb_workers; ++ci)
+                {
+                    auto loop = std::make_shared<event_loop>();
+                    loop->change_thread_name("asio-srv-" + std::to_string(ci));
+                    if (!_worker_options.empty())
+                        loop->set_thread_options(_worker_options);
+                    loop->start();
+                    _own_loops.emplace_back(std::move(loop));
+                }
+            }
+
+            using boost::asio::ip::tcp;
+
+            auto loops = listen_loops();
+            SRV_ASSERT(!loops.empty());
+
+            tcp::resolver resolver(*loops.front()->service());
+            tcp::resolver::query query(host, std::to_string(port));
+            tcp::endpoint endpoint = *resolver.resolve(query);
+
+            for (auto* loop : loops)
+            {
+                auto acceptor = std::make_shared<tcp::acceptor>(*loop->service());
+                acceptor->open(endpoint.protocol());
+                acceptor->set_option(tcp::acceptor::reuse_address(true));
+#if defined(SO_REUSEPORT)
+                if (loops.size() > 1)
+                {
+                    using reuse_port = boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+                    acceptor->set_option(reuse_port(true));
+                }
+#endif
+                acceptor->bind(endpoint);
+                acceptor->listen();
+
+                auto listener = std::make_shared<shard>();
+                listener->loop = loop;
+                for (auto&& own_loop : _own_loops)
+                {
+                    if (own_loop.get() == loop)
+                        listener->own_loop = own_loop;
+                }
+                listener->acceptor = acceptor;
+                listener->sharded = loops.size() > 1;
+                _shards.emplace_back(std::move(listener));
+            }
+
+            _running = true;
+
+            // acceptor is used in its loop only
+            auto weak_this = std::weak_ptr<asio_tcp_server_impl>(shared_from_this());
+            for (auto&& listener : _shards)
+            {
+                dispatch_to(*listener->loop, [weak_this, listener]() {
+                    auto hold_this = weak_this.lock();
+                    if (hold_this && hold_this->is_running())
+                        hold_this->accept(listener);
+                });
+            }
+
+            SRV_LOGC_TRACE("started" << (_shards.size() > 1 ? " (sharded)" : ""));
+        }
+        catch (const std::exception& e)
+        {
+            SRV_LOGC_ERROR(e.what());
+
+            _running = false;
+            _shards.clear();
+            for (auto&& loop : _own_loops)
+                stop_asio_loop(*loop);
+            _own_loops.clear();
+            throw;
+        }
+    }
+
+    void asio_tcp_server_impl::stop(bool, bool recursive_wait_for_removal)
+    {
+        if (!_running.exchange(false))
+        {
+            return;
+        }
+
+        SRV_LOGC_TRACE("attempts to stop");
+
+        auto shards = std::move(_shards);
+        _shards.clear();
+        for (auto&& listener : shards)
+        {
+            auto acceptor = listener->acceptor;
+            dispatch_to(*listener->loop, [acceptor]() {
+                boost::system::error_code ec;
+                acceptor->close(ec);
+            });
+
+            decltype(listener->connections) connections;
+            {
+                std::lock_guard<std::mutex> lock(listener->connections_mutex);
+                connections.swap(listener->connections);
+            }
+            for (auto&& item : connections)
+            {
+                auto& connection = item.second;
+                connection->disconnect();
+                if (recursive_wait_for_removal)
+                    connection->notify_disconnected();
+            }
+        }
+
+        // own loops are always stopped synchronously
+        // (except stop from own loop that can't join itself)
+        auto this_loop = std::find_if(_own_loops.begin(), _own_loops.end(), [](const std::shared_ptr<event_loop>& loop) {
+            return loop->is_this_loop();
+        });
+        if (this_loop != _own_loops.end())
+        {
+            std::thread([loops = std::move(_own_loops)]() {
+                for (auto&& loop : loops)
+                    stop_asio_loop(*loop);
+            })
+                .detach();
+        }
+        else
+        {
+            for (auto&& loop : _own_loops)
+                stop_asio_loop(*loop);
+        }
+        _own_loops.clear();
+        _next_loop = 0;
+
+        SRV_LOGC_TRACE("stopped");
+    }
+
+    bool asio_tcp_server_impl::is_running(void) const
+    {
+        return _running.load();
+    }
+
+    void asio_tcp_server_impl::set_nb_workers(uint8_t nb_threads)
+    {
+        _nb_workers = std::max<size_t>(nb_threads, 1);
+
+        if (is_running())
+        {
+            SRV_LOGC_WARN("Workers number will be changed at next start");
+        }
+    }
+
+    void asio_tcp_server_impl::set_worker_options(const thread_options& options)
+    {
+        _worker_options = options;
+
+        for (auto&& loop : _own_loops)
+            loop->set_thread_options(options);
+    }
+
+    std::vector<event_loop*> asio_tcp_server_impl::listen_loops()
+    {
+        std::vector<event_loop*> loops;
+        if (_io_loops)
+        {
+            SRV_ASSERT(_io_loops->size() > 0);
+            for (size_t ci = 0; ci < _io_loops->size(); ++ci)
+                loops.emplace_back(&_io_loops->loop(ci));
+        }
+        else if (_callback_thread)
+        {
+            loops.emplace_back(_callback_thread);
+        }
+        else
+        {
+            for (auto&& loop : _own_loops)
+                loops.emplace_back(loop.get());
+        }
+
+        if (!_options.sharded_listen || !support_reuse_port())
+        {
+            if (_options.sharded_listen)
+                SRV_LOGC_WARN("SO_REUSEPORT is not supported. Single listener is used");
+            loops.resize(std::min<size_t>(loops.size(), 1));
+        }
+        return loops;
+    }
+
+    event_loop& asio_tcp_server_impl::next_io_loop(std::shared_ptr<event_loop>& own_loop)
+    {
+        if (_io_loops)
+            return _io_loops->next_loop();
+
+        if (!_own_loops.empty())
+        {
+            own_loop = _own_loops[_next_loop++ % _own_loops.size()];
+            return *own_loop;
+        }
+
+        SRV_ASSERT(_callback_thread);
+        return *_callback_thread;
+    }
+
+    void asio_tcp_server_impl::accept(const std::shared_ptr<shard>& listener)
+    {
+        auto own_loop = listener->own_loop;
+        auto& loop = listener->sharded ? *listener->loop : next_io_loop(own_loop);
+        auto socket = std::make_shared<boost::asio::ip::tcp::socket>(*loop.service());
+
+        // server could be destroyed while handler is waiting in foreign loop
+        auto weak_this = std::weak_ptr<asio_tcp_server_impl>(shared_from_this());
+        listener->acceptor->async_accept(*socket, [weak_this, listener, socket, &loop, own_loop](const boost::system::error_code& ec) {
+            auto hold_this = weak_this.lock();
+            if (!hold_this || !hold_this->is_running() || ec == boost::asio::error::operation_aborted)
+                return;
+
+            if (ec)
+            {
+                SRV_LOGC_ERROR("accept failed: " << ec.message());
+            }
+            else
+            {
+                hold_this->on_new_connection(listener, std::move(*socket), loop, own_loop);
+            }
+
+            hold_this->accept(listener);
+        });
+    }
+
+    void asio_tcp_server_impl::on_new_connection(const std::shared_ptr<shard>& listener, boost::asio::ip::tcp::socket&& socket, event_loop& loop, const std::shared_ptr<event_loop>& own_loop)
+    {
+        auto connection = std::make_shared<asio_tcp_connection_impl>(std::move(socket), loop,
+                                                                     std::bind(&asio_tcp_server_impl::on_client_disconnected, this, listener, std::placeholders::_1),
+                                                                     own_loop);
+
+        auto hold_this = shared_from_this();
+        auto call_ = [this, hold_this, listener, connection]() {
+            SRV_LOGC_TRACE("handle new client connection (" << reinterpret_cast<uint64_t>(connection.get()) << ")");
+
+            {
+                std::lock_guard<std::mutex> lock(listener->connections_mutex);
+
+                listener->connections.emplace(connection.get(), connection);
+
+                SRV_LOGC_TRACE("connections = " << listener->connections.size());
+            }
+
+            SRV_ASSERT(_new_connection_handler);
+            _new_connection_handler(connection);
+        };
+        if (_callback_thread && !_callback_thread->is_this_loop())
+        {
+            _callback_thread->post_or_defer(call_);
+        }
+        else
+        {
+            call_();
+        }
+    }
+
+    void asio_tcp_server_impl::on_client_disconnected(const std::shared_ptr<shard>& listener, asio_tcp_connection_impl& closed)
+    {
+        if (!is_running())
+        {
+            return;
+        }
+
+        auto hold_this = shared_from_this();
+        auto connection = closed.shared_from_this();
+        auto call_ = [this, hold_this, listener, connection]() {
+            SRV_LOGC_TRACE("handle server's client disconnection");
+
+            {
+                std::lock_guard<std::mutex> lock(listener->connections_mutex);
+                listener->connections.erase(connection.get());
+            }
+
+            connection->notify_disconnected();
+        };
+        if (_callback_thread && !_callback_thread->is_this_loop())
+        {
+            _callback_thread->post_or_defer(call_);
+        }
+        else
+        {
+            call_();
+        }
+    }
+
+} // namespace network
+} // namespace server_lib
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <server_lib/network/tcp_server_i.h>
+#include <server_lib/network/asio_transport.h>
+#include <server_lib/event_loop.h>
+#include <server_lib/event_loop_pool.h>
+
+#include <boost/asio.hpp>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace server_lib {
+namespace network {
+
+    class asio_tcp_connection_impl;
+
+    class asio_tcp_server_impl : public tcp_server_i,
+                                 public std::enable_shared_from_this<asio_tcp_server_impl>
+    {
+    public:
+        asio_tcp_server_impl(const asio_server_options& options, event_loop_pool* io_loops = nullptr);
+
+        ~asio_tcp_server_impl() override;
+
+        void start(const std::string& host, uint16_t port, event_loop* callback_thread = nullptr, const on_new_connection_callback_type& callback = nullptr) override;
+
+        void stop(bool wait_for_removal = false, bool recursive_wait_for_removal = true) override;
+
+        bool is_running(void) const override;
+
+        // it is applied at next start for own loops only
+        void set_nb_workers(uint8_t nb_threads) override;
+
+        void set_worker_options(const thread_options& options) override;
+
+    private:
+        /**
+         * listening socket with connections accepted by it.
+         * There is single shard in the first I/O loop
+         * without 'sharded_listen'
+         */
+        struct shard
+        {
+            event_loop* loop = nullptr;
+            // if 'loop' is own one
+            std::shared_ptr<event_loop> own_loop;
+            std::shared_ptr<boost::asio::ip::tcp::acceptor> acceptor;
+            // accepted sockets are served in shard loop
+            bool sharded = false;
+
+            std::map<asio_tcp_connection_impl*, std::shared_ptr<asio_tcp_connection_impl>> connections;
+            std::mutex connections_mutex;
+        };
+
+        std::vector<event_loop*> listen_loops();
+
+        // 'own_loop' is set if loop is own one
+        event_loop& next_io_loop(std::shared_ptr<event_loop>& own_loop);
+
+        void accept(const std::shared_ptr<shard>&);
+        void on_new_connection(const std::shared_ptr<shard>&, boost::asio::ip::tcp::socket&&, event_loop&, const std::shared_ptr<event_loop>& own_loop);
+        void on_client_disconnected(const std::shared_ptr<shard>&, asio_tcp_connection_impl&);
+
+        const asio_server_options _options;
+        event_loop_pool* _io_loops = nullptr;
+
+        std::atomic_bool _running;
+        size_t _nb_workers = 1;
+        thread_options _worker_options;
+        // for I/O if neither pool nor callback thread are set
+        // (connections hold them too)
+        std::vector<std::shared_ptr<event_loop>> _own_loops;
+        size_t _next_loop = 0;
+
+        std::vector<std::shared_ptr<shard>> _shards;
+
+        event_loop* _callback_thread = nullptr;
+        on_new_connection_callback_type _new_connection_handler = nullptr;
+    };
+
+} // namespace network
+} // namespace server_lib
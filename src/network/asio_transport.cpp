@@ -0,0 +1,25 @@
+#include <server_lib/network/asio_transport.h>
+
+#include "asio_tcp_server_impl.h"
+#include "asio_tcp_client_impl.h"
+
+namespace server_lib {
+namespace network {
+
+    std::shared_ptr<tcp_server_i> create_asio_server(const asio_server_options& options)
+    {
+        return std::make_shared<asio_tcp_server_impl>(options);
+    }
+
+    std::shared_ptr<tcp_server_i> create_asio_server(event_loop_pool& io_loops, const asio_server_options& options)
+    {
+        return std::make_shared<asio_tcp_server_impl>(options, &io_loops);
+    }
+
+    std::shared_ptr<tcp_client_i> create_asio_client(event_loop* io_loop)
+    {
+        return std::make_shared<asio_tcp_client_impl>(io_loop);
+    }
+
+} // namespace network
+} // namespace server_lib
@@ -0,0 +1,194 @@
+#include <server_lib/network/buffer_chain.h>
+
+#include <server_lib/asserts.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace server_lib {
+namespace network {
+
+    constexpr size_t buffer_chain::npos;
+
+    buffer_view::buffer_view(std::vector<char>&& data)
+        : _size(data.size())
+    {
+        if (_size > 0)
+            _block = std::make_shared<const std::vector<char>>(std::move(data));
+    }
+
+    buffer_view::buffer_view(const std::string& data)
+        : _size(data.size())
+    {
+        if (_size > 0)
+            _block = std::make_shared<const std::vector<char>>(data.begin(), data.end());
+    }
+
+    buffer_view::buffer_view(const block_type& block, size_t offset, size_t size)
+        : _block(block)
+        , _offset(offset)
+        , _size(size)
+    {
+        SRV_ASSERT(!_size || (_block && _offset + _size <= _block->size()));
+    }
+
+    buffer_view buffer_view::slice(size_t pos, size_t len) const
+    {
+        SRV_ASSERT(pos + len <= _size);
+
+        if (!len)
+            return {};
+
+        return { _block, _offset + pos, len };
+    }
+
+    std::string buffer_view::to_string() const
+    {
+        if (empty())
+            return {};
+
+        return { data(), _size };
+    }
+
+    bool operator==(const buffer_view& a, const buffer_view& b)
+    {
+        if (a.size() != b.size())
+            return false;
+        return a.empty() || !std::memcmp(a.data(), b.data(), a.size());
+    }
+
+    void buffer_chain::append(const buffer_view& view)
+    {
+        if (view.empty())
+            return;
+
+        _views.push_back(view);
+        _size += view.size();
+    }
+
+    char buffer_chain::at(size_t pos) const
+    {
+        SRV_ASSERT(pos < _size);
+
+        for (auto&& view : _views)
+        {
+            if (pos < view.size())
+                return view.data()[pos];
+            pos -= view.size();
+        }
+        return 0;
+    }
+
+    size_t buffer_chain::find(const std::string& pattern, size_t from) const
+    {
+        if (pattern.empty() || from + pattern.size() > _size)
+            return npos;
+
+        // views before 'from' are skipped whole
+        size_t vi = 0;
+        size_t pos = 0;
+        while (pos + _views[vi].size() <= from)
+        {
+            pos += _views[vi].size();
+            ++vi;
+        }
+
+        // match is checked byte by byte to find pattern
+        // that crosses view bounds
+        size_t start = from - pos;
+        pos = from;
+        for (; vi < _views.size(); ++vi, start = 0)
+        {
+            auto& view = _views[vi];
+            for (size_t ci = start; ci < view.size(); ++ci, ++pos)
+            {
+                if (view.data()[ci] != pattern[0])
+                    continue;
+                if (pos + pattern.size() > _size)
+                    return npos;
+
+                size_t matched = 1;
+                size_t mvi = vi, mci = ci + 1;
+                while (matched < pattern.size())
+                {
+                    if (mci == _views[mvi].size())
+                    {
+                        ++mvi;
+                        mci = 0;
+                    }
+                    if (_views[mvi].data()[mci++] != pattern[matched])
+                        break;
+                    ++matched;
+                }
+                if (matched == pattern.size())
+                    return pos;
+            }
+        }
+        return npos;
+    }
+
+    buffer_view buffer_chain::slice(size_t pos, size_t len) const
+    {
+        SRV_ASSERT(pos + len <= _size);
+
+        if (!len)
+            return {};
+
+        auto it = _views.begin();
+        while (pos >= it->size())
+        {
+            pos -= it->size();
+            ++it;
+        }
+
+        if (pos + len <= it->size())
+            return it->slice(pos, len);
+
+        // unit is received by several reads
+        std::vector<char> merged;
+        merged.reserve(len);
+        for (; len > 0; ++it)
+        {
+            auto sz = std::min(len, it->size() - pos);
+            merged.insert(merged.end(), it->data() + pos, it->data() + pos + sz);
+            len -= sz;
+            pos = 0;
+        }
+        return buffer_view { std::move(merged) };
+    }
+
+    void buffer_chain::consume(size_t len)
+    {
+        SRV_ASSERT(len <= _size);
+
+        _size -= len;
+        while (len > 0)
+        {
+            auto& front = _views.front();
+            if (len < front.size())
+            {
+                front = front.slice(len, front.size() - len);
+                return;
+            }
+            len -= front.size();
+            _views.pop_front();
+        }
+    }
+
+    void buffer_chain::clear()
+    {
+        _views.clear();
+        _size = 0;
+    }
+
+    std::string buffer_chain::to_string() const
+    {
+        std::string result;
+        result.reserve(_size);
+        for (auto&& view : _views)
+            result.append(view.data(), view.size());
+        return result;
+    }
+
+} // namespace network
+} // namespace server_lib
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <server_lib/asserts.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace server_lib {
+namespace network {
+
+    /**
+     * @brief registry of server connections
+     *
+     * Slot map with O(1) insert and remove by id. Slots are spread
+     * between shards with own locks, so concurrent connections
+     * and disconnections rarely wait for each other.
+     *
+     * Id is stable while value is registered. Slot generation is stored
+     * in id, so id of removed value does not match new value
+     * that reuses the same slot
+     */
+    template <typename T>
+    class connection_registry
+    {
+    public:
+        using id_type = uint64_t;
+
+        static constexpr id_type invalid_id = 0;
+
+        connection_registry(size_t nb_shards = 16)
+        {
+            SRV_ASSERT(nb_shards > 0 && nb_shards <= max_shards);
+
+            _shards.reserve(nb_shards);
+            for (size_t ci = 0; ci < nb_shards; ++ci)
+                _shards.emplace_back(new shard);
+        }
+
+        connection_registry(const connection_registry&) = delete;
+        connection_registry& operator=(const connection_registry&) = delete;
+
+        id_type insert(T value)
+        {
+            auto shard_index = _next_shard.fetch_add(1, std::memory_order_relaxed) % _shards.size();
+            auto& s = *_shards[shard_index];
+
+            std::lock_guard<std::mutex> lock(s.mutex);
+
+            uint32_t slot_index;
+            if (!s.free_slots.empty())
+            {
+                slot_index = s.free_slots.back();
+                s.free_slots.pop_back();
+            }
+            else
+            {
+                SRV_ASSERT(s.slots.size() <= max_slot, "Too many connections");
+
+                slot_index = static_cast<uint32_t>(s.slots.size());
+                s.slots.emplace_back();
+            }
+
+            auto& slot = s.slots[slot_index];
+            slot.value = std::move(value);
+            slot.used = true;
+            ++s.size;
+
+            return make_id(shard_index, slot_index, slot.generation);
+        }
+
+        /**
+         * move registered value to 'value'
+         *
+         * @return false if id is not registered (already removed)
+         */
+        bool erase(id_type id, T& value)
+        {
+            auto shard_index = static_cast<size_t>(id & (max_shards - 1));
+            if (id == invalid_id || shard_index >= _shards.size())
+                return false;
+
+            auto& s = *_shards[shard_index];
+            auto slot_index = static_cast<uint32_t>((id >> shard_bits) & max_slot);
+            auto generation = static_cast<uint32_t>(id >> 32);
+
+            std::lock_guard<std::mutex> lock(s.mutex);
+
+            if (slot_index >= s.slots.size())
+                return false;
+
+            auto& slot = s.slots[slot_index];
+            if (!slot.used || slot.generation != generation)
+                return false;
+
+            value = std::move(slot.value);
+            release(s, slot_index);
+
+            return true;
+        }
+
+        /**
+         * move all registered values to 'values'
+         */
+        void extract_all(std::vector<T>& values)
+        {
+            for (auto&& ps : _shards)
+            {
+                auto& s = *ps;
+
+                std::lock_guard<std::mutex> lock(s.mutex);
+
+                for (size_t ci = 0; ci < s.slots.size(); ++ci)
+                {
+                    auto& slot = s.slots[ci];
+                    if (!slot.used)
+                        continue;
+
+                    values.emplace_back(std::move(slot.value));
+                    release(s, static_cast<uint32_t>(ci));
+                }
+            }
+        }
+
+        size_t size() const
+        {
+            size_t result = 0;
+            for (auto&& ps : _shards)
+            {
+                std::lock_guard<std::mutex> lock(ps->mutex);
+                result += ps->size;
+            }
+            return result;
+        }
+
+    private:
+        static constexpr size_t shard_bits = 8;
+        static constexpr size_t max_shards = 1 << shard_bits;
+        static constexpr size_t max_slot = 0xffffff;
+
+        // generation (32 bits) | slot (24 bits) | shard (8 bits).
+        // Generation starts from 1 to keep 'invalid_id'
+        static id_type make_id(size_t shard_index, uint32_t slot_index, uint32_t generation)
+        {
+            return (static_cast<id_type>(generation) << 32) | (static_cast<id_type>(slot_index) << shard_bits) | shard_index;
+        }
+
+        struct slot
+        {
+            T value {};
+            uint32_t generation = 1;
+            bool used = false;
+        };
+
+        struct shard
+        {
+            mutable std::mutex mutex;
+            std::vector<slot> slots;
+            std::vector<uint32_t> free_slots;
+            size_t size = 0;
+        };
+
+        static void release(shard& s, uint32_t slot_index)
+        {
+            auto& slot = s.slots[slot_index];
+            slot.value = T {};
+            slot.used = false;
+            // id of removed value is not valid any more
+            if (++slot.generation == 0)
+                slot.generation = 1;
+            s.free_slots.push_back(slot_index);
+            --s.size;
+        }
+
+        std::vector<std::unique_ptr<shard>> _shards;
+        std::atomic_size_t _next_shard { 0 };
+    };
+
+    // definition for ODR-use before C++17
+    template <typename T>
+    constexpr typename connection_registry<T>::id_type connection_registry<T>::invalid_id;
+
+} // namespace network
+} // namespace server_lib
@@ -26,5 +26,20 @@ namespace network {
         return *this;
     }
 
+    app_unit_builder_i& dstream_builder::operator<<(buffer_chain& network_data)
+    {
+        if (unit_ready())
+            return *this;
+
+        auto end_unit = network_data.find(_delimeter);
+        if (buffer_chain::npos == end_unit)
+            return *this;
+
+        _buffer_unit.set(network_data.slice(0, end_unit));
+        network_data.consume(end_unit + _delimeter.size());
+
+        return *this;
+    }
+
 } // namespace network
 } // namespace server_lib
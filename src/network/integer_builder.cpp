@@ -24,7 +24,9 @@ namespace network {
     }
 
     namespace impl {
-        bool unpack(const std::string& data, uint32_t& result, size_t& got)
+        // for string and buffer_chain
+        template <typename Data>
+        bool unpack(const Data& data, uint32_t& result, size_t& got)
         {
             uint64_t val = 0;
             char b = 0;
@@ -60,5 +62,21 @@ namespace network {
         return *this;
     }
 
+    app_unit_builder_i& integer_builder::operator<<(buffer_chain& network_data)
+    {
+        if (unit_ready())
+            return *this;
+
+        uint32_t value = 0;
+        size_t got = 0;
+        if (impl::unpack(network_data, value, got))
+        {
+            network_data.consume(got);
+            _unit.set(value);
+        }
+
+        return *this;
+    }
+
 } // namespace network
 } // namespace server_lib
@@ -21,9 +21,22 @@ namespace network {
     }
 
     app_unit_builder_i& msg_builder::operator<<(std::string& network_data)
+    {
+        parse(network_data);
+        return *this;
+    }
+
+    app_unit_builder_i& msg_builder::operator<<(buffer_chain& network_data)
+    {
+        parse(network_data);
+        return *this;
+    }
+
+    template <typename Data>
+    void msg_builder::parse(Data& network_data)
     {
         if (unit_ready())
-            return *this;
+            return;
 
         if (!_size_builder.unit_ready())
         {
@@ -46,8 +59,6 @@ namespace network {
         {
             _ready = true;
         }
-
-        return *this;
     }
 
     void msg_builder::reset()
@@ -14,10 +14,6 @@
 
 #define SRV_LOG_CONTEXT_ "tcp-cli> " << SRV_FUNCTION_NAME_ << ": "
 
-#ifndef SERVER_LIB_TCP_CLIENT_READ_SIZE
-#define SERVER_LIB_TCP_CLIENT_READ_SIZE 4096
-#endif /* SERVER_LIB_TCP_CLIENT_READ_SIZE */
-
 namespace server_lib {
 namespace network {
 
@@ -78,10 +74,10 @@ namespace network {
             _receive_callback = receive_callback;
 
             auto raw_connection = _transport_layer->create_connection();
-            auto connection = std::make_shared<app_connection_impl>(raw_connection, protocol_);
+            auto connection = app_connection_impl::create(raw_connection, protocol_, callback_thread, _read_options);
             connection->set_on_disconnect_handler(std::bind(&network_client::on_diconnected, this, std::placeholders::_1));
             connection->set_on_receive_handler(std::bind(&network_client::on_receive, this, std::placeholders::_1, std::placeholders::_2));
-            connection->set_callback_thread(callback_thread);
+            connection->set_auto_flush(_auto_flush);
             _connection = connection;
 
             SRV_LOGC_TRACE("connected");
@@ -102,6 +98,29 @@ namespace network {
         _transport_layer->set_nb_workers(nb_threads);
     }
 
+    void network_client::set_worker_options(const thread_options& options)
+    {
+        SRV_LOGC_TRACE("changed options of workers");
+
+        _transport_layer->set_worker_options(options);
+    }
+
+    void network_client::set_read_options(const read_options& options)
+    {
+        SRV_LOGC_TRACE("changed read options");
+
+        _read_options = options;
+    }
+
+    void network_client::set_auto_flush(bool enable)
+    {
+        SRV_LOGC_TRACE("changed auto-flush mode");
+
+        _auto_flush = enable;
+        if (_connection)
+            _connection->set_auto_flush(enable);
+    }
+
     void network_client::disconnect(bool wait_for_removal)
     {
         SRV_LOGC_TRACE("attempts to disconnect");
@@ -150,7 +169,7 @@ namespace network {
         };
         if (_callback_thread)
         {
-            _callback_thread->post(call_);
+            _callback_thread->post_or_defer(call_);
         }
         else
         {
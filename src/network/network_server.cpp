@@ -42,6 +42,28 @@ namespace network {
                                event_loop* callback_thread,
                                const on_new_connection_callback_type& callback,
                                uint8_t nb_threads)
+    {
+        return start_impl(host, port, protocol, callback_thread, nullptr, callback, nb_threads);
+    }
+
+    bool network_server::start(const std::string& host,
+                               uint16_t port,
+                               const app_unit_builder_i* protocol,
+                               event_loop_pool& callback_threads,
+                               const on_new_connection_callback_type& callback,
+                               uint8_t nb_threads)
+    {
+        //connections are dispatched to pool loops in 'on_new_connection'
+        return start_impl(host, port, protocol, nullptr, &callback_threads, callback, nb_threads);
+    }
+
+    bool network_server::start_impl(const std::string& host,
+                                    uint16_t port,
+                                    const app_unit_builder_i* protocol,
+                                    event_loop* callback_thread,
+                                    event_loop_pool* callback_threads,
+                                    const on_new_connection_callback_type& callback,
+                                    uint8_t nb_threads)
     {
         try
         {
@@ -60,6 +82,7 @@ namespace network {
             if (nb_threads > 0)
                 _transport_layer->set_nb_workers(nb_threads);
             _callback_thread = callback_thread;
+            _callback_threads = callback_threads;
             _transport_layer->start(host, port, callback_thread, new_connection_handler);
 
             SRV_LOGC_TRACE("started");
@@ -81,6 +104,20 @@ namespace network {
         _transport_layer->set_nb_workers(nb_threads);
     }
 
+    void network_server::set_worker_options(const thread_options& options)
+    {
+        SRV_LOGC_TRACE("changed options of workers");
+
+        _transport_layer->set_worker_options(options);
+    }
+
+    void network_server::set_read_options(const read_options& options)
+    {
+        SRV_LOGC_TRACE("changed read options");
+
+        _read_options = options;
+    }
+
     void network_server::stop(bool wait_for_removal, bool recursive_wait_for_removal)
     {
         if (!is_running())
@@ -106,6 +143,24 @@ namespace network {
         return *_protocol;
     }
 
+    event_loop& network_server::pool_loop(const tcp_connection_i& raw_connection)
+    {
+        SRV_ASSERT(_callback_threads);
+
+        // callbacks run in I/O loop of connection if it is pool loop
+        auto* io_loop = raw_connection.io_loop();
+        if (io_loop)
+        {
+            for (size_t ci = 0; ci < _callback_threads->size(); ++ci)
+            {
+                if (&_callback_threads->loop(ci) == io_loop)
+                    return *io_loop;
+            }
+        }
+
+        return _callback_threads->next_loop();
+    }
+
     void network_server::on_new_connection(const std::shared_ptr<tcp_connection_i>& raw_connection)
     {
         if (!is_running())
@@ -116,11 +171,36 @@ namespace network {
         SRV_LOGC_TRACE("handle new client connection");
 
         SRV_ASSERT(raw_connection);
-        auto connection = std::make_shared<app_connection_impl>(raw_connection, _protocol);
-        SRV_ASSERT(connection);
         SRV_ASSERT(_new_connection_handler);
-        connection->set_callback_thread(_callback_thread);
-        _new_connection_handler(connection);
+        if (_callback_threads)
+        {
+            auto& callback_thread = pool_loop(*raw_connection);
+            // connection starts reading when it is created, thus handler
+            // should be set in the same handler before any received unit
+            auto call_ = [raw_connection, protocol = _protocol, &callback_thread, read_options = _read_options, new_connection_handler = _new_connection_handler]() {
+                auto connection = app_connection_impl::create(raw_connection, protocol, &callback_thread, read_options);
+                SRV_ASSERT(connection);
+                new_connection_handler(connection);
+            };
+            if (callback_thread.is_this_loop())
+            {
+                call_();
+                return;
+            }
+            // connection must not be lost by overflow policy
+            if (!callback_thread.post_or_defer(std::move(call_)))
+            {
+                SRV_LOGC_WARN("connection is rejected by callback loop");
+
+                raw_connection->disconnect();
+            }
+        }
+        else
+        {
+            auto connection = app_connection_impl::create(raw_connection, _protocol, _callback_thread, _read_options);
+            SRV_ASSERT(connection);
+            _new_connection_handler(connection);
+        }
     }
 
 } // namespace network
@@ -57,10 +57,9 @@ namespace network {
                                          std::placeholders::_2);
 
         auto raw_connection = _transport_layer->create_connection();
-        auto connection = std::make_shared<app_connection_impl>(raw_connection, _protocol);
+        auto connection = app_connection_impl::create(raw_connection, _protocol, _callback_thread, _read_options);
         connection->set_on_disconnect_handler(disconnection_handler);
         connection->set_on_receive_handler(receive_handler);
-        connection->set_callback_thread(_callback_thread);
         _connection = connection;
     }
 
@@ -141,6 +140,20 @@ namespace network {
         _transport_layer->set_nb_workers(nb_threads);
     }
 
+    void persist_network_client::set_worker_options(const thread_options& options)
+    {
+        SRV_LOGC_TRACE("changed options of workers");
+
+        _transport_layer->set_worker_options(options);
+    }
+
+    void persist_network_client::set_read_options(const read_options& options)
+    {
+        SRV_LOGC_TRACE("changed read options");
+
+        _read_options = options;
+    }
+
     void persist_network_client::disconnect(bool wait_for_removal)
     {
         SRV_LOGC_TRACE("attempts to disconnect");
@@ -430,7 +443,8 @@ namespace network {
         };
         if (_callback_thread)
         {
-            _callback_thread->post(call_);
+            // failure notifications should not wait for queued data
+            _callback_thread->post(event_loop::priority::high, call_);
         }
         else
         {
@@ -33,8 +33,21 @@ namespace network {
         return *this;
     }
 
+    app_unit_builder_i& raw_builder::operator<<(buffer_chain& network_data)
+    {
+        if (unit_ready() || network_data.empty())
+            return *this;
+
+        _view = network_data.slice(0, network_data.size());
+        network_data.clear();
+
+        return *this;
+    }
+
     app_unit raw_builder::get_unit() const
     {
+        if (!_view.empty())
+            return { _view };
         if (unit_ready())
             return { _buffer };
 
@@ -38,6 +38,39 @@ namespace network {
         return *this;
     }
 
+    app_unit_builder_i& string_builder::operator<<(buffer_chain& network_data)
+    {
+        if (_ready)
+            return *this;
+
+        SRV_ASSERT(_buffer.size() <= _size);
+
+        // wait for whole string to take it as single slice
+        size_t left = _size - _buffer.size();
+        if (network_data.size() < left)
+            return *this;
+
+        if (_buffer.empty())
+        {
+            if (_size > 0)
+                _unit.set(network_data.slice(0, _size));
+            else
+                _unit.set();
+        }
+        else
+        {
+            // it was started by string data
+            _buffer.append(network_data.slice(0, left).to_string());
+            _unit.set(_buffer);
+            _buffer.clear();
+        }
+        network_data.consume(left);
+
+        _ready = true;
+
+        return *this;
+    }
+
     void string_builder::reset()
     {
         _unit.set(false);
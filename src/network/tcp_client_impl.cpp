@@ -49,13 +49,18 @@ namespace network {
         _impl.get_io_service()->set_nb_workers(static_cast<size_t>(nb_threads));
     }
 
+    void tcp_client_impl::set_worker_options(const thread_options& options)
+    {
+        _worker_options->set(options);
+    }
+
     std::shared_ptr<tcp_connection_i> tcp_client_impl::create_connection()
     {
         SRV_LOGC_TRACE("attempts to create connection");
 
         SRV_ASSERT(is_connected());
 
-        _connection = std::make_shared<tcp_connection_impl>(&_impl);
+        _connection = std::make_shared<tcp_connection_impl>(&_impl, _worker_options);
         return std::static_pointer_cast<tcp_connection_i>(_connection);
     }
 
@@ -78,7 +83,7 @@ namespace network {
     {
         if (_connection)
         {
-            _connection->disconnect();
+            _connection->notify_disconnected();
             _connection.reset();
         }
     }
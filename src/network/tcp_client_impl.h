@@ -22,6 +22,8 @@ namespace network {
 
         void set_nb_workers(uint8_t nb_threads) override;
 
+        void set_worker_options(const thread_options& options) override;
+
         std::shared_ptr<tcp_connection_i> create_connection() override;
 
         void set_on_disconnection_handler(const disconnection_callback_type& disconnection_handler) override;
@@ -34,6 +36,8 @@ namespace network {
 
         disconnection_callback_type _disconnection_callback;
         std::shared_ptr<tcp_connection_impl> _connection;
+
+        std::shared_ptr<deferred_thread_options> _worker_options = std::make_shared<deferred_thread_options>();
     };
 
 } // namespace network
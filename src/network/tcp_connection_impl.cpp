@@ -1,8 +1,15 @@
 #include "tcp_connection_impl.h"
 
+#include <server_lib/platform_config.h>
 #include <server_lib/asserts.h>
 #include <server_lib/logging_helper.h>
 
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#endif
+
 #ifdef SRV_LOG_CONTEXT_
 #undef SRV_LOG_CONTEXT_
 #endif // #ifdef SRV_LOG_CONTEXT_
@@ -14,8 +21,9 @@
 namespace server_lib {
 namespace network {
 
-    tcp_connection_impl::tcp_connection_impl(tacopie::tcp_client* ptcp)
+    tcp_connection_impl::tcp_connection_impl(tacopie::tcp_client* ptcp, const std::shared_ptr<deferred_thread_options>& worker_options)
         : _ptcp(ptcp)
+        , _worker_options(worker_options)
     {
         SRV_ASSERT(_ptcp);
 
@@ -37,8 +45,12 @@ namespace network {
         SRV_ASSERT(_ptcp);
 
         auto callback = std::move(request.async_read_callback);
+        auto worker_options = _worker_options;
 
         _ptcp->async_read({ request.size, [=](tacopie::tcp_client::read_result& result) {
+                               if (worker_options)
+                                   worker_options->apply();
+
                                if (!callback)
                                {
                                    return;
@@ -53,9 +65,16 @@ namespace network {
     {
         SRV_ASSERT(_ptcp);
 
+        // tacopie has not gather write
+        flatten(request);
+
         auto callback = std::move(request.async_write_callback);
+        auto worker_options = _worker_options;
 
         _ptcp->async_write({ std::move(request.buffer), [=](tacopie::tcp_client::write_result& result) {
+                                if (worker_options)
+                                    worker_options->apply();
+
                                 if (!callback)
                                 {
                                     return;
@@ -71,10 +90,46 @@ namespace network {
         _disconnection_callback = callback;
     }
 
+    void tcp_connection_impl::set_no_delay(bool enable)
+    {
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+        if (!_ptcp)
+            return;
+
+        int value = enable ? 1 : 0;
+        ::setsockopt(_ptcp->get_socket().get_fd(), IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value));
+#else
+        (void)enable;
+#endif
+    }
+
+    void tcp_connection_impl::set_cork(bool enable)
+    {
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+        if (!_ptcp)
+            return;
+
+        int value = enable ? 1 : 0;
+        ::setsockopt(_ptcp->get_socket().get_fd(), IPPROTO_TCP, TCP_CORK, &value, sizeof(value));
+#else
+        (void)enable;
+#endif
+    }
+
     void tcp_connection_impl::disconnect()
     {
+        if (!_ptcp)
+            return;
+
         SRV_LOGC_TRACE("disconnect");
 
+        _ptcp->disconnect(false);
+    }
+
+    void tcp_connection_impl::notify_disconnected()
+    {
+        SRV_LOGC_TRACE("disconnected");
+
         if (_disconnection_callback)
             _disconnection_callback(*this);
 
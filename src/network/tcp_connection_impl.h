@@ -1,4 +1,7 @@
 #include <server_lib/network/tcp_connection_i.h>
+#include <server_lib/thread_options.h>
+
+#include <memory>
 
 namespace tacopie {
 class tcp_client;
@@ -10,7 +13,7 @@ namespace network {
     class tcp_connection_impl : public tcp_connection_i
     {
     public:
-        tcp_connection_impl(tacopie::tcp_client*);
+        tcp_connection_impl(tacopie::tcp_client*, const std::shared_ptr<deferred_thread_options>& worker_options = nullptr);
 
         ~tcp_connection_impl() override;
 
@@ -22,10 +25,18 @@ namespace network {
 
         void set_on_disconnect_handler(const disconnection_callback_type&) override;
 
-        void disconnect();
+        void set_no_delay(bool) override;
+
+        void set_cork(bool) override;
+
+        void disconnect() override;
+
+        // call disconnection handler
+        void notify_disconnected();
 
     private:
         tacopie::tcp_client* _ptcp = nullptr;
+        std::shared_ptr<deferred_thread_options> _worker_options;
 
         disconnection_callback_type _disconnection_callback = nullptr;
     };
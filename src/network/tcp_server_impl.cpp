@@ -4,8 +4,6 @@
 
 #include "tcp_connection_impl.h"
 
-#include <algorithm>
-
 #include <server_lib/asserts.h>
 #include <server_lib/logging_helper.h>
 
@@ -52,21 +50,16 @@ namespace network {
 
         _impl.stop(wait_for_removal, recursive_wait_for_removal);
 
-        std::lock_guard<std::mutex> lock(_clients_mutex);
-        for (auto& client : _clients)
+        std::vector<client_entry> clients;
+        _clients.extract_all(clients);
+        for (auto& entry : clients)
         {
-            client->disconnect(recursive_wait_for_removal && wait_for_removal);
+            entry.client->disconnect(recursive_wait_for_removal && wait_for_removal);
             if (recursive_wait_for_removal)
             {
-                auto it_connection = _connections.find(client);
-                if (it_connection != _connections.end())
-                {
-                    it_connection->second->disconnect();
-                }
+                entry.connection->notify_disconnected();
             }
         }
-        _clients.clear();
-        _connections.clear();
 
         SRV_LOGC_TRACE("stopped");
     }
@@ -81,31 +74,35 @@ namespace network {
         _impl.get_io_service()->set_nb_workers(static_cast<size_t>(nb_threads));
     }
 
+    void tcp_server_impl::set_worker_options(const thread_options& options)
+    {
+        _worker_options->set(options);
+    }
+
     bool tcp_server_impl::on_new_connection(const std::shared_ptr<tacopie::tcp_client>& client)
     {
         if (!client)
             return false;
 
+        _worker_options->apply();
+
         auto hold_this = shared_from_this();
         auto call_ = [this, hold_this, client]() {
             SRV_LOGC_TRACE("handle new client connection (" << reinterpret_cast<uint64_t>(client.get()) << ")");
 
-            client->set_on_disconnection_handler(std::bind(&tcp_server_impl::on_client_disconnected, this, client));
-
-            std::lock_guard<std::mutex> lock(_clients_mutex);
+            auto connection = std::make_shared<tcp_connection_impl>(client.get(), _worker_options);
+            auto id = _clients.insert({ client, connection });
 
-            _clients.push_back(client);
-            auto connection = std::make_shared<tcp_connection_impl>(client.get());
-            _connections.emplace(client, connection);
+            client->set_on_disconnection_handler(std::bind(&tcp_server_impl::on_client_disconnected, this, id));
 
-            SRV_LOGC_TRACE("clients = " << _clients.size() << ", connections = " << _connections.size());
+            SRV_LOGC_TRACE("client id = " << id);
 
             SRV_ASSERT(_new_connection_handler);
             _new_connection_handler(connection);
         };
         if (_callback_thread)
         {
-            _callback_thread->post(call_);
+            _callback_thread->post_or_defer(call_);
         }
         else
         {
@@ -115,7 +112,7 @@ namespace network {
         return true; //manage clients only in this class
     }
 
-    void tcp_server_impl::on_client_disconnected(const std::shared_ptr<tacopie::tcp_client>& client)
+    void tcp_server_impl::on_client_disconnected(uint64_t id)
     {
         if (!is_running())
         {
@@ -123,26 +120,18 @@ namespace network {
         }
 
         auto hold_this = shared_from_this();
-        auto call_ = [this, hold_this, client]() {
-            SRV_LOGC_TRACE("handle server's client disconnection");
-
-            std::lock_guard<std::mutex> lock(_clients_mutex);
-            auto it = std::find(_clients.begin(), _clients.end(), client);
+        auto call_ = [this, hold_this, id]() {
+            SRV_LOGC_TRACE("handle server's client disconnection (id = " << id << ")");
 
-            if (it != _clients.end())
+            client_entry entry;
+            if (_clients.erase(id, entry))
             {
-                auto it_connection = _connections.find(client);
-                if (it_connection != _connections.end())
-                {
-                    it_connection->second->disconnect();
-                    _connections.erase(it_connection);
-                }
-                _clients.erase(it);
+                entry.connection->notify_disconnected();
             }
         };
         if (_callback_thread)
         {
-            _callback_thread->post(call_);
+            _callback_thread->post_or_defer(call_);
         }
         else
         {
@@ -1,10 +1,8 @@
 #include <server_lib/network/tcp_server_i.h>
 
-#include <tacopie/tacopie>
+#include "connection_registry.h"
 
-#include <mutex>
-#include <list>
-#include <map>
+#include <tacopie/tacopie>
 
 namespace server_lib {
 namespace network {
@@ -25,18 +23,26 @@ namespace network {
 
         void set_nb_workers(uint8_t nb_threads) override;
 
+        void set_worker_options(const thread_options& options) override;
+
     private:
         bool on_new_connection(const std::shared_ptr<tacopie::tcp_client>&);
-        void on_client_disconnected(const std::shared_ptr<tacopie::tcp_client>& client);
+        void on_client_disconnected(uint64_t id);
 
         tacopie::tcp_server _impl;
 
         event_loop* _callback_thread = nullptr;
         on_new_connection_callback_type _new_connection_handler = nullptr;
 
-        std::list<std::shared_ptr<tacopie::tcp_client>> _clients;
-        std::map<std::shared_ptr<tacopie::tcp_client>, std::shared_ptr<tcp_connection_impl>> _connections;
-        std::mutex _clients_mutex;
+        struct client_entry
+        {
+            std::shared_ptr<tacopie::tcp_client> client;
+            std::shared_ptr<tcp_connection_impl> connection;
+        };
+
+        connection_registry<client_entry> _clients;
+
+        std::shared_ptr<deferred_thread_options> _worker_options = std::make_shared<deferred_thread_options>();
     };
 
 } // namespace network
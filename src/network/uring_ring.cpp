@@ -0,0 +1,466 @@
+#include "uring_ring.h"
+
+#include <server_lib/asserts.h>
+#include <server_lib/logging_helper.h>
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <future>
+
+#ifdef SRV_LOG_CONTEXT_
+#undef SRV_LOG_CONTEXT_
+#endif // #ifdef SRV_LOG_CONTEXT_
+
+#define SRV_LOG_CONTEXT_ "uring> " << SRV_FUNCTION_NAME_ << ": "
+
+namespace server_lib {
+namespace network {
+
+    namespace {
+        int sys_io_uring_setup(unsigned entries, io_uring_params* params)
+        {
+            return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+        }
+
+        int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+        {
+            return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+        }
+
+        int sys_io_uring_register(int fd, unsigned opcode, const void* arg, unsigned nr_args)
+        {
+            return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+        }
+
+        template <typename T>
+        T* ring_field(void* ring, const uint32_t offset)
+        {
+            return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+        }
+    } // namespace
+
+    class uring_ring::wakeup_operation : public uring_operation
+    {
+    public:
+        wakeup_operation(uring_ring& ring)
+            : _ring(ring)
+        {
+        }
+
+        bool complete(int, uint32_t) override
+        {
+            _ring.arm_wakeup();
+            // it is owned by ring
+            return false;
+        }
+
+        uint64_t value = 0;
+
+    private:
+        uring_ring& _ring;
+    };
+
+    uring_ring::uring_ring(const uring_options& options, const std::shared_ptr<deferred_thread_options>& worker_options)
+        : _options(options)
+        , _worker_options(worker_options)
+        , _running(false)
+    {
+        SRV_ASSERT(_options.queue_depth > 0);
+    }
+
+    uring_ring::~uring_ring()
+    {
+        if (_thread.joinable())
+        {
+            stop();
+            // the last owner could be ring thread itself
+            if (is_this_thread())
+                _thread.detach();
+            else
+                _thread.join();
+        }
+        release();
+    }
+
+    bool uring_ring::is_supported()
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        int fd = sys_io_uring_setup(4, &params);
+        if (fd < 0)
+            return false;
+
+        // IORING_OP_SOCKET came with multishot accept (5.19)
+        const size_t ops_len = 256;
+        std::vector<char> probe_memory(sizeof(io_uring_probe) + ops_len * sizeof(io_uring_probe_op), 0);
+        auto* probe = reinterpret_cast<io_uring_probe*>(probe_memory.data());
+        bool result = sys_io_uring_register(fd, IORING_REGISTER_PROBE, probe, ops_len) == 0
+                      && probe->last_op >= IORING_OP_SOCKET
+                      && (probe->ops[IORING_OP_SOCKET].flags & IO_URING_OP_SUPPORTED);
+        ::close(fd);
+        return result;
+    }
+
+    void uring_ring::start(const std::string& name)
+    {
+        SRV_ASSERT(!_thread.joinable(), "Ring is already started");
+
+        std::promise<std::string> setup_result;
+        auto setup_error = setup_result.get_future();
+
+        auto self = shared_from_this();
+        _thread = std::thread([self, name, &setup_result]() {
+            // ring is created by its thread to be single issuer
+            try
+            {
+                self->setup();
+            }
+            catch (const std::exception& e)
+            {
+                setup_result.set_value(e.what());
+                return;
+            }
+
+            pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+            self->_id.store(std::this_thread::get_id());
+            self->_running = true;
+            setup_result.set_value({});
+
+            self->run();
+
+            self->_running = false;
+        });
+
+        auto error = setup_error.get();
+        if (!error.empty())
+        {
+            _thread.join();
+            SRV_THROW_EXCEPTION(std::runtime_error, error);
+        }
+    }
+
+    void uring_ring::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_tasks_guard);
+            if (_stopping)
+                return;
+            _stopping = true;
+        }
+
+        if (_wakeup_fd >= 0)
+        {
+            uint64_t value = 1;
+            if (::write(_wakeup_fd, &value, sizeof(value)) != sizeof(value))
+                SRV_LOGC_ERROR("Can't wake up ring thread");
+        }
+
+        if (_thread.joinable() && !is_this_thread())
+            _thread.join();
+    }
+
+    bool uring_ring::is_running() const
+    {
+        return _running.load();
+    }
+
+    bool uring_ring::is_this_thread() const
+    {
+        return _id.load() == std::this_thread::get_id();
+    }
+
+    bool uring_ring::post(small_handler&& task)
+    {
+        if (is_this_thread())
+        {
+            if (_stopping)
+                return false;
+            task();
+            return true;
+        }
+
+        bool wakeup = false;
+        {
+            std::lock_guard<std::mutex> lock(_tasks_guard);
+            if (_stopping || !_running)
+                return false;
+            // the first task wakes ring up, others are taken by the same wakeup
+            wakeup = _tasks.empty();
+            _tasks.emplace_back(std::move(task));
+        }
+
+        if (wakeup)
+        {
+            uint64_t value = 1;
+            if (::write(_wakeup_fd, &value, sizeof(value)) != sizeof(value))
+                SRV_LOGC_ERROR("Can't wake up ring thread");
+        }
+        return true;
+    }
+
+    io_uring_sqe* uring_ring::get_sqe(uring_operation* operation)
+    {
+        SRV_ASSERT(operation);
+
+        if (_canceled)
+            return nullptr;
+
+        auto* sqe = next_sqe();
+        sqe->user_data = reinterpret_cast<uint64_t>(operation);
+        ++_inflight;
+        return sqe;
+    }
+
+    io_uring_sqe* uring_ring::next_sqe()
+    {
+        auto head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+        if (_sq_local_tail - head >= _sq_entries)
+        {
+            // submission queue is full, it is consumed by submit immediately
+            submit_and_wait(0);
+            head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+            SRV_ASSERT(_sq_local_tail - head < _sq_entries, "Submission queue overflow");
+        }
+
+        auto* sqe = &_sqes[_sq_local_tail & _sq_mask];
+        std::memset(sqe, 0, sizeof(*sqe));
+        ++_sq_local_tail;
+        return sqe;
+    }
+
+    void uring_ring::setup()
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        params.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN;
+        _fd = sys_io_uring_setup(_options.queue_depth, &params);
+        if (_fd < 0 && errno == EINVAL)
+        {
+            // kernel older than 6.0
+            std::memset(&params, 0, sizeof(params));
+            _fd = sys_io_uring_setup(_options.queue_depth, &params);
+        }
+        if (_fd < 0)
+            SRV_THROW_EXCEPTION(std::runtime_error, std::string { "io_uring_setup failed: " } + std::strerror(errno));
+
+        _sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        _cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+            _sq_ring_size = _cq_ring_size = std::max(_sq_ring_size, _cq_ring_size);
+
+        auto map = [this](size_t size, off_t offset) {
+            void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, offset);
+            if (p == MAP_FAILED)
+                SRV_THROW_EXCEPTION(std::runtime_error, std::string { "io_uring mmap failed: " } + std::strerror(errno));
+            return p;
+        };
+
+        _sq_ring = map(_sq_ring_size, IORING_OFF_SQ_RING);
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+            _cq_ring = _sq_ring;
+        else
+            _cq_ring = map(_cq_ring_size, IORING_OFF_CQ_RING);
+        _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        _sqes = static_cast<io_uring_sqe*>(map(_sqes_size, IORING_OFF_SQES));
+
+        _sq_head = ring_field<unsigned>(_sq_ring, params.sq_off.head);
+        _sq_tail = ring_field<unsigned>(_sq_ring, params.sq_off.tail);
+        _sq_mask = *ring_field<unsigned>(_sq_ring, params.sq_off.ring_mask);
+        _sq_entries = *ring_field<unsigned>(_sq_ring, params.sq_off.ring_entries);
+        _cq_head = ring_field<unsigned>(_cq_ring, params.cq_off.head);
+        _cq_tail = ring_field<unsigned>(_cq_ring, params.cq_off.tail);
+        _cq_mask = *ring_field<unsigned>(_cq_ring, params.cq_off.ring_mask);
+        _cqes = ring_field<io_uring_cqe>(_cq_ring, params.cq_off.cqes);
+
+        // SQE index is the same as its position in ring
+        auto* sq_array = ring_field<unsigned>(_sq_ring, params.sq_off.array);
+        for (unsigned ci = 0; ci < _sq_entries; ++ci)
+            sq_array[ci] = ci;
+        _sq_local_tail = _sq_submitted = *_sq_tail;
+
+        _wakeup_fd = ::eventfd(0, EFD_CLOEXEC);
+        if (_wakeup_fd < 0)
+            SRV_THROW_EXCEPTION(std::runtime_error, std::string { "eventfd failed: " } + std::strerror(errno));
+        _wakeup.reset(new wakeup_operation(*this));
+        arm_wakeup();
+    }
+
+    void uring_ring::release()
+    {
+        if (_fd >= 0)
+        {
+            ::close(_fd);
+            _fd = -1;
+        }
+        if (_sqes)
+            ::munmap(_sqes, _sqes_size);
+        if (_cq_ring && _cq_ring != _sq_ring)
+            ::munmap(_cq_ring, _cq_ring_size);
+        if (_sq_ring)
+            ::munmap(_sq_ring, _sq_ring_size);
+        _sqes = nullptr;
+        _sq_ring = _cq_ring = nullptr;
+
+        if (_wakeup_fd >= 0)
+        {
+            ::close(_wakeup_fd);
+            _wakeup_fd = -1;
+        }
+    }
+
+    void uring_ring::run()
+    {
+        SRV_LOGC_TRACE("started");
+
+        for (;;)
+        {
+            if (_worker_options)
+                _worker_options->apply();
+
+            if (!run_tasks())
+            {
+                if (!_canceled)
+                    cancel_all();
+                // wait for canceled operations
+                if (!_inflight)
+                    break;
+            }
+
+            submit_and_wait(1);
+            process_completions();
+        }
+
+        SRV_LOGC_TRACE("stopped");
+    }
+
+    bool uring_ring::run_tasks()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_tasks_guard);
+            _running_tasks.swap(_tasks);
+            if (_stopping)
+            {
+                // tasks are dropped
+                _running_tasks.clear();
+                return false;
+            }
+        }
+
+        for (auto&& task : _running_tasks)
+        {
+            try
+            {
+                task();
+            }
+            catch (const std::exception& e)
+            {
+                SRV_LOGC_ERROR("Catched unexpected exception: " << e.what());
+            }
+        }
+        _running_tasks.clear();
+        return true;
+    }
+
+    void uring_ring::submit_and_wait(unsigned wait_nr)
+    {
+        __atomic_store_n(_sq_tail, _sq_local_tail, __ATOMIC_RELEASE);
+
+        auto to_submit = _sq_local_tail - _sq_submitted;
+        if (!to_submit && !wait_nr)
+            return;
+
+        int result = sys_io_uring_enter(_fd, to_submit, wait_nr, wait_nr ? IORING_ENTER_GETEVENTS : 0);
+        if (result >= 0)
+        {
+            _sq_submitted += static_cast<unsigned>(result);
+            return;
+        }
+
+        switch (errno)
+        {
+        case EINTR:
+            break;
+        case EAGAIN:
+        case EBUSY:
+            // completion queue is overflowed. Completions are processed before retry
+            break;
+        default:
+            SRV_LOGC_ERROR("io_uring_enter failed: " << std::strerror(errno));
+        }
+    }
+
+    void uring_ring::process_completions()
+    {
+        auto head = *_cq_head;
+        for (;;)
+        {
+            auto tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+            if (head == tail)
+                break;
+
+            for (; head != tail; ++head)
+            {
+                const auto& cqe = _cqes[head & _cq_mask];
+                auto* operation = reinterpret_cast<uring_operation*>(cqe.user_data);
+                auto res = cqe.res;
+                auto flags = cqe.flags;
+
+                // CQE slot could be reused by operations submitted from completion
+                __atomic_store_n(_cq_head, head + 1, __ATOMIC_RELEASE);
+
+                if (!operation)
+                    continue;
+
+                bool more = (flags & IORING_CQE_F_MORE) != 0;
+                if (!more)
+                    --_inflight;
+
+                bool finished = !more;
+                try
+                {
+                    finished = operation->complete(res, flags) && !more;
+                }
+                catch (const std::exception& e)
+                {
+                    SRV_LOGC_ERROR("Catched unexpected exception: " << e.what());
+                }
+                if (finished)
+                    delete operation;
+            }
+        }
+    }
+
+    void uring_ring::arm_wakeup()
+    {
+        if (_canceled)
+            return;
+
+        auto* sqe = get_sqe(_wakeup.get());
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = _wakeup_fd;
+        sqe->addr = reinterpret_cast<uint64_t>(&_wakeup->value);
+        sqe->len = sizeof(_wakeup->value);
+    }
+
+    void uring_ring::cancel_all()
+    {
+        SRV_LOGC_TRACE("cancel " << _inflight << " operations");
+
+        auto* sqe = next_sqe();
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+        sqe->user_data = 0;
+
+        _canceled = true;
+    }
+
+} // namespace network
+} // namespace server_lib
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <server_lib/network/uring_transport.h>
+#include <server_lib/handler_allocator.h>
+#include <server_lib/thread_options.h>
+
+#include <linux/io_uring.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace server_lib {
+namespace network {
+
+    /**
+     * @brief target of io_uring completion
+     */
+    class uring_operation
+    {
+    public:
+        virtual ~uring_operation() = default;
+
+        /**
+         * @param res result of operation or -errno
+         * @param flags CQE flags
+         * @return true if operation is finished and it should be destroyed.
+         * Operation that resubmits itself returns false
+         */
+        virtual bool complete(int res, uint32_t flags) = 0;
+    };
+
+    /**
+     * @brief io_uring instance with own worker thread
+     *
+     * SQEs are prepared in ring thread only. Other threads post tasks that
+     * are run by ring thread. All SQEs prepared while ring thread processes
+     * completions and tasks are submitted by single io_uring_enter call
+     * that also waits for next completion.
+     * Ring is used without liburing (by raw syscalls)
+     */
+    class uring_ring : public std::enable_shared_from_this<uring_ring>
+    {
+    public:
+        uring_ring(const uring_options&, const std::shared_ptr<deferred_thread_options>& worker_options);
+
+        ~uring_ring();
+
+        uring_ring(const uring_ring&) = delete;
+        uring_ring& operator=(const uring_ring&) = delete;
+
+        static bool is_supported();
+
+        void start(const std::string& name);
+
+        /**
+         * cancel all operations and stop ring thread
+         * it waits for ring thread if it is called from other thread.
+         * In ring thread it returns at once, thread finishes
+         * after current task or callback
+         */
+        void stop();
+
+        bool is_running() const;
+
+        // ring is stopping and operations should not be resubmitted
+        bool is_stopping() const
+        {
+            return _canceled;
+        }
+
+        bool is_this_thread() const;
+
+        /**
+         * run task in ring thread (immediately if it is ring thread)
+         *
+         * @return false if ring is stopped (task is not run)
+         */
+        bool post(small_handler&& task);
+
+    public:
+        // For ring thread only
+
+        /**
+         * get SQE for operation. Ring owns operation until it is finished.
+         * It returns nullptr if ring is stopping
+         */
+        io_uring_sqe* get_sqe(uring_operation*);
+
+    private:
+        class wakeup_operation;
+
+        void setup();
+        void release();
+        io_uring_sqe* next_sqe();
+
+        void run();
+        bool run_tasks();
+        void submit_and_wait(unsigned wait_nr);
+        void process_completions();
+        void arm_wakeup();
+        void cancel_all();
+
+        const uring_options _options;
+        std::shared_ptr<deferred_thread_options> _worker_options;
+
+        int _fd = -1;
+        void* _sq_ring = nullptr;
+        size_t _sq_ring_size = 0;
+        void* _cq_ring = nullptr;
+        size_t _cq_ring_size = 0;
+        io_uring_sqe* _sqes = nullptr;
+        size_t _sqes_size = 0;
+
+        // shared with kernel
+        unsigned* _sq_head = nullptr;
+        unsigned* _sq_tail = nullptr;
+        unsigned _sq_mask = 0;
+        unsigned _sq_entries = 0;
+        unsigned* _cq_head = nullptr;
+        unsigned* _cq_tail = nullptr;
+        unsigned _cq_mask = 0;
+        io_uring_cqe* _cqes = nullptr;
+
+        // prepared but not submitted SQEs are [_sq_submitted, _sq_local_tail)
+        unsigned _sq_local_tail = 0;
+        unsigned _sq_submitted = 0;
+
+        // operations that are waiting for completion
+        size_t _inflight = 0;
+
+        int _wakeup_fd = -1;
+        std::unique_ptr<wakeup_operation> _wakeup;
+
+        std::mutex _tasks_guard;
+        std::vector<small_handler> _tasks;
+        std::vector<small_handler> _running_tasks;
+        // it is read by ring thread without lock
+        std::atomic_bool _stopping { false };
+        bool _canceled = false;
+
+        std::atomic_bool _running;
+        std::atomic<std::thread::id> _id;
+        std::thread _thread;
+    };
+
+} // namespace network
+} // namespace server_lib
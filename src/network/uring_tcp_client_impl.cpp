@@ -0,0 +1,206 @@
+#include "uring_tcp_client_impl.h"
+
+#include "uring_tcp_connection_impl.h"
+
+#include <server_lib/asserts.h>
+#include <server_lib/logging_helper.h>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef SRV_LOG_CONTEXT_
+#undef SRV_LOG_CONTEXT_
+#endif // #ifdef SRV_LOG_CONTEXT_
+
+#define SRV_LOG_CONTEXT_ "uring-cli-impl> " << SRV_FUNCTION_NAME_ << ": "
+
+namespace server_lib {
+namespace network {
+
+    namespace {
+        // connect with timeout. Socket is blocking after connect
+        int connect_socket(const addrinfo& address, uint32_t timeout_ms)
+        {
+            int fd = ::socket(address.ai_family, address.ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK, address.ai_protocol);
+            if (fd < 0)
+                return -1;
+
+            int result = ::connect(fd, address.ai_addr, address.ai_addrlen);
+            if (result != 0 && errno == EINPROGRESS)
+            {
+                pollfd descriptor = { fd, POLLOUT, 0 };
+                result = ::poll(&descriptor, 1, timeout_ms ? static_cast<int>(timeout_ms) : -1);
+                if (result == 1)
+                {
+                    int error = 0;
+                    socklen_t error_size = sizeof(error);
+                    result = ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &error_size);
+                    if (!result && error)
+                    {
+                        errno = error;
+                        result = -1;
+                    }
+                }
+                else if (!result)
+                {
+                    errno = ETIMEDOUT;
+                    result = -1;
+                }
+            }
+
+            if (!result)
+                result = ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+
+            if (result != 0)
+            {
+                int error = errno;
+                ::close(fd);
+                errno = error;
+                return -1;
+            }
+            return fd;
+        }
+    } // namespace
+
+    uring_tcp_client_impl::uring_tcp_client_impl(const uring_options& options)
+        : _options(options)
+    {
+    }
+
+    uring_tcp_client_impl::~uring_tcp_client_impl()
+    {
+        disconnect(true);
+    }
+
+    void uring_tcp_client_impl::connect(const std::string& addr, uint16_t port, uint32_t timeout_ms)
+    {
+        SRV_LOGC_TRACE("attempts to connect");
+
+        SRV_ASSERT(!is_connected(), "Client is already connected");
+
+        addrinfo hints;
+        std::memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        addrinfo* addresses = nullptr;
+        auto service = std::to_string(port);
+        int error = ::getaddrinfo(addr.c_str(), service.c_str(), &hints, &addresses);
+        if (error)
+            SRV_THROW_EXCEPTION(std::runtime_error, std::string { "getaddrinfo failed: " } + ::gai_strerror(error));
+
+        int fd = -1;
+        for (auto* address = addresses; address && fd < 0; address = address->ai_next)
+            fd = connect_socket(*address, timeout_ms);
+        error = errno;
+        ::freeaddrinfo(addresses);
+
+        if (fd < 0)
+            SRV_THROW_EXCEPTION(std::runtime_error, "Can't connect to " + addr + ":" + service + ": " + std::strerror(error));
+
+        try
+        {
+            if (!_ring)
+            {
+                _ring = std::make_shared<uring_ring>(_options, _worker_options);
+                _ring->start("uring-cli");
+            }
+        }
+        catch (const std::exception&)
+        {
+            _ring.reset();
+            ::close(fd);
+            throw;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_connection_mutex);
+            _connection = std::make_shared<uring_tcp_connection_impl>(fd, _ring, [this](uring_tcp_connection_impl&) {
+                on_diconnected();
+            });
+        }
+
+        SRV_LOGC_TRACE("connected");
+    }
+
+    void uring_tcp_client_impl::disconnect(bool wait_for_removal)
+    {
+        SRV_LOGC_TRACE("attempts to disconnect");
+
+        clear_connection();
+
+        // All callbacks are completed with ring thread.
+        // If it is ring thread itself ring is stopped asynchronously
+        // (thread finishes after this callback and it releases ring)
+        if (wait_for_removal && _ring)
+        {
+            _ring->stop();
+            _ring.reset();
+        }
+
+        SRV_LOGC_TRACE("disconnected");
+    }
+
+    bool uring_tcp_client_impl::is_connected() const
+    {
+        std::lock_guard<std::mutex> lock(_connection_mutex);
+        return _connection && _connection->is_connected();
+    }
+
+    void uring_tcp_client_impl::set_nb_workers(uint8_t)
+    {
+    }
+
+    void uring_tcp_client_impl::set_worker_options(const thread_options& options)
+    {
+        _worker_options->set(options);
+    }
+
+    std::shared_ptr<tcp_connection_i> uring_tcp_client_impl::create_connection()
+    {
+        SRV_LOGC_TRACE("attempts to create connection");
+
+        SRV_ASSERT(is_connected());
+
+        std::lock_guard<std::mutex> lock(_connection_mutex);
+        return std::static_pointer_cast<tcp_connection_i>(_connection);
+    }
+
+    void uring_tcp_client_impl::set_on_disconnection_handler(const disconnection_callback_type& disconnection_handler)
+    {
+        _disconnection_callback = disconnection_handler;
+    }
+
+    void uring_tcp_client_impl::on_diconnected()
+    {
+        SRV_LOGC_TRACE("handle client disconnection");
+
+        clear_connection();
+
+        if (_disconnection_callback)
+            _disconnection_callback();
+    }
+
+    void uring_tcp_client_impl::clear_connection()
+    {
+        std::shared_ptr<uring_tcp_connection_impl> connection;
+        {
+            std::lock_guard<std::mutex> lock(_connection_mutex);
+            connection = std::move(_connection);
+        }
+
+        if (connection)
+        {
+            connection->disconnect();
+            connection->notify_disconnected();
+        }
+    }
+
+} // namespace network
+} // namespace server_lib
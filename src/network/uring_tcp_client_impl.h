@@ -0,0 +1,54 @@
+#pragma once
+
+#include <server_lib/network/tcp_client_i.h>
+#include <server_lib/network/uring_transport.h>
+
+#include "uring_ring.h"
+
+#include <memory>
+#include <mutex>
+
+namespace server_lib {
+namespace network {
+
+    class uring_tcp_connection_impl;
+
+    class uring_tcp_client_impl : public tcp_client_i
+    {
+    public:
+        uring_tcp_client_impl(const uring_options& options);
+
+        ~uring_tcp_client_impl() override;
+
+        void connect(const std::string& addr, uint16_t port, uint32_t timeout_ms = 0) override;
+
+        void disconnect(bool wait_for_removal = false) override;
+
+        bool is_connected() const override;
+
+        // client uses single ring
+        void set_nb_workers(uint8_t nb_threads) override;
+
+        void set_worker_options(const thread_options& options) override;
+
+        std::shared_ptr<tcp_connection_i> create_connection() override;
+
+        void set_on_disconnection_handler(const disconnection_callback_type& disconnection_handler) override;
+
+    private:
+        void on_diconnected();
+        void clear_connection();
+
+        const uring_options _options;
+
+        std::shared_ptr<uring_ring> _ring;
+
+        disconnection_callback_type _disconnection_callback;
+        std::shared_ptr<uring_tcp_connection_impl> _connection;
+        mutable std::mutex _connection_mutex;
+
+        std::shared_ptr<deferred_thread_options> _worker_options = std::make_shared<deferred_thread_options>();
+    };
+
+} // namespace network
+} // namespace server_lib
@@ -0,0 +1,340 @@
+#include "uring_tcp_connection_impl.h"
+
+#include <server_lib/asserts.h>
+#include <server_lib/logging_helper.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifdef SRV_LOG_CONTEXT_
+#undef SRV_LOG_CONTEXT_
+#endif // #ifdef SRV_LOG_CONTEXT_
+
+#define SRV_LOG_CONTEXT_ "uring-con (" << reinterpret_cast<uint64_t>(this) << ")> " << SRV_FUNCTION_NAME_ << ": "
+
+namespace server_lib {
+namespace network {
+
+    class uring_tcp_connection_impl::read_operation : public uring_operation
+    {
+    public:
+        read_operation(const std::shared_ptr<uring_tcp_connection_impl>& connection_,
+                       size_t size_,
+                       async_read_callback_type&& callback_)
+            : connection(connection_)
+            , size(size_)
+            , callback(std::move(callback_))
+        {
+        }
+
+        bool complete(int res, uint32_t) override
+        {
+            return connection->on_read(*this, res);
+        }
+
+        std::shared_ptr<uring_tcp_connection_impl> connection;
+        size_t size = 0;
+        async_read_callback_type callback;
+        // it is passed to callback without copying
+        std::vector<char> buffer;
+    };
+
+    class uring_tcp_connection_impl::write_operation : public uring_operation
+    {
+    public:
+        write_operation(const std::shared_ptr<uring_tcp_connection_impl>& connection_,
+                        std::vector<char>&& buffer_,
+                        std::vector<buffer_view>&& buffers_,
+                        async_write_callback_type&& callback_)
+            : connection(connection_)
+            , buffer(std::move(buffer_))
+            , buffers(std::move(buffers_))
+            , callback(std::move(callback_))
+        {
+            size = buffer.size();
+            if (buffers.empty())
+                return;
+
+            // pieces are sent by SENDMSG
+            iov.reserve(buffers.size() + 1);
+            if (!buffer.empty())
+                iov.push_back({ buffer.data(), buffer.size() });
+            for (auto&& view : buffers)
+            {
+                iov.push_back({ const_cast<char*>(view.data()), view.size() });
+                size += view.size();
+            }
+        }
+
+        bool complete(int res, uint32_t) override
+        {
+            return connection->on_write(*this, res);
+        }
+
+        // skip sent bytes
+        void advance(size_t sent)
+        {
+            offset += sent;
+            while (sent > 0 && iov_index < iov.size())
+            {
+                auto& piece = iov[iov_index];
+                if (sent < piece.iov_len)
+                {
+                    piece.iov_base = static_cast<char*>(piece.iov_base) + sent;
+                    piece.iov_len -= sent;
+                    return;
+                }
+                sent -= piece.iov_len;
+                ++iov_index;
+            }
+        }
+
+        std::shared_ptr<uring_tcp_connection_impl> connection;
+        std::vector<char> buffer;
+        std::vector<buffer_view> buffers;
+        size_t size = 0;
+        size_t offset = 0;
+        async_write_callback_type callback;
+
+        std::vector<iovec> iov;
+        size_t iov_index = 0;
+        msghdr msg = {};
+    };
+
+    uring_tcp_connection_impl::uring_tcp_connection_impl(int fd, const std::shared_ptr<uring_ring>& ring, const closed_callback_type& closed_callback)
+        : _fd(fd)
+        , _ring(ring)
+        , _closed_callback(closed_callback)
+        , _connected(true)
+        , _disconnection_notified(false)
+    {
+        SRV_ASSERT(_fd >= 0);
+        SRV_ASSERT(_ring);
+
+        SRV_LOGC_TRACE("created");
+    }
+
+    uring_tcp_connection_impl::~uring_tcp_connection_impl()
+    {
+        ::close(_fd);
+
+        SRV_LOGC_TRACE("destroyed");
+    }
+
+    bool uring_tcp_connection_impl::is_connected() const
+    {
+        return _connected.load();
+    }
+
+    void uring_tcp_connection_impl::async_read(read_request& request)
+    {
+        SRV_ASSERT(is_connected(), "Connection is closed");
+
+        std::unique_ptr<read_operation> operation { new read_operation(shared_from_this(), request.size,
+                                                                       std::move(request.async_read_callback)) };
+        bool posted = _ring->post([this, operation = std::move(operation)]() mutable {
+            submit_read(std::move(operation));
+        });
+        SRV_ASSERT(posted, "Transport is stopped");
+    }
+
+    void uring_tcp_connection_impl::async_write(write_request& request)
+    {
+        SRV_ASSERT(is_connected(), "Connection is closed");
+
+        std::unique_ptr<write_operation> operation { new write_operation(shared_from_this(), std::move(request.buffer),
+                                                                         std::move(request.buffers),
+                                                                         std::move(request.async_write_callback)) };
+        bool posted = _ring->post([this, operation = std::move(operation)]() mutable {
+            _writes.emplace_back(std::move(operation));
+            if (!_write_in_progress)
+                submit_write();
+        });
+        SRV_ASSERT(posted, "Transport is stopped");
+    }
+
+    void uring_tcp_connection_impl::set_on_disconnect_handler(const disconnection_callback_type& callback)
+    {
+        _disconnection_callback = callback;
+    }
+
+    void uring_tcp_connection_impl::set_no_delay(bool enable)
+    {
+        int value = enable ? 1 : 0;
+        if (::setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value)) != 0)
+            SRV_LOGC_TRACE("can't set TCP_NODELAY: " << errno);
+    }
+
+    void uring_tcp_connection_impl::set_cork(bool enable)
+    {
+        int value = enable ? 1 : 0;
+        if (::setsockopt(_fd, IPPROTO_TCP, TCP_CORK, &value, sizeof(value)) != 0)
+            SRV_LOGC_TRACE("can't set TCP_CORK: " << errno);
+    }
+
+    void uring_tcp_connection_impl::disconnect()
+    {
+        if (!_connected.exchange(false))
+            return;
+
+        SRV_LOGC_TRACE("disconnect");
+
+        // pending operations are finished by kernel
+        ::shutdown(_fd, SHUT_RDWR);
+    }
+
+    void uring_tcp_connection_impl::notify_disconnected()
+    {
+        if (_disconnection_notified.exchange(true))
+            return;
+
+        if (_disconnection_callback)
+            _disconnection_callback(*this);
+    }
+
+    void uring_tcp_connection_impl::submit_read(std::unique_ptr<read_operation>&& operation)
+    {
+        auto* sqe = _ring->get_sqe(operation.get());
+        if (!sqe)
+        {
+            read_result result = { false, {} };
+            if (operation->callback)
+                operation->callback(result);
+            return;
+        }
+
+        operation->buffer.resize(operation->size);
+
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = _fd;
+        sqe->addr = reinterpret_cast<uint64_t>(operation->buffer.data());
+        sqe->len = static_cast<uint32_t>(operation->size);
+
+        // ring owns operation now
+        operation.release();
+    }
+
+    bool uring_tcp_connection_impl::on_read(read_operation& operation, int res)
+    {
+        read_result result = { res > 0, {} };
+        if (res > 0)
+        {
+            operation.buffer.resize(static_cast<size_t>(res));
+            result.buffer = std::move(operation.buffer);
+        }
+
+        if (operation.callback)
+            operation.callback(result);
+
+        // zero is closed by peer
+        if (!result.success)
+            close();
+
+        return true;
+    }
+
+    void uring_tcp_connection_impl::submit_write()
+    {
+        SRV_ASSERT(!_writes.empty());
+
+        auto& operation = *_writes.front();
+        auto* sqe = _ring->get_sqe(&operation);
+        if (!sqe)
+        {
+            auto writes = std::move(_writes);
+            _write_in_progress = false;
+            for (auto&& queued : writes)
+            {
+                write_result result = { false, 0 };
+                if (queued->callback)
+                    queued->callback(result);
+            }
+            return;
+        }
+
+        if (operation.iov.empty())
+        {
+            sqe->opcode = IORING_OP_SEND;
+            sqe->addr = reinterpret_cast<uint64_t>(operation.buffer.data() + operation.offset);
+            sqe->len = static_cast<uint32_t>(operation.buffer.size() - operation.offset);
+        }
+        else
+        {
+            operation.msg.msg_iov = operation.iov.data() + operation.iov_index;
+            // the rest is sent like partial write
+            operation.msg.msg_iovlen = std::min<size_t>(operation.iov.size() - operation.iov_index, IOV_MAX);
+
+            sqe->opcode = IORING_OP_SENDMSG;
+            sqe->addr = reinterpret_cast<uint64_t>(&operation.msg);
+            sqe->len = 1;
+        }
+        sqe->fd = _fd;
+        sqe->msg_flags = MSG_NOSIGNAL;
+
+        _write_in_progress = true;
+    }
+
+    bool uring_tcp_connection_impl::on_write(write_operation& operation, int res)
+    {
+        // queued operations hold connection
+        auto hold_this = shared_from_this();
+
+        _write_in_progress = false;
+
+        if (res < 0)
+        {
+            auto writes = std::move(_writes);
+            for (auto&& queued : writes)
+            {
+                write_result result = { false, 0 };
+                if (queued->callback)
+                    queued->callback(result);
+            }
+            close();
+            // write operations are owned by connection
+            return false;
+        }
+
+        operation.advance(static_cast<size_t>(res));
+        if (operation.offset < operation.size)
+        {
+            // partial write
+            submit_write();
+            return false;
+        }
+
+        auto written = std::move(_writes.front());
+        _writes.pop_front();
+
+        if (!_writes.empty())
+            submit_write();
+
+        write_result result = { true, written->size };
+        if (written->callback)
+            written->callback(result);
+
+        return false;
+    }
+
+    void uring_tcp_connection_impl::close()
+    {
+        if (!_connected.exchange(false))
+            return;
+
+        SRV_LOGC_TRACE("closed");
+
+        ::shutdown(_fd, SHUT_RDWR);
+
+        if (_closed_callback)
+            _closed_callback(*this);
+    }
+
+} // namespace network
+} // namespace server_lib
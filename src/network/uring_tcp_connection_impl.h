@@ -0,0 +1,79 @@
+#pragma once
+
+#include <server_lib/network/tcp_connection_i.h>
+
+#include "uring_ring.h"
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+
+namespace server_lib {
+namespace network {
+
+    /**
+     * @brief TCP connection of io_uring transport
+     *
+     * All operations are prepared in ring thread. Writes are sent one by one
+     * in request order. Socket is closed with the last reference
+     */
+    class uring_tcp_connection_impl : public tcp_connection_i,
+                                      public std::enable_shared_from_this<uring_tcp_connection_impl>
+    {
+    public:
+        /**
+         * callback for transport (server or client) when connection is closed
+         * by peer or by error
+         */
+        using closed_callback_type = std::function<void(uring_tcp_connection_impl&)>;
+
+        uring_tcp_connection_impl(int fd, const std::shared_ptr<uring_ring>&, const closed_callback_type&);
+
+        ~uring_tcp_connection_impl() override;
+
+        bool is_connected() const override;
+
+        void async_read(read_request& request) override;
+
+        void async_write(write_request& request) override;
+
+        void set_on_disconnect_handler(const disconnection_callback_type&) override;
+
+        void set_no_delay(bool) override;
+
+        void set_cork(bool) override;
+
+        // shutdown socket. Pending operations are failed
+        void disconnect() override;
+
+        // call disconnection handler (only once)
+        void notify_disconnected();
+
+    private:
+        class read_operation;
+        class write_operation;
+
+        void submit_read(std::unique_ptr<read_operation>&&);
+        bool on_read(read_operation&, int res);
+
+        void submit_write();
+        bool on_write(write_operation&, int res);
+
+        void close();
+
+        const int _fd;
+        std::shared_ptr<uring_ring> _ring;
+        closed_callback_type _closed_callback;
+
+        std::atomic_bool _connected;
+        std::atomic_bool _disconnection_notified;
+        disconnection_callback_type _disconnection_callback = nullptr;
+
+        // ring thread only
+        std::deque<std::unique_ptr<write_operation>> _writes;
+        bool _write_in_progress = false;
+    };
+
+} // namespace network
+} // namespace server_lib
@@ -0,0 +1,342 @@
+#include "uring_tcp_server_impl.h"
+
+#include "uring_tcp_connection_impl.h"
+
+#include <server_lib/asserts.h>
+#include <server_lib/logging_helper.h>
+
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef SRV_LOG_CONTEXT_
+#undef SRV_LOG_CONTEXT_
+#endif // #ifdef SRV_LOG_CONTEXT_
+
+#define SRV_LOG_CONTEXT_ "uring-srv-impl> " << SRV_FUNCTION_NAME_ << ": "
+
+namespace server_lib {
+namespace network {
+
+    namespace {
+        // accept is resumed after this delay if it fails (by EMFILE for example)
+        constexpr long ACCEPT_RETRY_DELAY_MS = 100;
+
+        int create_listener(const std::string& host, uint16_t port)
+        {
+            addrinfo hints;
+            std::memset(&hints, 0, sizeof(hints));
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            hints.ai_flags = AI_PASSIVE;
+
+            addrinfo* addresses = nullptr;
+            auto service = std::to_string(port);
+            int error = ::getaddrinfo(host.empty() ? nullptr : host.c_str(), service.c_str(), &hints, &addresses);
+            if (error)
+                SRV_THROW_EXCEPTION(std::runtime_error, std::string { "getaddrinfo failed: " } + ::gai_strerror(error));
+
+            int fd = -1;
+            std::string last_error;
+            for (auto* address = addresses; address && fd < 0; address = address->ai_next)
+            {
+                fd = ::socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+                if (fd < 0)
+                {
+                    last_error = std::strerror(errno);
+                    continue;
+                }
+
+                int enable = 1;
+                ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+                if (::bind(fd, address->ai_addr, address->ai_addrlen) != 0 || ::listen(fd, SOMAXCONN) != 0)
+                {
+                    last_error = std::strerror(errno);
+                    ::close(fd);
+                    fd = -1;
+                }
+            }
+            ::freeaddrinfo(addresses);
+
+            if (fd < 0)
+                SRV_THROW_EXCEPTION(std::runtime_error, "Can't listen " + host + ":" + service + ": " + last_error);
+            return fd;
+        }
+    } // namespace
+
+    class uring_tcp_server_impl::accept_operation : public uring_operation
+    {
+    public:
+        accept_operation(uring_tcp_server_impl& server)
+            : _server(server)
+        {
+        }
+
+        bool complete(int res, uint32_t flags) override
+        {
+            if (_delayed)
+            {
+                // timeout is expired (-ETIME) or canceled
+                _delayed = false;
+                if (res == -ECANCELED || !_server.is_running())
+                    return true;
+
+                return !_server.arm_accept(*this);
+            }
+
+            if (res >= 0)
+            {
+                _server.on_new_connection(res);
+            }
+            else if (res != -ECANCELED)
+            {
+                SRV_LOGC_ERROR("accept failed: " << std::strerror(-res));
+            }
+
+            // multishot accept is still armed
+            if (flags & IORING_CQE_F_MORE)
+                return false;
+
+            if (res == -ECANCELED || !_server.is_running())
+                return true;
+
+            // Kernel has finished multishot. If it is finished by error
+            // (descriptors are exhausted for example) immediate retry
+            // would spin, so accept is armed again after delay
+            if (res < 0)
+                return !arm_delay();
+
+            return !_server.arm_accept(*this);
+        }
+
+    private:
+        bool arm_delay()
+        {
+            auto* sqe = _server.ring().get_sqe(this);
+            if (!sqe)
+                return false;
+
+            _delay.tv_sec = 0;
+            _delay.tv_nsec = ACCEPT_RETRY_DELAY_MS * 1000 * 1000;
+            _delayed = true;
+
+            sqe->opcode = IORING_OP_TIMEOUT;
+            sqe->fd = -1;
+            sqe->addr = reinterpret_cast<uint64_t>(&_delay);
+            sqe->len = 1;
+            return true;
+        }
+
+        uring_tcp_server_impl& _server;
+        // kernel reads it while timeout is armed
+        __kernel_timespec _delay = {};
+        bool _delayed = false;
+    };
+
+    uring_tcp_server_impl::uring_tcp_server_impl(const uring_options& options)
+        : _options(options)
+        , _running(false)
+    {
+    }
+
+    uring_tcp_server_impl::~uring_tcp_server_impl()
+    {
+        stop(true);
+    }
+
+    void uring_tcp_server_impl::start(const std::string& host, uint16_t port, event_loop* callback_thread, const on_new_connection_callback_type& callback)
+    {
+        SRV_ASSERT(!is_running());
+        SRV_ASSERT(callback);
+
+        try
+        {
+            SRV_LOGC_TRACE("attempts to start");
+
+            _callback_thread = callback_thread;
+            _new_connection_handler = callback;
+
+            _listen_fd = create_listener(host, port);
+
+            for (size_t ci = 0; ci < _nb_workers; ++ci)
+            {
+                auto ring = std::make_shared<uring_ring>(_options, _worker_options);
+                ring->start("uring-srv-" + std::to_string(ci));
+                _rings.emplace_back(ring);
+            }
+
+            _running = true;
+
+            bool posted = _rings.front()->post([this]() {
+                std::unique_ptr<accept_operation> operation { new accept_operation(*this) };
+                if (arm_accept(*operation))
+                    operation.release();
+            });
+            SRV_ASSERT(posted);
+
+            SRV_LOGC_TRACE("started");
+        }
+        catch (const std::exception& e)
+        {
+            SRV_LOGC_ERROR(e.what());
+
+            _running = false;
+            for (auto&& ring : _rings)
+                ring->stop();
+            _rings.clear();
+            if (_listen_fd >= 0)
+            {
+                ::close(_listen_fd);
+                _listen_fd = -1;
+            }
+            throw;
+        }
+    }
+
+    void uring_tcp_server_impl::stop(bool, bool recursive_wait_for_removal)
+    {
+        if (!_running.exchange(false))
+        {
+            return;
+        }
+
+        SRV_LOGC_TRACE("attempts to stop");
+
+        decltype(_connections) connections;
+        {
+            std::lock_guard<std::mutex> lock(_connections_mutex);
+            connections.swap(_connections);
+        }
+        for (auto&& item : connections)
+        {
+            auto& connection = item.second;
+            connection->disconnect();
+            if (recursive_wait_for_removal)
+                connection->notify_disconnected();
+        }
+
+        // ring threads are always stopped synchronously
+        // (except stop from ring thread)
+        for (auto&& ring : _rings)
+            ring->stop();
+        _rings.clear();
+        _next_ring = 0;
+
+        ::close(_listen_fd);
+        _listen_fd = -1;
+
+        SRV_LOGC_TRACE("stopped");
+    }
+
+    bool uring_tcp_server_impl::is_running(void) const
+    {
+        return _running.load();
+    }
+
+    void uring_tcp_server_impl::set_nb_workers(uint8_t nb_threads)
+    {
+        _nb_workers = std::max<size_t>(nb_threads, 1);
+
+        if (is_running())
+        {
+            SRV_LOGC_WARN("Workers number will be changed at next start");
+        }
+    }
+
+    void uring_tcp_server_impl::set_worker_options(const thread_options& options)
+    {
+        _worker_options->set(options);
+    }
+
+    uring_ring& uring_tcp_server_impl::ring()
+    {
+        return *_rings.front();
+    }
+
+    bool uring_tcp_server_impl::arm_accept(accept_operation& operation)
+    {
+        auto* sqe = ring().get_sqe(&operation);
+        if (!sqe)
+            return false;
+
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = _listen_fd;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->accept_flags = SOCK_CLOEXEC;
+        return true;
+    }
+
+    void uring_tcp_server_impl::on_new_connection(int fd)
+    {
+        if (!is_running())
+        {
+            ::close(fd);
+            return;
+        }
+
+        // connections are distributed between rings
+        auto& ring = _rings[_next_ring++ % _rings.size()];
+        auto connection = std::make_shared<uring_tcp_connection_impl>(fd, ring,
+                                                                      std::bind(&uring_tcp_server_impl::on_client_disconnected, this, std::placeholders::_1));
+
+        auto hold_this = shared_from_this();
+        auto call_ = [this, hold_this, connection]() {
+            SRV_LOGC_TRACE("handle new client connection (" << reinterpret_cast<uint64_t>(connection.get()) << ")");
+
+            {
+                std::lock_guard<std::mutex> lock(_connections_mutex);
+
+                _connections.emplace(connection.get(), connection);
+
+                SRV_LOGC_TRACE("connections = " << _connections.size());
+            }
+
+            SRV_ASSERT(_new_connection_handler);
+            _new_connection_handler(connection);
+        };
+        if (_callback_thread)
+        {
+            _callback_thread->post_or_defer(call_);
+        }
+        else
+        {
+            call_();
+        }
+    }
+
+    void uring_tcp_server_impl::on_client_disconnected(uring_tcp_connection_impl& closed)
+    {
+        if (!is_running())
+        {
+            return;
+        }
+
+        auto hold_this = shared_from_this();
+        auto connection = closed.shared_from_this();
+        auto call_ = [this, hold_this, connection]() {
+            SRV_LOGC_TRACE("handle server's client disconnection");
+
+            {
+                std::lock_guard<std::mutex> lock(_connections_mutex);
+                _connections.erase(connection.get());
+            }
+
+            connection->notify_disconnected();
+        };
+        if (_callback_thread)
+        {
+            _callback_thread->post_or_defer(call_);
+        }
+        else
+        {
+            call_();
+        }
+    }
+
+} // namespace network
+} // namespace server_lib
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <server_lib/network/tcp_server_i.h>
+#include <server_lib/network/uring_transport.h>
+
+#include "uring_ring.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace server_lib {
+namespace network {
+
+    class uring_tcp_connection_impl;
+
+    class uring_tcp_server_impl : public tcp_server_i,
+                                  public std::enable_shared_from_this<uring_tcp_server_impl>
+    {
+    public:
+        uring_tcp_server_impl(const uring_options& options);
+
+        ~uring_tcp_server_impl() override;
+
+        void start(const std::string& host, uint16_t port, event_loop* callback_thread = nullptr, const on_new_connection_callback_type& callback = nullptr) override;
+
+        void stop(bool wait_for_removal = false, bool recursive_wait_for_removal = true) override;
+
+        bool is_running(void) const override;
+
+        // it is applied at next start
+        void set_nb_workers(uint8_t nb_threads) override;
+
+        void set_worker_options(const thread_options& options) override;
+
+    private:
+        class accept_operation;
+
+        // accepting ring
+        uring_ring& ring();
+        bool arm_accept(accept_operation&);
+        void on_new_connection(int fd);
+        void on_client_disconnected(uring_tcp_connection_impl&);
+
+        const uring_options _options;
+
+        std::atomic_bool _running;
+        int _listen_fd = -1;
+        size_t _nb_workers = 1;
+        // the first ring accepts connections
+        std::vector<std::shared_ptr<uring_ring>> _rings;
+        size_t _next_ring = 0;
+
+        event_loop* _callback_thread = nullptr;
+        on_new_connection_callback_type _new_connection_handler = nullptr;
+
+        std::map<uring_tcp_connection_impl*, std::shared_ptr<uring_tcp_connection_impl>> _connections;
+        std::mutex _connections_mutex;
+
+        std::shared_ptr<deferred_thread_options> _worker_options = std::make_shared<deferred_thread_options>();
+    };
+
+} // namespace network
+} // namespace server_lib
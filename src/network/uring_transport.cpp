@@ -0,0 +1,26 @@
+#include <server_lib/network/uring_transport.h>
+
+#include "uring_ring.h"
+#include "uring_tcp_server_impl.h"
+#include "uring_tcp_client_impl.h"
+
+namespace server_lib {
+namespace network {
+
+    bool is_uring_supported()
+    {
+        return uring_ring::is_supported();
+    }
+
+    std::shared_ptr<tcp_server_i> create_uring_server(const uring_options& options)
+    {
+        return std::make_shared<uring_tcp_server_impl>(options);
+    }
+
+    std::shared_ptr<tcp_client_i> create_uring_client(const uring_options& options)
+    {
+        return std::make_shared<uring_tcp_client_impl>(options);
+    }
+
+} // namespace network
+} // namespace server_lib
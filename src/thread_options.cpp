@@ -0,0 +1,309 @@
+#include <server_lib/thread_options.h>
+#include <server_lib/platform_config.h>
+#include <server_lib/logging_helper.h>
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef SRV_LOG_CONTEXT_
+#undef SRV_LOG_CONTEXT_
+#endif // #ifdef SRV_LOG_CONTEXT_
+
+#define SRV_LOG_CONTEXT_ "thread> "
+
+namespace server_lib {
+
+namespace {
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    // from <numaif.h> to not depend on libnuma
+    constexpr int MPOL_DEFAULT_ = 0;
+    constexpr int MPOL_BIND_ = 2;
+
+    // parse list like "0-3,8-11"
+    std::vector<int> numa_node_cpus(const int node)
+    {
+        std::vector<int> result;
+
+        std::ifstream input("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string list;
+        if (!std::getline(input, list))
+            return result;
+
+        std::stringstream ss(list);
+        std::string range;
+        while (std::getline(ss, range, ','))
+        {
+            auto dash = range.find('-');
+            try
+            {
+                int first = std::stoi(range.substr(0, dash));
+                int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+                for (int cpu = first; cpu <= last; ++cpu)
+                    result.push_back(cpu);
+            }
+            catch (const std::exception&)
+            {
+                break;
+            }
+        }
+        return result;
+    }
+
+    bool set_affinity(const std::vector<int>& cpus)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (auto cpu : cpus)
+        {
+            if (cpu < 0 || cpu >= CPU_SETSIZE)
+            {
+                SRV_LOGC_WARN("Invalid CPU " << cpu);
+                return false;
+            }
+            CPU_SET(cpu, &set);
+        }
+
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err)
+        {
+            SRV_LOGC_WARN("Can't set CPU affinity: " << std::strerror(err));
+            return false;
+        }
+        return true;
+    }
+
+    bool set_memory_policy(const int node)
+    {
+#if defined(SYS_set_mempolicy)
+        constexpr size_t bits = sizeof(unsigned long) * 8;
+        if (node >= static_cast<int>(bits * 16))
+        {
+            SRV_LOGC_WARN("Invalid NUMA node " << node);
+            return false;
+        }
+
+        unsigned long mask[16] = {};
+        mask[node / bits] = 1ul << (node % bits);
+        if (syscall(SYS_set_mempolicy, MPOL_BIND_, mask, bits * 16 + 1) != 0)
+        {
+            SRV_LOGC_WARN("Can't bind memory to NUMA node " << node << ": " << std::strerror(errno));
+            return false;
+        }
+        return true;
+#else
+        SRV_LOGC_WARN("NUMA memory policy is not supported");
+        return false;
+#endif
+    }
+
+    bool set_scheduling(const thread_options& options)
+    {
+        bool result = true;
+
+        if (options.policy != thread_options::sched_policy::other)
+        {
+            sched_param param;
+            std::memset(&param, 0, sizeof(param));
+            param.sched_priority = options.priority;
+
+            int policy = (options.policy == thread_options::sched_policy::fifo) ? SCHED_FIFO : SCHED_RR;
+            int err = pthread_setschedparam(pthread_self(), policy, &param);
+            if (err)
+            {
+                SRV_LOGC_WARN("Can't set real-time scheduling: " << std::strerror(err));
+                result = false;
+            }
+        }
+
+        if (options.nice)
+        {
+            // nice value is per thread in Linux
+            auto tid = static_cast<id_t>(syscall(SYS_gettid));
+            if (setpriority(PRIO_PROCESS, tid, options.nice) != 0)
+            {
+                SRV_LOGC_WARN("Can't set nice " << options.nice << ": " << std::strerror(errno));
+                result = false;
+            }
+        }
+
+        return result;
+    }
+
+    // thread state before the first applied options
+    struct initial_state
+    {
+        bool saved = false;
+        cpu_set_t affinity;
+        int policy = SCHED_OTHER;
+        sched_param param;
+        int nice = 0;
+    };
+
+    thread_local initial_state t_initial_state;
+
+    void save_initial_state()
+    {
+        auto& state = t_initial_state;
+        if (state.saved)
+            return;
+
+        CPU_ZERO(&state.affinity);
+        pthread_getaffinity_np(pthread_self(), sizeof(state.affinity), &state.affinity);
+        std::memset(&state.param, 0, sizeof(state.param));
+        pthread_getschedparam(pthread_self(), &state.policy, &state.param);
+        errno = 0;
+        auto nice = getpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)));
+        state.nice = errno ? 0 : nice;
+        state.saved = true;
+    }
+
+    bool restore_initial_state()
+    {
+        auto& state = t_initial_state;
+        if (!state.saved)
+            return true;
+
+        bool result = true;
+
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(state.affinity), &state.affinity);
+        if (err)
+        {
+            SRV_LOGC_WARN("Can't restore CPU affinity: " << std::strerror(err));
+            result = false;
+        }
+
+#if defined(SYS_set_mempolicy)
+        if (syscall(SYS_set_mempolicy, MPOL_DEFAULT_, nullptr, 0) != 0)
+        {
+            SRV_LOGC_WARN("Can't restore memory policy: " << std::strerror(errno));
+            result = false;
+        }
+#endif
+
+        err = pthread_setschedparam(pthread_self(), state.policy, &state.param);
+        if (err)
+        {
+            SRV_LOGC_WARN("Can't restore scheduling: " << std::strerror(err));
+            result = false;
+        }
+
+        // lower nice could require privileges
+        auto tid = static_cast<id_t>(syscall(SYS_gettid));
+        errno = 0;
+        auto nice = getpriority(PRIO_PROCESS, tid);
+        if ((errno || nice != state.nice) && setpriority(PRIO_PROCESS, tid, state.nice) != 0)
+        {
+            SRV_LOGC_WARN("Can't restore nice " << state.nice << ": " << std::strerror(errno));
+            result = false;
+        }
+
+        // state is saved again by the next options
+        state.saved = false;
+        return result;
+    }
+#endif
+
+    std::atomic_uint64_t g_owners(0);
+    std::atomic_uint64_t g_threads(0);
+
+    // unique for process lifetime (unlike std::thread::id)
+    uint64_t this_thread_key()
+    {
+        thread_local uint64_t key = ++g_threads;
+        return key;
+    }
+
+    // the last applied generation (cache to skip locking)
+    thread_local uint64_t t_applied_owner = 0;
+    thread_local uint64_t t_applied_generation = 0;
+} // namespace
+
+bool apply_thread_options(const thread_options& options)
+{
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    // previous options are replaced
+    bool result = restore_initial_state();
+
+    if (options.empty())
+        return result;
+
+    save_initial_state();
+
+    auto cpus = options.cpus;
+    if (cpus.empty() && options.numa_node >= 0)
+    {
+        cpus = numa_node_cpus(options.numa_node);
+        if (cpus.empty())
+        {
+            SRV_LOGC_WARN("Can't get CPUs of NUMA node " << options.numa_node);
+            result = false;
+        }
+    }
+
+    if (!cpus.empty())
+        result = set_affinity(cpus) && result;
+    if (options.numa_node >= 0)
+        result = set_memory_policy(options.numa_node) && result;
+
+    return set_scheduling(options) && result;
+#else
+    if (options.empty())
+        return true;
+
+    SRV_LOGC_WARN("Thread options are not supported");
+    return false;
+#endif
+}
+
+deferred_thread_options::deferred_thread_options()
+    : _id(++g_owners)
+{
+}
+
+void deferred_thread_options::set(const thread_options& options)
+{
+    std::lock_guard<std::mutex> lck(_guard);
+
+    _options = options;
+    _applied_threads.clear();
+    ++_generation;
+}
+
+void deferred_thread_options::apply()
+{
+    auto generation = _generation.load(std::memory_order_acquire);
+    if (!generation || (t_applied_owner == _id && t_applied_generation == generation))
+        return;
+
+    thread_options options;
+    bool first = false;
+    {
+        std::lock_guard<std::mutex> lck(_guard);
+
+        generation = _generation.load();
+        // thread could serve several owners
+        // and it applies options of each one once
+        first = _applied_threads.insert(this_thread_key()).second;
+        if (first)
+            options = _options;
+    }
+
+    t_applied_owner = _id;
+    t_applied_generation = generation;
+
+    if (first)
+        apply_thread_options(options);
+}
+
+} // namespace server_lib
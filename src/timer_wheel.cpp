@@ -0,0 +1,266 @@
+#include <server_lib/timer_wheel.h>
+
+#include <algorithm>
+
+namespace server_lib {
+
+namespace {
+    size_t lowest_bit(uint64_t word)
+    {
+#if defined(__GNUC__)
+        return static_cast<size_t>(__builtin_ctzll(word));
+#else
+        size_t result = 0;
+        while (!(word & 1))
+        {
+            word >>= 1;
+            ++result;
+        }
+        return result;
+#endif
+    }
+
+    // first set bit starting from 'from' or 'bits.size() * 64' if there is no one
+    template <size_t Words>
+    size_t find_next(const std::array<uint64_t, Words>& bits, const size_t from)
+    {
+        for (size_t word_index = from / 64; word_index < Words; ++word_index)
+        {
+            auto word = bits[word_index];
+            if (word_index == from / 64)
+                word &= ~uint64_t(0) << (from % 64);
+            if (word)
+                return word_index * 64 + lowest_bit(word);
+        }
+        return Words * 64;
+    }
+} // namespace
+
+constexpr timer_wheel::tick_type timer_wheel::no_expiry;
+constexpr size_t timer_wheel::level_bits;
+constexpr size_t timer_wheel::slots_per_level;
+constexpr size_t timer_wheel::levels;
+constexpr size_t timer_wheel::bitmap_words;
+
+timer_wheel::timer_wheel()
+    : _epoch(clock::now())
+{
+}
+
+timer_wheel::tick_type timer_wheel::to_tick(const clock::time_point& time) const
+{
+    if (time <= _epoch)
+        return 0;
+    return static_cast<tick_type>(std::chrono::duration_cast<std::chrono::milliseconds>(time - _epoch).count());
+}
+
+timer_wheel::clock::time_point timer_wheel::to_time_point(const tick_type tick) const
+{
+    return _epoch + std::chrono::milliseconds(tick);
+}
+
+timer_wheel::handle timer_wheel::add(const std::chrono::milliseconds& delay, small_handler&& callback, bool& earliest)
+{
+    auto elapsed = clock::now() - _epoch;
+    // round up to not fire before requested time
+    auto now = static_cast<tick_type>(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+    if (elapsed > std::chrono::milliseconds(now))
+        ++now;
+
+    std::lock_guard<std::mutex> lck(_guard);
+
+    if (_levels.empty())
+        _levels.resize(levels);
+
+    if (!_size)
+        _current = std::max(_current, now);
+
+    auto* e = acquire();
+    e->expiry = std::max(now + static_cast<tick_type>(std::max<int64_t>(delay.count(), 0)), _current + 1);
+    e->callback = std::move(callback);
+    link(e);
+    ++_size;
+
+    earliest = e->expiry < _requested_wakeup;
+    if (earliest)
+        _requested_wakeup = e->expiry;
+
+    return { e, e->generation };
+}
+
+bool timer_wheel::cancel(const handle& h)
+{
+    small_handler callback;
+    {
+        std::lock_guard<std::mutex> lck(_guard);
+
+        auto* e = h._entry;
+        if (!e || e->generation != h._generation || !e->linked)
+            return false;
+
+        unlink(e);
+        callback = std::move(e->callback);
+        release(e);
+        --_size;
+    }
+    // callback is destroyed out of lock because it could own other timers
+    return true;
+}
+
+void timer_wheel::advance(const tick_type now, std::vector<small_handler>& expired)
+{
+    std::lock_guard<std::mutex> lck(_guard);
+
+    _requested_wakeup = no_expiry;
+
+    if (!_size)
+    {
+        _current = std::max(_current, now);
+        return;
+    }
+
+    while (_current < now)
+    {
+        _current = next_event(now);
+        process(expired);
+    }
+}
+
+timer_wheel::tick_type timer_wheel::next_expiry()
+{
+    std::lock_guard<std::mutex> lck(_guard);
+
+    _requested_wakeup = _size ? next_event(no_expiry) : no_expiry;
+    return _requested_wakeup;
+}
+
+size_t timer_wheel::size() const
+{
+    std::lock_guard<std::mutex> lck(_guard);
+
+    return _size;
+}
+
+timer_wheel::entry* timer_wheel::acquire()
+{
+    if (_free)
+    {
+        auto* e = _free;
+        _free = e->next;
+        e->next = nullptr;
+        return e;
+    }
+    _entries.emplace_back();
+    return &_entries.back();
+}
+
+void timer_wheel::release(entry* e)
+{
+    ++e->generation;
+    e->prev = nullptr;
+    e->next = _free;
+    _free = e;
+}
+
+void timer_wheel::link(entry* e)
+{
+    // the highest digit that differs from current tick
+    size_t level_index = levels - 1;
+    while (level_index > 0 && digit(e->expiry, level_index) == digit(_current, level_index))
+        --level_index;
+    auto slot_index = digit(e->expiry, level_index);
+
+    auto& l = _levels[level_index];
+    e->prev = nullptr;
+    e->next = l.slots[slot_index];
+    if (e->next)
+        e->next->prev = e;
+    l.slots[slot_index] = e;
+    l.occupied[slot_index / 64] |= uint64_t(1) << (slot_index % 64);
+
+    e->level_index = level_index;
+    e->slot_index = slot_index;
+    e->linked = true;
+}
+
+void timer_wheel::unlink(entry* e)
+{
+    auto& l = _levels[e->level_index];
+    if (e->prev)
+        e->prev->next = e->next;
+    else
+        l.slots[e->slot_index] = e->next;
+    if (e->next)
+        e->next->prev = e->prev;
+    if (!l.slots[e->slot_index])
+        l.occupied[e->slot_index / 64] &= ~(uint64_t(1) << (e->slot_index % 64));
+
+    e->prev = e->next = nullptr;
+    e->linked = false;
+}
+
+timer_wheel::entry* timer_wheel::take_slot(const size_t level_index, const size_t slot_index)
+{
+    auto& l = _levels[level_index];
+    auto* head = l.slots[slot_index];
+    l.slots[slot_index] = nullptr;
+    l.occupied[slot_index / 64] &= ~(uint64_t(1) << (slot_index % 64));
+    return head;
+}
+
+void timer_wheel::process(std::vector<small_handler>& expired)
+{
+    auto fire = [this, &expired](entry* e) {
+        expired.emplace_back(std::move(e->callback));
+        release(e);
+        --_size;
+    };
+
+    // cascade slots that are reached by current tick
+    for (size_t level_index = levels - 1; level_index > 0; --level_index)
+    {
+        auto lower_mask = (tick_type(1) << (level_index * level_bits)) - 1;
+        if (_current & lower_mask)
+            continue;
+
+        auto* e = take_slot(level_index, digit(_current, level_index));
+        while (e)
+        {
+            auto* next = e->next;
+            e->linked = false;
+            if (e->expiry <= _current)
+                fire(e);
+            else
+                link(e);
+            e = next;
+        }
+    }
+
+    auto* e = take_slot(0, digit(_current, 0));
+    while (e)
+    {
+        auto* next = e->next;
+        e->linked = false;
+        fire(e);
+        e = next;
+    }
+}
+
+timer_wheel::tick_type timer_wheel::next_event(const tick_type limit) const
+{
+    // The first occupied slot after current one. Any slot of level
+    // is reached before next slot of upper level
+    for (size_t level_index = 0; level_index < levels; ++level_index)
+    {
+        auto slot_index = find_next(_levels[level_index].occupied, digit(_current, level_index) + 1);
+        if (slot_index < slots_per_level)
+        {
+            auto upper_shift = (level_index + 1) * level_bits;
+            tick_type base = upper_shift < 64 ? (_current >> upper_shift) << upper_shift : 0;
+            return std::min(base | (tick_type(slot_index) << (level_index * level_bits)), limit);
+        }
+    }
+    return limit;
+}
+
+} // namespace server_lib
@@ -0,0 +1,39 @@
+#include <server_lib/wait_asynch_request.h>
+
+#include <boost/lockfree/stack.hpp>
+
+namespace server_lib {
+
+namespace {
+    constexpr size_t MAX_FREE_SYNC_OBJECTS = 1024;
+
+    using free_sync_objects_type = boost::lockfree::stack<wait_sync*, boost::lockfree::capacity<MAX_FREE_SYNC_OBJECTS>>;
+
+    free_sync_objects_type& free_sync_objects()
+    {
+        // objects in pool are not deleted at exit
+        // because they could be released by static destructors
+        static free_sync_objects_type* pool = new free_sync_objects_type;
+        return *pool;
+    }
+} // namespace
+
+wait_sync::ref wait_sync::acquire()
+{
+    wait_sync* sync = nullptr;
+    if (!free_sync_objects().pop(sync))
+        sync = new wait_sync;
+
+    sync->done = false;
+    sync->abandoned = false;
+    sync->_refs.store(1, std::memory_order_relaxed);
+    return ref { sync };
+}
+
+void wait_sync::release(wait_sync* sync)
+{
+    if (!free_sync_objects().bounded_push(sync))
+        delete sync;
+}
+
+} // namespace server_lib
@@ -0,0 +1,1662 @@
+#include "tests_common.h"
+
+#include <server_lib/event_loop.h>
+#include <server_lib/event_loop_pool.h>
+#include <server_lib/event_loop_watchdog.h>
+#include <server_lib/handler_allocator.h>
+#include <server_lib/latency_histogram.h>
+#include <server_lib/logging_helper.h>
+#include <server_lib/loop_future.h>
+#include <server_lib/thread_options.h>
+#include <server_lib/timer_wheel.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace server_lib {
+namespace tests {
+
+    BOOST_AUTO_TEST_SUITE(event_loop_tests)
+
+    BOOST_AUTO_TEST_CASE(pool_post_check)
+    {
+        print_current_test_name();
+
+        event_loop_pool pool(4);
+
+        pool.change_thread_name("!P");
+
+        bool started = false;
+        std::mutex started_cond_guard;
+        std::condition_variable started_cond;
+
+        pool.start([&]() {
+            std::unique_lock<std::mutex> lck(started_cond_guard);
+            started = true;
+            started_cond.notify_one();
+        });
+
+        {
+            std::unique_lock<std::mutex> lck(started_cond_guard);
+            started_cond.wait_for(lck, std::chrono::seconds(10), [&started]() {
+                return started;
+            });
+        }
+        BOOST_REQUIRE(started);
+
+        constexpr size_t TASKS = 1000;
+
+        std::atomic_size_t done(0);
+        std::mutex threads_guard;
+        // which loops have run tasks depends on stealing,
+        // but every task runs once in some pool thread
+        std::map<std::thread::id, size_t> threads;
+
+        for (size_t ci = 0; ci < TASKS; ++ci)
+        {
+            BOOST_REQUIRE(pool.post([&]() {
+                {
+                    std::lock_guard<std::mutex> lck(threads_guard);
+                    ++threads[std::this_thread::get_id()];
+                }
+                ++done;
+            }));
+        }
+
+        for (size_t ci = 0; ci < 1000 && done.load() < TASKS; ++ci)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        BOOST_REQUIRE_EQUAL(done.load(), TASKS);
+
+        std::lock_guard<std::mutex> lck(threads_guard);
+        BOOST_REQUIRE_LE(threads.size(), pool.size());
+        BOOST_REQUIRE(!threads.count(std::this_thread::get_id()));
+        size_t total = 0;
+        for (auto&& item : threads)
+            total += item.second;
+        BOOST_REQUIRE_EQUAL(total, TASKS);
+    }
+
+    BOOST_AUTO_TEST_CASE(pool_stealing_check)
+    {
+        print_current_test_name();
+
+        event_loop_pool pool(4);
+
+        pool.change_thread_name("!P");
+
+        pool.start();
+
+        constexpr size_t TASKS = 400;
+
+        std::atomic_size_t done(0);
+
+        // round robin puts every slow task to the same loop
+        for (size_t ci = 0; ci < TASKS; ++ci)
+        {
+            bool slow = ci % pool.size() == 0;
+            pool.post([&done, slow]() {
+                if (slow)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                ++done;
+            });
+        }
+
+        for (size_t ci = 0; ci < 1000 && done.load() < TASKS; ++ci)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        BOOST_REQUIRE_EQUAL(done.load(), TASKS);
+        BOOST_REQUIRE_GT(pool.stolen(), 0u);
+
+        pool.stop();
+    }
+
+    BOOST_AUTO_TEST_CASE(pool_post_rejected_check)
+    {
+        print_current_test_name();
+
+        event_loop_pool pool(2);
+
+        pool.change_thread_name("!P");
+
+        pool.start();
+
+        auto& busy_loop = pool.loop(0);
+        busy_loop.set_watermarks(1, 0, event_loop::overflow_policy::reject);
+
+        // busy loop keeps its queue at high watermark
+        std::promise<void> release;
+        auto released = release.get_future().share();
+        BOOST_REQUIRE(busy_loop.post([released]() {
+            released.wait();
+        }));
+
+        constexpr size_t TASKS = 100;
+
+        std::atomic_size_t done(0);
+
+        for (size_t ci = 0; ci < TASKS; ++ci)
+        {
+            BOOST_REQUIRE(pool.post([&done]() {
+                ++done;
+            }));
+        }
+
+        // tasks rejected by busy loop are run by another one
+        for (size_t ci = 0; ci < 1000 && done.load() < TASKS; ++ci)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        BOOST_REQUIRE_EQUAL(done.load(), TASKS);
+        BOOST_REQUIRE_GT(busy_loop.rejected(), 0u);
+
+        release.set_value();
+
+        pool.stop();
+    }
+
+    BOOST_AUTO_TEST_CASE(pool_post_to_order_check)
+    {
+        print_current_test_name();
+
+        event_loop_pool pool(3, event_loop_pool::balance_policy::least_loaded);
+
+        pool.start();
+
+        constexpr int TASKS = 300;
+        constexpr int KEYS = 5;
+
+        std::vector<std::vector<int>> results(KEYS);
+        std::vector<std::thread::id> results_threads(KEYS);
+        // Boost.Test is not thread safe, thus it is checked in main thread
+        std::atomic_bool other_thread { false };
+
+        for (int ci = 0; ci < TASKS; ++ci)
+        {
+            int key = ci % KEYS;
+            pool.post_to(key, [&results, &results_threads, &other_thread, key, ci]() {
+                //the same key is always processed in the same thread
+                if (!results[key].empty() && results_threads[key] != std::this_thread::get_id())
+                {
+                    other_thread = true;
+                }
+                results_threads[key] = std::this_thread::get_id();
+                results[key].push_back(ci);
+            });
+        }
+
+        for (int key = 0; key < KEYS; ++key)
+        {
+            auto& loop = pool.loop_for(key);
+            BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+        }
+
+        BOOST_REQUIRE(!other_thread.load());
+
+        for (int key = 0; key < KEYS; ++key)
+        {
+            BOOST_REQUIRE_EQUAL(results[key].size(), static_cast<size_t>(TASKS / KEYS));
+            for (size_t ci = 1; ci < results[key].size(); ++ci)
+            {
+                BOOST_REQUIRE_LT(results[key][ci - 1], results[key][ci]);
+            }
+        }
+
+        pool.stop();
+
+        BOOST_REQUIRE(!pool.is_running());
+    }
+
+    BOOST_AUTO_TEST_CASE(small_handler_check)
+    {
+        print_current_test_name();
+
+        int calls = 0;
+        std::array<char, 256> big_capture {};
+
+        small_handler small = [&calls]() { ++calls; };
+        small_handler big = [&calls, big_capture]() { calls += 10; };
+
+        BOOST_REQUIRE(small);
+        BOOST_REQUIRE(big);
+
+        small_handler moved = std::move(small);
+        BOOST_REQUIRE(!small);
+        moved();
+        BOOST_REQUIRE_EQUAL(calls, 1);
+
+        moved = std::move(big);
+        BOOST_REQUIRE(!big);
+        moved();
+        BOOST_REQUIRE_EQUAL(calls, 11);
+
+        moved.reset();
+        BOOST_REQUIRE(!moved);
+        BOOST_REQUIRE_THROW(moved(), std::logic_error);
+    }
+
+    BOOST_AUTO_TEST_CASE(handler_memory_reuse_check)
+    {
+        print_current_test_name();
+
+        event_loop loop;
+
+        loop.start();
+
+        for (size_t ci = 0; ci < 100; ++ci)
+        {
+            BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+        }
+
+        BOOST_REQUIRE_GT(loop.memory().reused(), loop.memory().allocated());
+    }
+
+    BOOST_AUTO_TEST_CASE(post_bulk_check)
+    {
+        print_current_test_name();
+
+        event_loop loop;
+
+        std::vector<int> results;
+
+        std::vector<std::function<void(void)>> batch;
+        for (int ci = 0; ci < 10; ++ci)
+        {
+            batch.emplace_back([&results, ci]() {
+                results.push_back(ci);
+            });
+        }
+
+        loop.post_bulk(batch);
+        BOOST_REQUIRE_EQUAL(loop.queue_size(), batch.size());
+        loop.post_bulk(std::move(batch));
+        loop.post_bulk(std::vector<std::function<void(void)>> {});
+        BOOST_REQUIRE_EQUAL(loop.queue_size(), 20u);
+
+        loop.start();
+
+        BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+
+        BOOST_REQUIRE_EQUAL(results.size(), 20u);
+        for (size_t ci = 0; ci < results.size(); ++ci)
+        {
+            BOOST_REQUIRE_EQUAL(results[ci], static_cast<int>(ci % 10));
+        }
+
+        loop.stop();
+
+        BOOST_REQUIRE_EQUAL(loop.queue_size(), 0u);
+    }
+
+    BOOST_AUTO_TEST_CASE(post_bulk_exception_check)
+    {
+        print_current_test_name();
+
+        event_loop loop;
+
+        loop.enable_metrics();
+
+        std::vector<int> results;
+
+        std::vector<std::function<void(void)>> batch;
+        batch.emplace_back([&results]() {
+            results.push_back(1);
+        });
+        batch.emplace_back([]() {
+            throw std::runtime_error("test");
+        });
+        batch.emplace_back([&results]() {
+            results.push_back(3);
+        });
+
+        loop.post_bulk(std::move(batch));
+
+        loop.start();
+
+        BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+
+        loop.stop();
+
+        BOOST_REQUIRE_EQUAL(results.size(), 2u);
+        BOOST_REQUIRE_EQUAL(results[0], 1);
+        BOOST_REQUIRE_EQUAL(results[1], 3);
+        BOOST_REQUIRE_EQUAL(loop.get_metrics().exceptions, 1u);
+        BOOST_REQUIRE_EQUAL(loop.queue_size(), 0u);
+    }
+
+    BOOST_AUTO_TEST_CASE(lockfree_queue_check)
+    {
+        print_current_test_name();
+
+        event_loop loop(true, event_loop::queue_type::lockfree);
+
+        loop.start();
+
+        const size_t producers = 4;
+        const size_t posts = 10000;
+
+        std::vector<std::vector<size_t>> results(producers);
+        std::vector<std::thread> threads;
+        for (size_t pi = 0; pi < producers; ++pi)
+        {
+            threads.emplace_back([&loop, &results, pi]() {
+                for (size_t ci = 0; ci < posts; ++ci)
+                {
+                    loop.post([&results, pi, ci]() {
+                        results[pi].push_back(ci);
+                    });
+                }
+            });
+        }
+        for (auto&& th : threads)
+            th.join();
+
+        BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+
+        // handlers of every producer run in posting order
+        for (auto&& result : results)
+        {
+            BOOST_REQUIRE_EQUAL(result.size(), posts);
+            for (size_t ci = 0; ci < result.size(); ++ci)
+            {
+                BOOST_REQUIRE_EQUAL(result[ci], ci);
+            }
+        }
+
+        // parked loop is woken up by timer
+        std::atomic_bool timer_fired(false);
+        loop.start_timer(std::chrono::milliseconds(10), [&timer_fired]() {
+            timer_fired = true;
+        });
+        for (size_t ci = 0; ci < 1000 && !timer_fired; ++ci)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        BOOST_REQUIRE(timer_fired);
+
+        // parked loop is woken up by post
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+
+        loop.stop();
+
+        BOOST_REQUIRE_EQUAL(loop.queue_size(), 0u);
+    }
+
+    BOOST_AUTO_TEST_CASE(timer_wheel_check)
+    {
+        print_current_test_name();
+
+        timer_wheel wheel;
+
+        const std::vector<uint64_t> delays = { 1, 2, 255, 256, 257, 65535, 65536, 65537, 1000000 };
+
+        auto start = wheel.to_tick(timer_wheel::clock::now());
+
+        std::vector<uint64_t> fired;
+        bool earliest = false;
+        for (auto delay : delays)
+        {
+            wheel.add(std::chrono::milliseconds(delay), [&fired, delay]() { fired.push_back(delay); }, earliest);
+        }
+        auto canceled = wheel.add(std::chrono::milliseconds(300), []() { BOOST_REQUIRE(false); }, earliest);
+        BOOST_REQUIRE(!earliest);
+
+        BOOST_REQUIRE_EQUAL(wheel.size(), delays.size() + 1);
+        BOOST_REQUIRE(wheel.cancel(canceled));
+        BOOST_REQUIRE(!wheel.cancel(canceled));
+
+        std::vector<small_handler> expired;
+        for (size_t ci = 0; ci < delays.size(); ++ci)
+        {
+            // never early
+            wheel.advance(start + delays[ci] - 1, expired);
+            BOOST_REQUIRE_EQUAL(expired.size(), ci);
+
+            BOOST_REQUIRE_LE(wheel.next_expiry(), start + delays[ci] + 1);
+
+            // at most one tick late because of rounding
+            wheel.advance(start + delays[ci] + 1, expired);
+            BOOST_REQUIRE_EQUAL(expired.size(), ci + 1);
+        }
+
+        for (auto&& callback : expired)
+            callback();
+
+        BOOST_REQUIRE(fired == delays);
+        BOOST_REQUIRE_EQUAL(wheel.size(), 0u);
+        BOOST_REQUIRE_EQUAL(wheel.next_expiry(), timer_wheel::no_expiry);
+    }
+
+    BOOST_AUTO_TEST_CASE(loop_timers_check)
+    {
+        print_current_test_name();
+
+        event_loop loop;
+
+        loop.start();
+
+        std::mutex results_guard;
+        std::vector<int> results;
+        auto add_result = [&](int value) {
+            std::lock_guard<std::mutex> lck(results_guard);
+            results.push_back(value);
+        };
+
+        loop.start_timer(std::chrono::milliseconds(30), [&]() { add_result(3); });
+        loop.start_timer(std::chrono::milliseconds(10), [&]() { add_result(1); });
+        auto handle = loop.start_timer(std::chrono::milliseconds(20), [&]() { add_result(2); });
+        BOOST_REQUIRE(loop.cancel_timer(handle));
+
+        event_loop::timer stopped_timer { loop };
+        stopped_timer.start(std::chrono::milliseconds(15), [&]() { add_result(-1); });
+        stopped_timer.stop();
+
+        std::atomic_int ticks(0);
+        event_loop::periodical_timer periodical { loop };
+        periodical.start(std::chrono::milliseconds(5), [&ticks]() { ++ticks; });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        periodical.stop();
+
+        BOOST_REQUIRE_GT(ticks.load(), 1);
+
+        std::lock_guard<std::mutex> lck(results_guard);
+        BOOST_REQUIRE_EQUAL(results.size(), 2u);
+        BOOST_REQUIRE_EQUAL(results[0], 1);
+        BOOST_REQUIRE_EQUAL(results[1], 3);
+    }
+
+    BOOST_AUTO_TEST_CASE(loop_timers_exception_check)
+    {
+        print_current_test_name();
+
+        event_loop loop;
+
+        loop.enable_metrics();
+        loop.start();
+
+        std::promise<void> fired;
+        loop.post([&]() {
+            loop.start_timer(std::chrono::milliseconds(10), []() {
+                throw std::runtime_error("test");
+            });
+            loop.start_timer(std::chrono::milliseconds(10), [&fired]() {
+                fired.set_value();
+            });
+            // both timers are expired at the same tick
+            std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        });
+
+        BOOST_REQUIRE(fired.get_future().wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+
+        loop.stop();
+
+        BOOST_REQUIRE_EQUAL(loop.get_metrics().exceptions, 1u);
+    }
+
+    BOOST_AUTO_TEST_CASE(fixed_rate_timer_check)
+    {
+        print_current_test_name();
+
+        using policy_type = event_loop::periodical_timer::catch_up_policy;
+
+        const auto period = std::chrono::milliseconds(10);
+
+        auto check = [&](const policy_type policy) {
+            event_loop loop;
+
+            loop.start();
+
+            std::atomic_int calls(0);
+            uint64_t ticks = 0;
+            event_loop::periodical_timer timer { loop };
+            loop.wait_async(true, [&]() {
+                timer.start_fixed_rate(period, [&calls, &ticks, &timer]() {
+                    // slow callback doesn't shift schedule
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                    ++calls;
+                    ticks += timer.ticks();
+                },
+                                       policy);
+                return true;
+            });
+
+            std::this_thread::sleep_for(period * 3);
+
+            // busy loop misses several ticks
+            loop.post([&]() {
+                std::this_thread::sleep_for(period * 4 + period / 2);
+            });
+
+            std::this_thread::sleep_for(period * 10);
+
+            event_loop::periodical_timer::lateness_stats stats;
+            loop.wait_async(true, [&]() {
+                timer.stop();
+                stats = timer.stats();
+                return true;
+            });
+
+            BOOST_REQUIRE_EQUAL(stats.invoked, static_cast<uint64_t>(calls.load()));
+            BOOST_REQUIRE_GE(stats.max.count(), std::chrono::microseconds(period * 3).count());
+
+            return std::make_pair(stats, ticks);
+        };
+
+        auto burst = check(policy_type::burst);
+        BOOST_REQUIRE_EQUAL(burst.first.missed, 0u);
+        BOOST_REQUIRE_GE(burst.first.invoked, 11u);
+        BOOST_REQUIRE_GT(burst.first.invoked, burst.first.wakeups);
+        BOOST_REQUIRE_EQUAL(burst.second, burst.first.invoked);
+
+        // merged ticks are passed to callback
+        auto coalesce = check(policy_type::coalesce);
+        BOOST_REQUIRE_GE(coalesce.first.missed, 3u);
+        BOOST_REQUIRE_EQUAL(coalesce.first.invoked, coalesce.first.wakeups);
+        BOOST_REQUIRE_EQUAL(coalesce.second, coalesce.first.invoked + coalesce.first.missed);
+
+        // dropped ticks are not
+        auto skip = check(policy_type::skip);
+        BOOST_REQUIRE_GE(skip.first.missed, 3u);
+        BOOST_REQUIRE_EQUAL(skip.first.invoked, skip.first.wakeups);
+        BOOST_REQUIRE_EQUAL(skip.second, skip.first.invoked);
+    }
+
+    BOOST_AUTO_TEST_CASE(fixed_rate_timer_steady_lateness_check)
+    {
+        print_current_test_name();
+
+        const auto period = std::chrono::milliseconds(10);
+
+        event_loop loop;
+
+        loop.start();
+
+        std::atomic_int calls(0);
+        event_loop::periodical_timer timer { loop };
+        loop.wait_async(true, [&]() {
+            timer.start_fixed_rate(period, [&calls]() {
+                ++calls;
+            },
+                                   event_loop::periodical_timer::catch_up_policy::skip);
+            return true;
+        });
+
+        // loop is steadily busy, so every tick is late
+        // for more than one period
+        std::atomic_bool busy(true);
+        std::function<void()> busy_handler = [&]() {
+            std::this_thread::sleep_for(period * 3 + period / 2);
+            if (busy)
+                loop.post([&]() { busy_handler(); });
+        };
+        loop.post([&]() { busy_handler(); });
+
+        std::this_thread::sleep_for(period * 20);
+
+        event_loop::periodical_timer::lateness_stats stats;
+        loop.wait_async(true, [&]() {
+            busy = false;
+            timer.stop();
+            stats = timer.stats();
+            return true;
+        });
+
+        // busy handler could be still queued
+        loop.stop();
+
+        BOOST_REQUIRE_GE(stats.invoked, 3u);
+        BOOST_REQUIRE_EQUAL(stats.invoked, static_cast<uint64_t>(calls.load()));
+        BOOST_REQUIRE_GT(stats.missed, 0u);
+    }
+
+    BOOST_AUTO_TEST_CASE(hr_timer_jitter_check)
+    {
+        print_current_test_name();
+
+        using clock = std::chrono::steady_clock;
+
+        event_loop loop;
+
+        loop.start();
+
+        const auto delay = std::chrono::microseconds(500);
+        const size_t samples = 50;
+
+        std::vector<std::chrono::microseconds> jitter;
+        jitter.reserve(samples);
+
+        event_loop::hr_timer timer { loop };
+        for (size_t ci = 0; ci < samples; ++ci)
+        {
+            std::mutex fired_guard;
+            std::condition_variable fired_cond;
+            clock::time_point fired;
+            bool done = false;
+
+            auto started = clock::now();
+            timer.start(delay, [&]() {
+                std::lock_guard<std::mutex> lck(fired_guard);
+                fired = clock::now();
+                done = true;
+                fired_cond.notify_one();
+            });
+
+            std::unique_lock<std::mutex> lck(fired_guard);
+            BOOST_REQUIRE(fired_cond.wait_for(lck, std::chrono::seconds(1), [&done]() { return done; }));
+
+            BOOST_REQUIRE(fired - started >= delay);
+            jitter.push_back(std::chrono::duration_cast<std::chrono::microseconds>(fired - started - delay));
+        }
+
+        std::sort(jitter.begin(), jitter.end());
+        auto median = jitter[jitter.size() / 2];
+
+        LOG_TRACE("hr_timer jitter: median = " << median.count() << " us, max = " << jitter.back().count() << " us");
+
+        // millisecond timer would be late for 500 us at least
+        BOOST_REQUIRE_LT(median.count(), 500);
+
+        // timeout less than 1 millisecond
+        auto started = clock::now();
+        BOOST_REQUIRE(!loop.wait_async_hr(false, []() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            return true;
+        },
+                                          std::chrono::microseconds(300)));
+        BOOST_REQUIRE_LT(std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - started).count(), 20);
+
+        loop.stop();
+    }
+
+    BOOST_AUTO_TEST_CASE(priority_lanes_check)
+    {
+        print_current_test_name();
+
+        using priority = event_loop::priority;
+
+        event_loop loop;
+
+        std::vector<std::string> order;
+        std::atomic_bool low_done(false);
+
+        // normal lane never gets empty until low handler is executed
+        std::function<void(void)> flood = [&]() {
+            order.push_back("normal");
+            if (!low_done)
+                loop.post([&flood]() { flood(); });
+        };
+
+        for (size_t ci = 0; ci < 4; ++ci)
+            loop.post([&flood]() { flood(); });
+        loop.post(priority::low, [&]() {
+            order.push_back("low");
+            low_done = true;
+        });
+        loop.post(priority::high, [&]() {
+            order.push_back("high");
+        });
+
+        BOOST_REQUIRE_EQUAL(loop.queue_size(priority::high), 1u);
+        BOOST_REQUIRE_EQUAL(loop.queue_size(priority::normal), 4u);
+        BOOST_REQUIRE_EQUAL(loop.queue_size(priority::low), 1u);
+        BOOST_REQUIRE_EQUAL(loop.queue_size(), 6u);
+
+        loop.start();
+
+        for (size_t ci = 0; ci < 1000 && !low_done; ++ci)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        BOOST_REQUIRE(low_done);
+
+        BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+
+        loop.stop();
+
+        // high handler overtakes queued normal handlers
+        BOOST_REQUIRE_GE(order.size(), 2u);
+        BOOST_REQUIRE_EQUAL(order[0], "normal");
+        BOOST_REQUIRE_EQUAL(order[1], "high");
+
+        // low handler is not starved
+        auto low_pos = std::find(order.begin(), order.end(), "low") - order.begin();
+        BOOST_REQUIRE_LE(static_cast<size_t>(low_pos), 2 + 4 + 2 * event_loop::low_lane_weight);
+
+        BOOST_REQUIRE_EQUAL(loop.queue_size(priority::high), 0u);
+        BOOST_REQUIRE_EQUAL(loop.queue_size(priority::low), 0u);
+    }
+
+    BOOST_AUTO_TEST_CASE(watermarks_check)
+    {
+        print_current_test_name();
+
+        using policy = event_loop::overflow_policy;
+
+        {
+            event_loop loop;
+
+            std::vector<bool> signals;
+            loop.set_watermarks(4, 1, policy::reject, [&signals](bool overloaded) {
+                signals.push_back(overloaded);
+            });
+
+            size_t accepted = 0;
+            std::atomic_size_t executed(0);
+            for (size_t ci = 0; ci < 10; ++ci)
+            {
+                if (loop.post([&executed]() { ++executed; }))
+                    ++accepted;
+            }
+
+            BOOST_REQUIRE_EQUAL(accepted, 4u);
+            BOOST_REQUIRE_EQUAL(loop.rejected(), 6u);
+            BOOST_REQUIRE(loop.is_overloaded());
+
+            std::atomic_bool resumed(false);
+            loop.on_low_watermark([&resumed]() { resumed = true; });
+            BOOST_REQUIRE(!resumed);
+
+            loop.start();
+
+            BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+
+            BOOST_REQUIRE_EQUAL(executed.load(), 4u);
+            BOOST_REQUIRE(resumed);
+            BOOST_REQUIRE(!loop.is_overloaded());
+
+            loop.stop();
+
+            BOOST_REQUIRE_EQUAL(signals.size(), 2u);
+            BOOST_REQUIRE(signals[0]);
+            BOOST_REQUIRE(!signals[1]);
+        }
+
+        {
+            event_loop loop;
+
+            loop.set_watermarks(4, 1, policy::reject);
+
+            // low watermark is reached even if handlers throw
+            for (size_t ci = 0; ci < 4; ++ci)
+            {
+                BOOST_REQUIRE(loop.post([]() { throw std::runtime_error("test"); }));
+            }
+            BOOST_REQUIRE(!loop.post([]() {}));
+            BOOST_REQUIRE(loop.is_overloaded());
+
+            std::promise<void> resumed;
+            loop.on_low_watermark([&resumed]() { resumed.set_value(); });
+
+            loop.start();
+
+            BOOST_REQUIRE(resumed.get_future().wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+            BOOST_REQUIRE(!loop.is_overloaded());
+
+            // start notification follows throwing handlers
+            BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+
+            loop.stop();
+        }
+
+        {
+            event_loop loop;
+
+            loop.set_watermarks(4, 1, policy::reject);
+
+            std::atomic_bool blocked(true);
+            std::vector<size_t> results;
+            BOOST_REQUIRE(loop.post([&blocked]() {
+                while (blocked)
+                    std::this_thread::yield();
+            }));
+
+            loop.start();
+
+            for (size_t ci = 0; ci < 3; ++ci)
+            {
+                BOOST_REQUIRE(loop.post([&results, ci]() { results.push_back(ci); }));
+            }
+
+            // rejected handler waits for low watermark
+            BOOST_REQUIRE(!loop.post_undroppable([]() {}));
+            std::promise<void> deferred;
+            BOOST_REQUIRE(loop.post_or_defer([&results, &deferred]() {
+                results.push_back(3);
+                deferred.set_value();
+            }));
+
+            blocked = false;
+
+            BOOST_REQUIRE(deferred.get_future().wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+
+            loop.stop();
+
+            BOOST_REQUIRE_EQUAL(loop.rejected(), 2u);
+            BOOST_REQUIRE(results == std::vector<size_t>({ 0, 1, 2, 3 }));
+        }
+
+        {
+            event_loop loop;
+
+            loop.set_watermarks(4, 1, policy::drop_oldest);
+
+            std::vector<size_t> results;
+            for (size_t ci = 0; ci < 6; ++ci)
+            {
+                BOOST_REQUIRE(loop.post([&results, ci]() { results.push_back(ci); }));
+            }
+
+            loop.start();
+
+            BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+
+            loop.stop();
+
+            BOOST_REQUIRE_EQUAL(loop.dropped(), 2u);
+            BOOST_REQUIRE(results == std::vector<size_t>({ 2, 3, 4, 5 }));
+        }
+
+        {
+            event_loop loop;
+
+            loop.set_watermarks(4, 1, policy::drop_oldest);
+
+            std::vector<size_t> results;
+            for (size_t ci = 0; ci < 6; ++ci)
+            {
+                if (ci < 2)
+                    BOOST_REQUIRE(loop.post_undroppable([&results, ci]() { results.push_back(ci); }));
+                else
+                    BOOST_REQUIRE(loop.post([&results, ci]() { results.push_back(ci); }));
+            }
+
+            loop.start();
+
+            BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+
+            loop.stop();
+
+            BOOST_REQUIRE_EQUAL(loop.dropped(), 2u);
+            BOOST_REQUIRE(results == std::vector<size_t>({ 0, 1, 4, 5 }));
+        }
+
+        {
+            event_loop loop;
+
+            loop.set_watermarks(4, 1, policy::drop_oldest);
+
+            // queue is bounded while loop is not running
+            std::atomic_size_t executed(0);
+            for (size_t ci = 0; ci < 1000; ++ci)
+            {
+                BOOST_REQUIRE(loop.post([&executed]() { ++executed; }));
+                BOOST_REQUIRE_LE(loop.queue_size(), 4u);
+            }
+
+            // every handler of batch is counted
+            std::vector<std::function<void()>> batch;
+            for (size_t ci = 0; ci < 3; ++ci)
+                batch.emplace_back([&executed]() { ++executed; });
+            BOOST_REQUIRE(loop.post_bulk(batch));
+            BOOST_REQUIRE_EQUAL(loop.queue_size(), 4u);
+            BOOST_REQUIRE_EQUAL(loop.dropped(), 999u);
+
+            // waiting handler is not dropped by following posts
+            std::atomic_bool waited(false);
+            std::thread waiter([&loop, &waited]() {
+                waited = loop.wait_async(false, []() { return true; });
+            });
+            while (loop.queue_size() < 5)
+                std::this_thread::yield();
+            for (size_t ci = 0; ci < 10; ++ci)
+                BOOST_REQUIRE(loop.post([&executed]() { ++executed; }));
+
+            loop.start();
+
+            waiter.join();
+            BOOST_REQUIRE(waited);
+
+            BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+
+            loop.stop();
+
+            BOOST_REQUIRE_EQUAL(executed.load(), 3u);
+        }
+
+        {
+            event_loop loop;
+
+            loop.set_watermarks(2, 0, policy::drop_oldest);
+
+            // nothing to drop for undroppable handler
+            BOOST_REQUIRE(loop.post_undroppable([]() {}));
+            BOOST_REQUIRE(loop.post_undroppable([]() {}));
+            BOOST_REQUIRE(!loop.post_undroppable([]() {}));
+            BOOST_REQUIRE(!loop.post([]() {}));
+            BOOST_REQUIRE_EQUAL(loop.rejected(), 2u);
+            BOOST_REQUIRE_EQUAL(loop.dropped(), 0u);
+        }
+
+        {
+            event_loop loop;
+
+            loop.set_watermarks(2, 0, policy::reject);
+
+            loop.start();
+
+            while (!loop.is_running())
+                std::this_thread::yield();
+
+            BOOST_REQUIRE(loop.post([]() { std::this_thread::sleep_for(std::chrono::milliseconds(50)); }));
+            BOOST_REQUIRE(loop.post([]() { throw std::runtime_error("handler fails"); }));
+            BOOST_REQUIRE(!loop.post([]() {}));
+            BOOST_REQUIRE(loop.is_overloaded());
+
+            // waiter is released by stop
+            auto token = std::make_shared<int>(0);
+            std::atomic_bool resumed(false);
+            loop.on_low_watermark([token, &resumed]() { resumed = true; });
+            BOOST_REQUIRE_EQUAL(token.use_count(), 2);
+
+            loop.stop();
+
+            BOOST_REQUIRE(!resumed);
+            BOOST_REQUIRE_EQUAL(token.use_count(), 1);
+        }
+
+        {
+            event_loop loop;
+
+            loop.start();
+
+            BOOST_REQUIRE(loop.post([]() { throw std::runtime_error("handler fails"); }));
+
+            BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+
+            // queue is released by failed handler
+            // (waiting handler itself is released right after result)
+            for (size_t ci = 0; ci < 100 && loop.queue_size() > 0; ++ci)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            BOOST_REQUIRE_EQUAL(loop.queue_size(), 0u);
+
+            loop.stop();
+        }
+
+        {
+            event_loop loop;
+
+            loop.set_watermarks(2, 0, policy::block);
+
+            loop.start();
+
+            BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+
+            std::atomic_size_t executed(0);
+            loop.post([]() { std::this_thread::sleep_for(std::chrono::milliseconds(50)); });
+
+            auto started = std::chrono::steady_clock::now();
+            for (size_t ci = 0; ci < 4; ++ci)
+            {
+                BOOST_REQUIRE(loop.post([&executed]() { ++executed; }));
+            }
+            auto elapsed = std::chrono::steady_clock::now() - started;
+
+            // producer has waited for slow handler
+            BOOST_REQUIRE_GE(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(), 20);
+
+            BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+
+            loop.stop();
+
+            BOOST_REQUIRE_EQUAL(executed.load(), 4u);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(latency_histogram_check)
+    {
+        print_current_test_name();
+
+        latency_histogram histogram;
+
+        for (int64_t ci = 1; ci <= 1000; ++ci)
+        {
+            histogram.record(std::chrono::microseconds(ci));
+        }
+
+        auto snapshot = histogram.get_snapshot();
+
+        BOOST_REQUIRE_EQUAL(snapshot.count, 1000u);
+        BOOST_REQUIRE_EQUAL(snapshot.max.count(), std::chrono::nanoseconds(std::chrono::microseconds(1000)).count());
+
+        // relative error is less than 1/16
+        auto check = [](const latency_histogram::duration& value, const int64_t expected_us) {
+            auto expected = std::chrono::nanoseconds(std::chrono::microseconds(expected_us)).count();
+            BOOST_REQUIRE_GE(value.count(), expected);
+            BOOST_REQUIRE_LE(value.count(), expected + expected / 16);
+        };
+        check(snapshot.p50, 500);
+        check(snapshot.p90, 900);
+        check(snapshot.p99, 990);
+        check(snapshot.mean, 500);
+
+        histogram.reset();
+        BOOST_REQUIRE_EQUAL(histogram.count(), 0u);
+        BOOST_REQUIRE_EQUAL(histogram.percentile(0.5).count(), 0);
+    }
+
+    BOOST_AUTO_TEST_CASE(loop_metrics_check)
+    {
+        print_current_test_name();
+
+        event_loop loop;
+
+        loop.enable_metrics();
+        loop.start();
+
+        loop.post([]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        });
+        for (size_t ci = 0; ci < 10; ++ci)
+        {
+            loop.post([]() {});
+        }
+        loop.post([]() {
+            throw std::runtime_error("test");
+        });
+
+        BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+
+        // wait_async wakes up before its handler is counted,
+        // so metrics are settled by stopped loop only
+        loop.stop();
+
+        auto m = loop.get_metrics();
+
+        // start notification, 12 handlers and wait_async
+        BOOST_REQUIRE_EQUAL(m.posts, 14u);
+        BOOST_REQUIRE_EQUAL(m.completions, 13u);
+        BOOST_REQUIRE_EQUAL(m.exceptions, 1u);
+        BOOST_REQUIRE_EQUAL(m.run_time.count, 13u);
+        BOOST_REQUIRE_GE(m.run_time.max.count(), std::chrono::nanoseconds(std::chrono::milliseconds(10)).count());
+        // handlers queued behind slow one
+        BOOST_REQUIRE_GE(m.queue_wait.max.count(), std::chrono::nanoseconds(std::chrono::milliseconds(5)).count());
+    }
+
+    BOOST_AUTO_TEST_CASE(watchdog_check)
+    {
+        print_current_test_name();
+
+        event_loop loop;
+        loop.change_thread_name("stuck");
+        loop.start();
+
+        event_loop_watchdog watchdog(std::chrono::milliseconds(50), true);
+
+        std::mutex stall_guard;
+        std::string stall_loop_name;
+        std::chrono::milliseconds stall_time { 0 };
+        std::string stall_stack;
+        watchdog.set_stall_callback([&](const std::string& loop_name, const std::chrono::milliseconds& stalled, const std::string& stack) {
+            std::lock_guard<std::mutex> lck(stall_guard);
+            stall_loop_name = loop_name;
+            stall_time = stalled;
+            stall_stack = stack;
+        });
+        watchdog.watch(loop);
+        watchdog.start();
+
+        loop.post([]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        });
+        // fast handlers are not reported
+        for (size_t ci = 0; ci < 10; ++ci)
+        {
+            loop.post([]() {});
+        }
+
+        BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+
+        watchdog.stop();
+
+        // the slow handler is reported once
+        BOOST_REQUIRE_EQUAL(watchdog.stalls(), 1u);
+        BOOST_REQUIRE_EQUAL(loop.get_metrics().stalls, 1u);
+
+        {
+            std::lock_guard<std::mutex> lck(stall_guard);
+            BOOST_REQUIRE_EQUAL(stall_loop_name, "stuck");
+            BOOST_REQUIRE_GE(stall_time.count(), 50);
+            LOG_TRACE("Stack of stuck loop:\n"
+                      << stall_stack);
+        }
+
+        // restarted loop runs in new thread
+        loop.stop();
+        loop.change_thread_name("restarted");
+        loop.start();
+
+        watchdog.start();
+
+        for (size_t ci = 0; ci < 2; ++ci)
+        {
+            loop.post([]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            });
+        }
+
+        BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+
+        watchdog.stop();
+
+        BOOST_REQUIRE_EQUAL(watchdog.stalls(), 3u);
+        {
+            std::lock_guard<std::mutex> lck(stall_guard);
+            BOOST_REQUIRE_EQUAL(stall_loop_name, "restarted");
+        }
+
+        watchdog.unwatch(loop);
+        loop.stop();
+    }
+
+    BOOST_AUTO_TEST_CASE(thread_options_check)
+    {
+        print_current_test_name();
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+        event_loop loop;
+
+        thread_options options;
+        options.cpus = { 0 };
+        options.nice = 1;
+        loop.set_thread_options(options);
+        loop.start();
+
+        int cpu = -1;
+        BOOST_REQUIRE(loop.wait_async(-1, [&cpu]() {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            pthread_getaffinity_np(pthread_self(), sizeof(set), &set);
+            return CPU_COUNT(&set) == 1 && CPU_ISSET(0, &set) ? sched_getcpu() : -1;
+        }) == 0);
+
+        // change for running loop
+        options.cpus = { static_cast<int>(std::max(1u, std::thread::hardware_concurrency())) - 1 };
+        loop.set_thread_options(options);
+
+        BOOST_REQUIRE(loop.wait_async(-1, []() {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            pthread_getaffinity_np(pthread_self(), sizeof(set), &set);
+            return CPU_COUNT(&set);
+        }) == 1);
+
+        auto cpu_count = []() {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            pthread_getaffinity_np(pthread_self(), sizeof(set), &set);
+            return CPU_COUNT(&set);
+        };
+        auto last_cpu = static_cast<int>(std::max(1u, std::thread::hardware_concurrency())) - 1;
+
+        // loop thread is back to CPUs inherited from this thread
+        auto initial_cpus = cpu_count();
+        loop.set_thread_options({});
+
+        BOOST_REQUIRE_EQUAL(loop.wait_async(-1, cpu_count), initial_cpus);
+
+        loop.stop();
+
+        // thread applies options of every owner once after change
+        std::thread worker([&]() {
+            deferred_thread_options first, second;
+
+            thread_options options;
+            options.cpus = { 0 };
+            first.set(options);
+            options.cpus = { last_cpu };
+            second.set(options);
+
+            first.apply();
+            BOOST_REQUIRE_EQUAL(sched_getcpu(), 0);
+            second.apply();
+            BOOST_REQUIRE_EQUAL(sched_getcpu(), last_cpu);
+            first.apply();
+            BOOST_REQUIRE_EQUAL(sched_getcpu(), last_cpu);
+
+            first.set({});
+            first.apply();
+            BOOST_REQUIRE_EQUAL(cpu_count(), initial_cpus);
+        });
+        worker.join();
+
+        // invalid options are skipped
+        thread_options invalid;
+        invalid.cpus = { -1 };
+        BOOST_REQUIRE(!apply_thread_options(invalid));
+        BOOST_REQUIRE(apply_thread_options({}));
+#endif
+    }
+
+    BOOST_AUTO_TEST_CASE(async_sleep_check)
+    {
+        print_current_test_name();
+
+#if BOOST_VERSION >= 107000
+        event_loop loop;
+        loop.start();
+
+        using clock_type = std::chrono::steady_clock;
+        auto start = clock_type::now();
+
+        auto wait = loop.async_sleep(std::chrono::milliseconds(20), boost::asio::use_future);
+        BOOST_REQUIRE(wait.wait_for(std::chrono::seconds(1)) == std::future_status::ready);
+        BOOST_REQUIRE_GE(std::chrono::duration_cast<std::chrono::milliseconds>(clock_type::now() - start).count(), 20);
+
+#if defined(SERVER_LIB_COROUTINES)
+        // many coroutines wait in single loop thread
+        constexpr size_t coroutines = 1000;
+        std::atomic_size_t done(0);
+        for (size_t ci = 0; ci < coroutines; ++ci)
+        {
+            loop.spawn([&loop, &done, ci](boost::asio::yield_context yield) {
+                loop.async_sleep(std::chrono::milliseconds(1 + ci % 10), yield);
+                loop.async_sleep(std::chrono::milliseconds(1 + ci % 10), yield);
+                if (loop.is_this_loop())
+                    ++done;
+            });
+        }
+
+        for (size_t ci = 0; ci < 100 && done < coroutines; ++ci)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        BOOST_REQUIRE_EQUAL(done.load(), coroutines);
+#endif
+
+        loop.stop();
+#endif
+    }
+
+    BOOST_AUTO_TEST_CASE(loop_future_check)
+    {
+        print_current_test_name();
+
+        event_loop loop1;
+        event_loop loop2;
+        loop1.start();
+        loop2.start();
+
+        // blocking wait from own loop is inline call instead of deadlock
+        BOOST_REQUIRE_EQUAL(loop1.wait_async(0, [&loop1]() {
+            return loop1.wait_async(0, []() { return 1; }) + 1;
+        }),
+                            2);
+
+        // chain through loops
+        std::thread::id loop2_id;
+        auto f = loop1.async_call([]() { return 10; })
+                     .then(loop2, [&loop2_id](int value) {
+                         loop2_id = std::this_thread::get_id();
+                         return std::to_string(value * 2);
+                     })
+                     .then(loop1, [](std::string value) {
+                         return value + "!";
+                     });
+        BOOST_REQUIRE_EQUAL(f.get(), "20!");
+        BOOST_REQUIRE(loop2_id == loop2.wait_async(std::thread::id {}, []() { return std::this_thread::get_id(); }));
+
+        // exception is passed through chain without calls
+        bool called = false;
+        auto f_error = loop1.async_call([]() -> int { throw std::runtime_error("test"); })
+                           .then(loop2, [&called](int) { called = true; });
+        BOOST_REQUIRE_THROW(f_error.get(), std::runtime_error);
+        BOOST_REQUIRE(!called);
+
+        // same loop call and continuation are inline
+        BOOST_REQUIRE(loop1.wait_async(false, [&loop1]() {
+            bool inline_call = false;
+            auto f = loop1.async_call([&inline_call]() { inline_call = true; });
+            bool inline_then = false;
+            f.then(loop1, [&inline_then]() { inline_then = true; });
+            return inline_call && inline_then;
+        }));
+
+        loop_promise<int, event_loop> p(loop2);
+        auto f_promise = p.get_future();
+        BOOST_REQUIRE(!f_promise.is_ready());
+        loop2.post([p]() mutable { p.set_value(5); });
+        BOOST_REQUIRE_EQUAL(f_promise.get(), 5);
+
+        loop1.stop();
+        loop2.stop();
+    }
+
+    BOOST_AUTO_TEST_CASE(loop_future_broken_check)
+    {
+        print_current_test_name();
+
+        event_loop loop;
+        loop.set_watermarks(1, 0, event_loop::overflow_policy::drop_oldest);
+
+        // handler with promise is dropped
+        loop_promise<int, event_loop> p(loop);
+        auto f = p.get_future();
+        BOOST_REQUIRE(loop.post([p]() mutable { p.set_value(1); }));
+        p = loop_promise<int, event_loop>(loop);
+
+        // chain is broken as well
+        bool called = false;
+        auto f_next = p.get_future().then(loop, [&called](int) { called = true; });
+
+        BOOST_REQUIRE(loop.post([]() {}));
+        BOOST_REQUIRE_EQUAL(loop.dropped(), 1u);
+
+        BOOST_REQUIRE(f.is_ready());
+        BOOST_REQUIRE_THROW(f.get(), std::future_error);
+
+        // waiter is released when the last promise is destroyed
+        std::thread th([f_next = std::move(f_next)]() mutable {
+            BOOST_CHECK_THROW(f_next.get(), std::future_error);
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        p = loop_promise<int, event_loop>(loop);
+        th.join();
+        BOOST_REQUIRE(!called);
+
+        // drain is not blocked by concurrent stop
+        loop.set_watermarks(0, 0);
+        loop.start();
+        BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+        BOOST_REQUIRE(loop.post([]() { std::this_thread::sleep_for(std::chrono::milliseconds(100)); }));
+        std::thread stopper([&loop]() {
+            while (!loop.is_draining())
+                std::this_thread::yield();
+            loop.stop();
+        });
+        loop.drain(std::chrono::seconds(10));
+        stopper.join();
+        BOOST_REQUIRE(!loop.is_running());
+    }
+
+    BOOST_AUTO_TEST_CASE(drain_check)
+    {
+        print_current_test_name();
+
+        {
+            event_loop loop;
+            loop.start();
+            BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+
+            std::atomic_size_t executed(0);
+            for (size_t ci = 0; ci < 100; ++ci)
+            {
+                loop.post([&loop, &executed]() {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                    ++executed;
+                    // queued handlers could continue work
+                    if (loop.is_draining())
+                        loop.post([&executed]() { ++executed; });
+                });
+            }
+
+            std::thread th([&loop]() {
+                while (!loop.is_draining())
+                    std::this_thread::yield();
+                // new posts are rejected
+                BOOST_CHECK(!loop.post([]() {}));
+            });
+
+            BOOST_REQUIRE_EQUAL(loop.drain(std::chrono::seconds(5)), 0u);
+            th.join();
+
+            BOOST_REQUIRE(!loop.is_running());
+            BOOST_REQUIRE_GT(executed.load(), 100u);
+            BOOST_REQUIRE_EQUAL(loop.rejected(), 1u);
+        }
+
+        {
+            event_loop loop;
+            loop.start();
+            BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+
+            for (size_t ci = 0; ci < 50; ++ci)
+            {
+                loop.post([]() {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                });
+            }
+
+            auto dropped = loop.drain(std::chrono::milliseconds(50));
+            BOOST_REQUIRE_GT(dropped, 0u);
+            BOOST_REQUIRE_LT(dropped, 50u);
+            BOOST_REQUIRE(!loop.is_running());
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(polling_check)
+    {
+        print_current_test_name();
+
+        for (auto queue : { event_loop::queue_type::asio, event_loop::queue_type::lockfree })
+        {
+            event_loop loop(true, queue);
+            loop.set_polling(1000);
+            BOOST_REQUIRE_EQUAL(loop.polling(), 1000u);
+
+            loop.start();
+            BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+
+            std::atomic_size_t executed(0);
+            for (size_t ci = 0; ci < 20; ++ci)
+            {
+                loop.post([&executed]() { ++executed; });
+                // let loop to exhaust spin budget
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+            BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+            BOOST_REQUIRE_EQUAL(executed.load(), 20u);
+
+            // timers work in polling mode
+            std::atomic_bool timer_fired(false);
+            loop.start_timer(std::chrono::milliseconds(5), [&timer_fired]() { timer_fired = true; });
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            BOOST_REQUIRE(timer_fired);
+
+            auto m = loop.get_metrics();
+            BOOST_REQUIRE_GT(m.idle_spins, 0u);
+            BOOST_REQUIRE_GT(m.wakeups, 0u);
+
+            loop.stop();
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(loop_owned_check)
+    {
+        print_current_test_name();
+
+        struct tracked
+        {
+            tracked(std::vector<int>& log_, std::thread::id& destroyed_in_, std::atomic_int& destroyed_)
+                : log(log_)
+                , destroyed_in(destroyed_in_)
+                , destroyed(destroyed_)
+            {
+            }
+
+            ~tracked()
+            {
+                log.push_back(-1);
+                destroyed_in = std::this_thread::get_id();
+                ++destroyed;
+            }
+
+            std::vector<int>& log;
+            std::thread::id& destroyed_in;
+            std::atomic_int& destroyed;
+        };
+
+        event_loop loop;
+        loop.start();
+        BOOST_REQUIRE(loop.wait_async(false, []() { return true; }));
+
+        std::vector<int> log;
+        std::thread::id destroyed_in;
+        std::atomic_int destroyed(0);
+
+        // destruction handler passes through all lanes
+        auto wait_destroyed = [&destroyed](const int expected) {
+            for (int ci = 0; ci < 500 && destroyed.load() < expected; ++ci)
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            return destroyed.load() == expected;
+        };
+
+        {
+            auto owned = make_loop_owned<tracked>(loop, log, destroyed_in, destroyed);
+            BOOST_REQUIRE(owned);
+
+            // handlers don't hold object
+            auto* object = owned.get();
+            for (int ci = 0; ci < 10; ++ci)
+            {
+                loop.post([object, ci]() {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    object->log.push_back(ci);
+                });
+            }
+
+            event_loop::owned<tracked> moved = std::move(owned);
+            BOOST_REQUIRE(!owned);
+            BOOST_REQUIRE(moved);
+        }
+        BOOST_REQUIRE(wait_destroyed(1));
+
+        // destroyed in home loop after posted handlers
+        BOOST_REQUIRE_EQUAL(log.size(), 11u);
+        BOOST_REQUIRE_EQUAL(log.back(), -1);
+        auto loop_id = loop.wait_async(std::thread::id {}, []() { return std::this_thread::get_id(); });
+        BOOST_REQUIRE(destroyed_in == loop_id);
+
+        log.clear();
+        {
+            auto shared = make_loop_owned<tracked>(loop, log, destroyed_in, destroyed).share();
+            auto* object = shared.get();
+            loop.post([object]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                object->log.push_back(1);
+            });
+        }
+        BOOST_REQUIRE(wait_destroyed(2));
+
+        BOOST_REQUIRE_EQUAL(log.size(), 2u);
+        BOOST_REQUIRE_EQUAL(log.back(), -1);
+
+        // low lane gives way to normal one, but not to destruction
+        log.clear();
+        {
+            std::promise<void> release;
+            auto released = release.get_future().share();
+            BOOST_REQUIRE(loop.post([released]() { released.wait(); }));
+
+            auto owned = make_loop_owned<tracked>(loop, log, destroyed_in, destroyed);
+            auto* object = owned.get();
+            BOOST_REQUIRE(loop.post(event_loop::priority::low, [object]() {
+                object->log.push_back(1);
+            }));
+            BOOST_REQUIRE(loop.post(event_loop::priority::high, [object]() {
+                object->log.push_back(2);
+            }));
+            owned.reset();
+
+            release.set_value();
+        }
+        BOOST_REQUIRE(wait_destroyed(3));
+
+        BOOST_REQUIRE(log == std::vector<int>({ 2, 1, -1 }));
+
+        // object waits for stopped loop
+        loop.stop();
+        log.clear();
+        {
+            auto owned = make_loop_owned<tracked>(loop, log, destroyed_in, destroyed);
+            auto* object = owned.get();
+            BOOST_REQUIRE(loop.post(event_loop::priority::low, [object]() {
+                object->log.push_back(1);
+            }));
+        }
+        BOOST_REQUIRE(log.empty());
+
+        loop.start();
+        BOOST_REQUIRE(wait_destroyed(4));
+
+        BOOST_REQUIRE(log == std::vector<int>({ 1, -1 }));
+
+        loop.stop();
+
+        // or it is destroyed with loop queues
+        {
+            event_loop stopped_loop;
+            auto owned = make_loop_owned<tracked>(stopped_loop, log, destroyed_in, destroyed);
+        }
+        BOOST_REQUIRE_EQUAL(destroyed.load(), 5);
+
+        // drain timeout doesn't destroy object ahead of undroppable handlers
+        log.clear();
+        {
+            event_loop drained_loop;
+            drained_loop.start();
+            BOOST_REQUIRE(drained_loop.wait_async(false, []() { return true; }));
+
+            std::promise<void> release;
+            auto released = release.get_future().share();
+            BOOST_REQUIRE(drained_loop.post([released]() { released.wait(); }));
+            for (int ci = 0; ci < 3; ++ci)
+            {
+                BOOST_REQUIRE(drained_loop.post([]() {}));
+            }
+
+            auto owned = make_loop_owned<tracked>(drained_loop, log, destroyed_in, destroyed);
+            auto* object = owned.get();
+            for (int ci = 0; ci < 3; ++ci)
+            {
+                BOOST_REQUIRE(drained_loop.post_undroppable([object, ci]() {
+                    object->log.push_back(ci);
+                }));
+            }
+            owned.reset();
+
+            auto dropped = std::async(std::launch::async, [&drained_loop]() {
+                return drained_loop.drain(std::chrono::milliseconds(10));
+            });
+            // deadline is expired while loop is blocked
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            release.set_value();
+
+            BOOST_REQUIRE_GE(dropped.get(), 3u);
+        }
+        BOOST_REQUIRE_EQUAL(destroyed.load(), 6);
+
+        BOOST_REQUIRE(log == std::vector<int>({ 0, 1, 2, -1 }));
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace server_lib
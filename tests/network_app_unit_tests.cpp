@@ -391,6 +391,86 @@ namespace tests {
         BOOST_REQUIRE(protocol);
     }
 
+    BOOST_AUTO_TEST_CASE(buffer_chain_check)
+    {
+        print_current_test_name();
+
+        buffer_chain chain;
+
+        chain.append(buffer_view { std::string { "abc\r" } });
+        chain.append(buffer_view { std::string { "\ndef" } });
+
+        BOOST_REQUIRE_EQUAL(chain.size(), 8u);
+        BOOST_REQUIRE_EQUAL(chain.at(5), 'd');
+        BOOST_REQUIRE_EQUAL(chain.find("\r\n"), 3u);
+        BOOST_REQUIRE_EQUAL(chain.find("fg"), buffer_chain::npos);
+        BOOST_REQUIRE_EQUAL(chain.find("\r\n", 3), 3u);
+        BOOST_REQUIRE_EQUAL(chain.find("\r\n", 4), buffer_chain::npos);
+        BOOST_REQUIRE_EQUAL(chain.find("d", 4), 5u);
+        BOOST_REQUIRE_EQUAL(chain.find("ef", 6), 6u);
+
+        // slice inside block shares it
+        auto first = chain.slice(0, 4);
+        BOOST_REQUIRE_EQUAL(first.to_string(), "abc\r");
+        BOOST_REQUIRE(chain.slice(1, 2).data() == first.data() + 1);
+
+        BOOST_REQUIRE_EQUAL(chain.slice(2, 4).to_string(), "c\r\nd");
+
+        chain.consume(5);
+
+        BOOST_REQUIRE_EQUAL(chain.size(), 3u);
+        BOOST_REQUIRE_EQUAL(chain.to_string(), "def");
+    }
+
+    BOOST_AUTO_TEST_CASE(msg_builder_parse_by_chain_check)
+    {
+        print_current_test_name();
+
+        const std::string msg1 { "test" };
+        const std::string msg2 { "next test" };
+
+        msg_builder builder { 1024 };
+
+        auto data1 = builder.create(msg1).to_network_string();
+        auto data2 = builder.create(msg2).to_network_string();
+
+        std::vector<char> received { data1.begin(), data1.end() };
+        received.insert(received.end(), data2.begin(), data2.end() - 2);
+        const char* received_data = received.data();
+
+        buffer_chain chain;
+        chain.append(buffer_view { std::move(received) });
+
+        std::vector<app_unit> units;
+        auto parse = [&]() {
+            builder << chain;
+            if (builder.unit_ready())
+            {
+                units.push_back(builder.get_unit());
+                builder.reset();
+            }
+        };
+
+        parse();
+        parse();
+
+        BOOST_REQUIRE_EQUAL(units.size(), 1u);
+        // unit references received buffer
+        BOOST_REQUIRE(units[0].as_view().data() == received_data + data1.size() - msg1.size());
+        BOOST_REQUIRE(units[0] == app_unit { msg1 });
+        // string is copied, unit keeps view
+        BOOST_REQUIRE_EQUAL(units[0].as_string(), msg1);
+        BOOST_REQUIRE(units[0].is_view());
+
+        chain.append(buffer_view { data2.substr(data2.size() - 2) });
+
+        parse();
+
+        BOOST_REQUIRE_EQUAL(units.size(), 2u);
+        BOOST_REQUIRE(chain.empty());
+        BOOST_REQUIRE_EQUAL(units[1].as_string(), msg2);
+    }
+
     BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace tests
@@ -0,0 +1,838 @@
+#include "network_common.h"
+
+#include <server_lib/event_loop.h>
+#include <server_lib/event_loop_pool.h>
+#include <server_lib/logging_helper.h>
+
+#include <server_lib/network/network_server.h>
+#include <server_lib/network/network_client.h>
+#include <server_lib/network/raw_builder.h>
+#include <server_lib/network/msg_builder.h>
+#include <server_lib/network/asio_transport.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <future>
+#include <map>
+#include <vector>
+#include <set>
+
+namespace server_lib {
+namespace tests {
+
+    using namespace server_lib::network;
+
+    namespace {
+        struct write_counters
+        {
+            std::atomic_size_t writes { 0 };
+            std::atomic_size_t in_flight { 0 };
+            std::atomic_size_t max_in_flight { 0 };
+        };
+
+        // connection that counts writes of wrapped one
+        class counting_connection : public tcp_connection_i
+        {
+        public:
+            counting_connection(const std::shared_ptr<tcp_connection_i>& connection, const std::shared_ptr<write_counters>& counters)
+                : _connection(connection)
+                , _counters(counters)
+            {
+            }
+
+            bool is_connected() const override
+            {
+                return _connection->is_connected();
+            }
+
+            event_loop* io_loop() const override
+            {
+                return _connection->io_loop();
+            }
+
+            void async_read(read_request& request) override
+            {
+                _connection->async_read(request);
+            }
+
+            void async_write(write_request& request) override
+            {
+                auto counters = _counters;
+                auto callback = std::move(request.async_write_callback);
+                request.async_write_callback = [counters, callback](write_result& result) {
+                    --counters->in_flight;
+                    if (callback)
+                        callback(result);
+                };
+
+                ++counters->writes;
+                auto in_flight = ++counters->in_flight;
+                auto max_in_flight = counters->max_in_flight.load();
+                while (in_flight > max_in_flight && !counters->max_in_flight.compare_exchange_weak(max_in_flight, in_flight))
+                {
+                }
+
+                _connection->async_write(request);
+            }
+
+            void set_no_delay(bool enable) override
+            {
+                _connection->set_no_delay(enable);
+            }
+
+            void set_cork(bool enable) override
+            {
+                _connection->set_cork(enable);
+            }
+
+            void disconnect() override
+            {
+                _connection->disconnect();
+            }
+
+            void set_on_disconnect_handler(const disconnection_callback_type& callback) override
+            {
+                _connection->set_on_disconnect_handler(callback);
+            }
+
+        private:
+            std::shared_ptr<tcp_connection_i> _connection;
+            std::shared_ptr<write_counters> _counters;
+        };
+
+        class counting_client : public tcp_client_i
+        {
+        public:
+            counting_client(const std::shared_ptr<tcp_client_i>& client, const std::shared_ptr<write_counters>& counters)
+                : _client(client)
+                , _counters(counters)
+            {
+            }
+
+            void connect(const std::string& addr, uint16_t port, uint32_t timeout_ms) override
+            {
+                _client->connect(addr, port, timeout_ms);
+            }
+
+            void disconnect(bool wait_for_removal) override
+            {
+                _client->disconnect(wait_for_removal);
+            }
+
+            bool is_connected() const override
+            {
+                return _client->is_connected();
+            }
+
+            void set_nb_workers(uint8_t nb_threads) override
+            {
+                _client->set_nb_workers(nb_threads);
+            }
+
+            void set_worker_options(const thread_options& options) override
+            {
+                _client->set_worker_options(options);
+            }
+
+            std::shared_ptr<tcp_connection_i> create_connection() override
+            {
+                return std::make_shared<counting_connection>(_client->create_connection(), _counters);
+            }
+
+            void set_on_disconnection_handler(const disconnection_callback_type& callback) override
+            {
+                _client->set_on_disconnection_handler(callback);
+            }
+
+        private:
+            std::shared_ptr<tcp_client_i> _client;
+            std::shared_ptr<write_counters> _counters;
+        };
+    } // namespace
+
+    BOOST_FIXTURE_TEST_SUITE(network_asio_tests, basic_network_fixture)
+
+    BOOST_AUTO_TEST_CASE(asio_echo_check)
+    {
+        print_current_test_name();
+
+        event_loop server_th;
+        event_loop client_th;
+
+        server_th.change_thread_name("!S");
+        client_th.change_thread_name("!C");
+
+        raw_builder protocol;
+
+        // sockets are served by callback threads
+        network_server server(create_asio_server());
+        network_client client(create_asio_client(&client_th));
+
+        std::string host = get_default_address();
+        auto port = get_free_port();
+
+        // bigger than socket buffer to check partial writes
+        const std::string large_data(4 * 1024 * 1024, 'x');
+        const std::string ping_data = "ping";
+
+        std::shared_ptr<app_connection_i> hold_connection;
+        std::string client_received;
+        bool server_disconnected = false;
+        bool client_disconnected = false;
+
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        auto server_recieve_callback = [&](app_connection_i& conn, app_unit& unit) {
+            BOOST_REQUIRE(server_th.is_this_loop());
+
+            // echo
+            BOOST_REQUIRE_NO_THROW(conn.send(protocol.create(unit.as_string())).commit());
+        };
+
+        auto server_disconnect_callback = [&](app_connection_i& conn) {
+            LOG_TRACE("********* server_disconnect_callback");
+
+            BOOST_REQUIRE(server_th.is_this_loop());
+            BOOST_REQUIRE_EQUAL(reinterpret_cast<uint64_t>(&conn), reinterpret_cast<uint64_t>(hold_connection.get()));
+
+            hold_connection.reset();
+
+            server.stop();
+
+            //done test
+            std::unique_lock<std::mutex> lck(done_test_cond_guard);
+            server_disconnected = true;
+            done_test = client_disconnected;
+            done_test_cond.notify_one();
+        };
+
+        auto server_new_connection_callback = [&](const std::shared_ptr<app_connection_i>& connection) {
+            LOG_TRACE("********* server_new_connection_callback");
+
+            BOOST_REQUIRE(server_th.is_this_loop());
+            BOOST_REQUIRE(connection);
+
+            connection->set_on_receive_handler(server_recieve_callback);
+            connection->set_on_disconnect_handler(server_disconnect_callback);
+
+            hold_connection = connection;
+        };
+
+        auto client_recieve_callback = [&](app_unit& unit) {
+            BOOST_REQUIRE(client_th.is_this_loop());
+
+            client_received += unit.as_string();
+
+            if (client_received.size() == ping_data.size() + large_data.size())
+            {
+                LOG_TRACE("********* client_recieve_callback: all data is received");
+
+                BOOST_REQUIRE(client_received == ping_data + large_data);
+
+                client.disconnect();
+
+                //done test
+                std::unique_lock<std::mutex> lck(done_test_cond_guard);
+                client_disconnected = true;
+                done_test = server_disconnected;
+                done_test_cond.notify_one();
+            }
+        };
+
+        auto client_run = [&]() {
+            BOOST_REQUIRE(client.connect(host, port, &protocol, &client_th, nullptr, client_recieve_callback));
+
+            BOOST_REQUIRE_NO_THROW(client.send(protocol.create(ping_data)).commit());
+            BOOST_REQUIRE_NO_THROW(client.send(protocol.create(large_data)).commit());
+        };
+
+        server_th.start([&]() {
+            BOOST_REQUIRE(server.start(host, port, &protocol, &server_th, server_new_connection_callback));
+
+            client_th.start([&]() { client_run(); });
+        });
+
+        BOOST_REQUIRE(waiting_for(done_test, done_test_cond, done_test_cond_guard));
+
+        client_th.stop();
+        server_th.stop();
+    }
+
+    BOOST_AUTO_TEST_CASE(asio_pool_check)
+    {
+        print_current_test_name();
+
+        const size_t nb_clients = 4;
+
+        event_loop_pool server_pool(2);
+        event_loop client_th;
+
+        client_th.change_thread_name("!C");
+        server_pool.change_thread_name("!S");
+
+        raw_builder protocol;
+
+        network_server server(create_asio_server(server_pool));
+
+        std::vector<std::unique_ptr<network_client>> clients;
+        for (size_t ci = 0; ci < nb_clients; ++ci)
+            clients.emplace_back(new network_client(create_asio_client(&client_th)));
+
+        std::string host = get_default_address();
+        auto port = get_free_port();
+
+        const std::string ping_data = "ping";
+
+        std::mutex connections_guard;
+        std::set<std::shared_ptr<app_connection_i>> connections;
+        size_t nb_answers = 0;
+
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        auto server_recieve_callback = [&](app_connection_i& conn, app_unit& unit) {
+            BOOST_REQUIRE_NO_THROW(conn.send(protocol.create(unit.as_string())).commit());
+        };
+
+        auto server_new_connection_callback = [&](const std::shared_ptr<app_connection_i>& connection) {
+            LOG_TRACE("********* server_new_connection_callback");
+
+            BOOST_REQUIRE(connection);
+
+            connection->set_on_receive_handler(server_recieve_callback);
+
+            std::lock_guard<std::mutex> lck(connections_guard);
+            connections.emplace(connection);
+        };
+
+        auto client_recieve_callback = [&](app_unit& unit) {
+            BOOST_REQUIRE_EQUAL(unit.as_string(), ping_data);
+
+            if (++nb_answers == nb_clients)
+            {
+                //done test
+                std::unique_lock<std::mutex> lck(done_test_cond_guard);
+                done_test = true;
+                done_test_cond.notify_one();
+            }
+        };
+
+        server_pool.start();
+
+        BOOST_REQUIRE(server.start(host, port, &protocol, server_pool, server_new_connection_callback));
+
+        client_th.start([&]() {
+            for (auto&& client : clients)
+            {
+                BOOST_REQUIRE(client->connect(host, port, &protocol, &client_th, nullptr, client_recieve_callback));
+                BOOST_REQUIRE_NO_THROW(client->send(protocol.create(ping_data)).commit());
+            }
+        });
+
+        BOOST_REQUIRE(waiting_for(done_test, done_test_cond, done_test_cond_guard));
+
+        client_th.wait_async(true, [&]() {
+            for (auto&& client : clients)
+                client->disconnect();
+            return true;
+        });
+        client_th.stop();
+
+        server.stop();
+        server_pool.stop();
+
+        std::lock_guard<std::mutex> lck(connections_guard);
+        BOOST_REQUIRE_EQUAL(connections.size(), nb_clients);
+    }
+
+    BOOST_AUTO_TEST_CASE(asio_sharded_listen_check)
+    {
+        print_current_test_name();
+
+        // kernel spreads connections between listeners by hash,
+        // all of them go to the same listener with probability 2^-16
+        const size_t nb_clients = 16;
+
+        event_loop_pool server_pool(2);
+        event_loop client_th;
+
+        client_th.change_thread_name("!C");
+        server_pool.change_thread_name("!S");
+
+        raw_builder protocol;
+
+        asio_server_options options;
+        options.sharded_listen = true;
+
+        network_server server(create_asio_server(server_pool, options));
+
+        std::vector<std::unique_ptr<network_client>> clients;
+        for (size_t ci = 0; ci < nb_clients; ++ci)
+            clients.emplace_back(new network_client(create_asio_client(&client_th)));
+
+        std::string host = get_default_address();
+        auto port = get_free_port();
+
+        const std::string ping_data = "ping";
+
+        std::mutex connections_guard;
+        // loop index where connection was accepted
+        std::map<app_connection_i*, size_t> connection_loops;
+        std::set<std::shared_ptr<app_connection_i>> connections;
+        size_t nb_answers = 0;
+
+        bool first_answer = false;
+        std::mutex first_answer_cond_guard;
+        std::condition_variable first_answer_cond;
+
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        auto pool_loop_index = [&]() {
+            for (size_t ci = 0; ci < server_pool.size(); ++ci)
+            {
+                if (server_pool.loop(ci).is_this_loop())
+                    return ci;
+            }
+            return server_pool.size();
+        };
+
+        auto server_recieve_callback = [&](app_connection_i& conn, app_unit& unit) {
+            {
+                // callbacks run in loop that has accepted connection
+                std::lock_guard<std::mutex> lck(connections_guard);
+                BOOST_REQUIRE_EQUAL(connection_loops[&conn], pool_loop_index());
+            }
+
+            BOOST_REQUIRE_NO_THROW(conn.send(protocol.create(unit.as_string())).commit());
+        };
+
+        auto server_new_connection_callback = [&](const std::shared_ptr<app_connection_i>& connection) {
+            LOG_TRACE("********* server_new_connection_callback");
+
+            auto index = pool_loop_index();
+            BOOST_REQUIRE_LT(index, server_pool.size());
+            BOOST_REQUIRE(connection);
+
+            connection->set_on_receive_handler(server_recieve_callback);
+
+            std::lock_guard<std::mutex> lck(connections_guard);
+            connection_loops[connection.get()] = index;
+            connections.emplace(connection);
+        };
+
+        auto client_recieve_callback = [&](app_unit& unit) {
+            BOOST_REQUIRE_EQUAL(unit.as_string(), ping_data);
+
+            if (++nb_answers == 1)
+            {
+                std::unique_lock<std::mutex> lck(first_answer_cond_guard);
+                first_answer = true;
+                first_answer_cond.notify_one();
+            }
+
+            if (nb_answers == nb_clients)
+            {
+                //done test
+                std::unique_lock<std::mutex> lck(done_test_cond_guard);
+                done_test = true;
+                done_test_cond.notify_one();
+            }
+        };
+
+        server_pool.start();
+
+        BOOST_REQUIRE(server.start(host, port, &protocol, server_pool, server_new_connection_callback));
+
+        // The first loop is blocked. Connections are served
+        // only if other loop accepts them by own listener
+        std::promise<void> unblock;
+        auto blocked = unblock.get_future().share();
+        server_pool.loop(0).post([blocked]() {
+            blocked.wait();
+        });
+
+        client_th.start([&]() {
+            for (auto&& client : clients)
+            {
+                BOOST_REQUIRE(client->connect(host, port, &protocol, &client_th, nullptr, client_recieve_callback));
+                BOOST_REQUIRE_NO_THROW(client->send(protocol.create(ping_data)).commit());
+            }
+        });
+
+        auto answered = waiting_for(first_answer, first_answer_cond, first_answer_cond_guard);
+        unblock.set_value();
+        BOOST_REQUIRE(answered);
+
+        BOOST_REQUIRE(waiting_for(done_test, done_test_cond, done_test_cond_guard));
+
+        client_th.wait_async(true, [&]() {
+            for (auto&& client : clients)
+                client->disconnect();
+            return true;
+        });
+        client_th.stop();
+
+        server.stop();
+        server_pool.stop();
+
+        std::lock_guard<std::mutex> lck(connections_guard);
+        BOOST_REQUIRE_EQUAL(connections.size(), nb_clients);
+
+        // every loop has listener
+        std::set<size_t> accept_loops;
+        for (auto&& item : connection_loops)
+            accept_loops.emplace(item.second);
+        BOOST_REQUIRE_EQUAL(accept_loops.size(), server_pool.size());
+    }
+
+    BOOST_AUTO_TEST_CASE(asio_own_loops_check)
+    {
+        print_current_test_name();
+
+        event_loop client_th;
+
+        client_th.change_thread_name("!C");
+
+        raw_builder protocol;
+
+        // sockets are served by transport loops
+        network_server server(create_asio_server());
+        network_client client(create_asio_client());
+
+        server.set_nb_workers(2);
+
+        std::string host = get_default_address();
+        auto port = get_free_port();
+
+        const std::string ping_data = "ping";
+
+        std::shared_ptr<app_connection_i> hold_connection;
+
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        auto server_recieve_callback = [&](app_connection_i& conn, app_unit& unit) {
+            BOOST_REQUIRE_NO_THROW(conn.send(protocol.create(unit.as_string())).commit());
+        };
+
+        auto server_new_connection_callback = [&](const std::shared_ptr<app_connection_i>& connection) {
+            BOOST_REQUIRE(connection);
+
+            connection->set_on_receive_handler(server_recieve_callback);
+
+            std::lock_guard<std::mutex> lck(done_test_cond_guard);
+            hold_connection = connection;
+        };
+
+        auto client_recieve_callback = [&](app_unit& unit) {
+            BOOST_REQUIRE_EQUAL(unit.as_string(), ping_data);
+
+            //done test
+            std::unique_lock<std::mutex> lck(done_test_cond_guard);
+            done_test = true;
+            done_test_cond.notify_one();
+        };
+
+        BOOST_REQUIRE(server.start(host, port, &protocol, nullptr, server_new_connection_callback));
+
+        client_th.start([&]() {
+            BOOST_REQUIRE(client.connect(host, port, &protocol, &client_th, nullptr, client_recieve_callback));
+            BOOST_REQUIRE_NO_THROW(client.send(protocol.create(ping_data)).commit());
+        });
+
+        BOOST_REQUIRE(waiting_for(done_test, done_test_cond, done_test_cond_guard));
+
+        client_th.wait_async(true, [&]() {
+            client.disconnect();
+            return true;
+        });
+        client_th.stop();
+
+        server.stop();
+
+        std::lock_guard<std::mutex> lck(done_test_cond_guard);
+        BOOST_REQUIRE(hold_connection);
+        BOOST_REQUIRE(!hold_connection->is_connected());
+    }
+
+    BOOST_AUTO_TEST_CASE(asio_gather_write_check)
+    {
+        print_current_test_name();
+
+        event_loop server_th;
+        event_loop client_th;
+
+        server_th.change_thread_name("!S");
+        client_th.change_thread_name("!C");
+
+        const size_t max_msg_size = 4 * 1024 * 1024;
+
+        msg_builder protocol { max_msg_size };
+
+        network_server server(create_asio_server());
+        network_client client(create_asio_client(&client_th));
+
+        std::string host = get_default_address();
+        auto port = get_free_port();
+
+        // small pieces are joined, large ones are sent by gather write
+        std::vector<std::string> messages;
+        for (auto sz : { 10, 3000, 5, 2 * 1024 * 1024, 100, 1500 })
+            messages.emplace_back(static_cast<size_t>(sz), static_cast<char>('a' + messages.size()));
+
+        std::shared_ptr<app_connection_i> hold_connection;
+        std::vector<std::string> server_received;
+
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        auto server_recieve_callback = [&](app_connection_i&, app_unit& unit) {
+            server_received.emplace_back(unit.as_string());
+
+            if (server_received.size() == messages.size())
+            {
+                //done test
+                std::unique_lock<std::mutex> lck(done_test_cond_guard);
+                done_test = true;
+                done_test_cond.notify_one();
+            }
+        };
+
+        auto server_new_connection_callback = [&](const std::shared_ptr<app_connection_i>& connection) {
+            connection->set_on_receive_handler(server_recieve_callback);
+
+            hold_connection = connection;
+        };
+
+        server_th.start([&]() {
+            BOOST_REQUIRE(server.start(host, port, &protocol, &server_th, server_new_connection_callback));
+
+            client_th.start([&]() {
+                BOOST_REQUIRE(client.connect(host, port, &protocol, &client_th));
+
+                for (auto&& msg : messages)
+                    client.send(protocol.create(msg));
+                BOOST_REQUIRE_NO_THROW(client.commit());
+            });
+        });
+
+        BOOST_REQUIRE(waiting_for(done_test, done_test_cond, done_test_cond_guard));
+
+        client_th.wait_async(true, [&]() {
+            client.disconnect();
+            return true;
+        });
+        client_th.stop();
+
+        server_th.wait_async(true, [&]() {
+            server.stop();
+            return true;
+        });
+        server_th.stop();
+
+        BOOST_REQUIRE(server_received == messages);
+    }
+
+    BOOST_AUTO_TEST_CASE(asio_adaptive_read_check)
+    {
+        print_current_test_name();
+
+        event_loop server_th;
+        event_loop client_th;
+
+        server_th.change_thread_name("!S");
+        client_th.change_thread_name("!C");
+
+        raw_builder protocol;
+
+        network_server server(create_asio_server());
+        network_client client(create_asio_client(&client_th));
+
+        read_options options;
+        options.size = 4096;
+        options.adaptive = true;
+        options.min_size = 1024;
+        options.max_size = 256 * 1024;
+        client.set_read_options(options);
+
+        std::string host = get_default_address();
+        auto port = get_free_port();
+
+        const std::string large_data(4 * 1024 * 1024, 'x');
+
+        std::shared_ptr<app_connection_i> hold_connection;
+        size_t client_received = 0;
+        size_t nb_reads = 0;
+        size_t max_read = 0;
+
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        auto server_new_connection_callback = [&](const std::shared_ptr<app_connection_i>& connection) {
+            hold_connection = connection;
+
+            BOOST_REQUIRE_NO_THROW(connection->send(protocol.create(large_data)).commit());
+        };
+
+        // raw builder makes unit for every read
+        auto client_recieve_callback = [&](app_unit& unit) {
+            auto sz = unit.as_view().size();
+            client_received += sz;
+            max_read = std::max(max_read, sz);
+            ++nb_reads;
+
+            if (client_received == large_data.size())
+            {
+                //done test
+                std::unique_lock<std::mutex> lck(done_test_cond_guard);
+                done_test = true;
+                done_test_cond.notify_one();
+            }
+        };
+
+        server_th.start([&]() {
+            BOOST_REQUIRE(server.start(host, port, &protocol, &server_th, server_new_connection_callback));
+
+            client_th.start([&]() {
+                BOOST_REQUIRE(client.connect(host, port, &protocol, &client_th, nullptr, client_recieve_callback));
+            });
+        });
+
+        BOOST_REQUIRE(waiting_for(done_test, done_test_cond, done_test_cond_guard));
+
+        client_th.wait_async(true, [&]() {
+            client.disconnect();
+            return true;
+        });
+        client_th.stop();
+
+        server_th.wait_async(true, [&]() {
+            server.stop();
+            return true;
+        });
+        server_th.stop();
+
+        BOOST_REQUIRE_GT(max_read, options.size);
+        BOOST_REQUIRE_LE(max_read, options.max_size);
+        BOOST_REQUIRE_LT(nb_reads, large_data.size() / options.size);
+    }
+
+    BOOST_AUTO_TEST_CASE(asio_auto_flush_check)
+    {
+        print_current_test_name();
+
+        event_loop server_th;
+        event_loop client_th;
+
+        server_th.change_thread_name("!S");
+        client_th.change_thread_name("!C");
+
+        msg_builder protocol { 1024 };
+
+        auto client_writes = std::make_shared<write_counters>();
+
+        network_server server(create_asio_server());
+        network_client client(std::make_shared<counting_client>(create_asio_client(&client_th), client_writes));
+
+        std::string host = get_default_address();
+        auto port = get_free_port();
+
+        // the first batch is written at the end of tick, the second one
+        // is sent while write is in progress and it is joined to the next write
+        const size_t nb_batches = 2;
+        const size_t batch_size = 1000;
+        std::vector<std::string> messages;
+        for (size_t ci = 0; ci < nb_batches * batch_size; ++ci)
+            messages.emplace_back(std::to_string(ci) + std::string(ci % 50, 'x'));
+
+        std::shared_ptr<app_connection_i> hold_connection;
+        std::vector<std::string> server_received;
+        std::vector<std::string> client_received;
+
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        // echo without commit
+        auto server_recieve_callback = [&](app_connection_i& connection, app_unit& unit) {
+            server_received.emplace_back(unit.as_string());
+            connection.send(protocol.create(unit.as_string()));
+        };
+
+        auto server_new_connection_callback = [&](const std::shared_ptr<app_connection_i>& connection) {
+            connection->set_on_receive_handler(server_recieve_callback);
+            connection->set_auto_flush(true);
+
+            hold_connection = connection;
+        };
+
+        auto client_recieve_callback = [&](app_unit& unit) {
+            client_received.emplace_back(unit.as_string());
+
+            if (client_received.size() == messages.size())
+            {
+                //done test
+                std::unique_lock<std::mutex> lck(done_test_cond_guard);
+                done_test = true;
+                done_test_cond.notify_one();
+            }
+        };
+
+        auto send_batch = [&](size_t batch) {
+            for (size_t ci = batch * batch_size; ci < (batch + 1) * batch_size; ++ci)
+                client.send(protocol.create(messages[ci]));
+        };
+
+        server_th.start([&]() {
+            BOOST_REQUIRE(server.start(host, port, &protocol, &server_th, server_new_connection_callback));
+
+            client_th.start([&]() {
+                BOOST_REQUIRE(client.connect(host, port, &protocol, &client_th, nullptr, client_recieve_callback));
+
+                client.set_auto_flush(true);
+
+                send_batch(0);
+                client_th.post([&]() {
+                    send_batch(1);
+                });
+            });
+        });
+
+        BOOST_REQUIRE(waiting_for(done_test, done_test_cond, done_test_cond_guard));
+
+        client_th.wait_async(true, [&]() {
+            client.disconnect();
+            return true;
+        });
+        client_th.stop();
+
+        server_th.wait_async(true, [&]() {
+            server.stop();
+            return true;
+        });
+        server_th.stop();
+
+        BOOST_REQUIRE(server_received == messages);
+        BOOST_REQUIRE(client_received == messages);
+
+        // units are joined, the next write waits for previous one
+        BOOST_REQUIRE_GT(client_writes->writes.load(), 0u);
+        BOOST_REQUIRE_LT(client_writes->writes.load(), nb_batches * batch_size / 100);
+        BOOST_REQUIRE_EQUAL(client_writes->max_in_flight.load(), 1u);
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace server_lib
@@ -0,0 +1,119 @@
+#include "tests_common.h"
+
+// registry is private header of network implementation
+#include "../src/network/connection_registry.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace server_lib {
+namespace tests {
+
+    using namespace server_lib::network;
+
+    BOOST_AUTO_TEST_SUITE(network_tests)
+
+    BOOST_AUTO_TEST_CASE(connection_registry_stale_id_check)
+    {
+        print_current_test_name();
+
+        using registry_type = connection_registry<std::shared_ptr<int>>;
+
+        // single shard to reuse the same slot
+        registry_type registry(1);
+
+        auto value = std::make_shared<int>(1);
+        auto id = registry.insert(value);
+
+        BOOST_REQUIRE_NE(id, registry_type::invalid_id);
+        BOOST_REQUIRE_EQUAL(registry.size(), 1u);
+        BOOST_REQUIRE_EQUAL(value.use_count(), 2);
+
+        std::shared_ptr<int> removed;
+        BOOST_REQUIRE(registry.erase(id, removed));
+        BOOST_REQUIRE(removed == value);
+        BOOST_REQUIRE_EQUAL(registry.size(), 0u);
+
+        // registry doesn't hold removed value
+        removed.reset();
+        BOOST_REQUIRE_EQUAL(value.use_count(), 1);
+
+        // removed id is rejected
+        BOOST_REQUIRE(!registry.erase(id, removed));
+        BOOST_REQUIRE(!removed);
+
+        // new value reuses slot with the next generation
+        auto other = std::make_shared<int>(2);
+        auto other_id = registry.insert(other);
+
+        BOOST_REQUIRE_NE(other_id, id);
+        BOOST_REQUIRE_EQUAL(other_id & 0xffffffffu, id & 0xffffffffu);
+
+        BOOST_REQUIRE(!registry.erase(id, removed));
+        BOOST_REQUIRE(!removed);
+        BOOST_REQUIRE_EQUAL(registry.size(), 1u);
+
+        BOOST_REQUIRE(registry.erase(other_id, removed));
+        BOOST_REQUIRE(removed == other);
+
+        // ids that were never issued
+        BOOST_REQUIRE(!registry.erase(registry_type::invalid_id, removed));
+        BOOST_REQUIRE(!registry.erase(other_id + 1, removed));
+        BOOST_REQUIRE(!registry.erase(other_id + (1 << 8), removed));
+    }
+
+    BOOST_AUTO_TEST_CASE(connection_registry_extract_all_check)
+    {
+        print_current_test_name();
+
+        using registry_type = connection_registry<int>;
+
+        registry_type registry(4);
+
+        const int nb_values = 10;
+
+        std::vector<registry_type::id_type> ids;
+        for (int ci = 1; ci <= nb_values; ++ci)
+            ids.emplace_back(registry.insert(ci));
+
+        // ids are unique across shards
+        auto unique_ids = ids;
+        std::sort(unique_ids.begin(), unique_ids.end());
+        BOOST_REQUIRE(std::unique(unique_ids.begin(), unique_ids.end()) == unique_ids.end());
+
+        int removed = 0;
+        BOOST_REQUIRE(registry.erase(ids[2], removed));
+        BOOST_REQUIRE_EQUAL(removed, 3);
+        BOOST_REQUIRE_EQUAL(registry.size(), static_cast<size_t>(nb_values - 1));
+
+        std::vector<int> values;
+        registry.extract_all(values);
+
+        std::sort(values.begin(), values.end());
+        BOOST_REQUIRE(values == std::vector<int>({ 1, 2, 4, 5, 6, 7, 8, 9, 10 }));
+        BOOST_REQUIRE_EQUAL(registry.size(), 0u);
+
+        // extracted ids are not valid any more
+        for (auto&& id : ids)
+            BOOST_REQUIRE(!registry.erase(id, removed));
+
+        // released slot is reused with new id
+        auto id = registry.insert(nb_values + 1);
+        BOOST_REQUIRE(std::find(ids.begin(), ids.end(), id) == ids.end());
+        BOOST_REQUIRE(std::find_if(ids.begin(), ids.end(), [id](registry_type::id_type used_id) {
+                          return (used_id & 0xffffffffu) == (id & 0xffffffffu);
+                      })
+                      != ids.end());
+        BOOST_REQUIRE(registry.erase(id, removed));
+        BOOST_REQUIRE_EQUAL(removed, nb_values + 1);
+
+        values.clear();
+        registry.extract_all(values);
+        BOOST_REQUIRE(values.empty());
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace server_lib
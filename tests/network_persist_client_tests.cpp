@@ -10,6 +10,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
+#include <future>
 
 #include <boost/lexical_cast.hpp>
 
@@ -487,6 +488,100 @@ namespace tests {
         BOOST_REQUIRE(waiting_for(done_test, done_test_cond, done_test_cond_guard));
     }
 
+    BOOST_AUTO_TEST_CASE(persist_connection_async_request_check)
+    {
+        print_current_test_name();
+
+#if BOOST_VERSION >= 107000
+        event_loop server_th;
+        event_loop client_th;
+
+        server_th.change_thread_name("!S");
+        client_th.change_thread_name("!C");
+
+        raw_builder protocol;
+
+        network_server server;
+        persist_network_client client;
+
+        std::string host = get_default_address();
+        auto port = get_free_port();
+
+        std::shared_ptr<app_connection_i> hold_connection;
+
+        auto server_recieve_callback = [&hold_connection](app_connection_i& conn, app_unit& unit) {
+            LOG_TRACE("********* server_recieve_callback: " << unit.as_string());
+
+            BOOST_REQUIRE_EQUAL(reinterpret_cast<uint64_t>(&conn), reinterpret_cast<uint64_t>(hold_connection.get()));
+
+            BOOST_REQUIRE_NO_THROW(hold_connection->send(unit).commit());
+        };
+
+        auto server_new_connection_callback = [&hold_connection, &server_recieve_callback](const std::shared_ptr<app_connection_i>& connection) {
+            LOG_TRACE("********* server_new_connection_callback");
+
+            BOOST_REQUIRE(connection);
+
+            connection->set_on_receive_handler(server_recieve_callback);
+
+            hold_connection = connection;
+        };
+
+        auto client_connection_callback = [](const persist_network_client::connect_state state) {
+            LOG_TRACE("********* client_connection_callback: " << state);
+        };
+
+        server_th.start();
+        client_th.start();
+
+        BOOST_REQUIRE(server_th.wait_async(false, [&]() {
+            return server.start(host, port, &protocol, &server_th, server_new_connection_callback);
+        }));
+        BOOST_REQUIRE(client_th.wait_async(false, [&]() {
+            return client.connect(host, port, &protocol, &client_th, client_connection_callback);
+        }));
+
+        // reply is received in client thread, test thread waits for it
+        auto reply = client.async_request(protocol.create("1"), boost::asio::use_future);
+        BOOST_REQUIRE(reply.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+
+        auto unit = reply.get();
+        BOOST_REQUIRE(unit.ok());
+        BOOST_REQUIRE_EQUAL(unit.as_string(), "1");
+
+#if defined(SERVER_LIB_COROUTINES)
+        // requests one by one without callbacks
+        std::promise<std::string> replies;
+        auto replies_result = replies.get_future();
+        client_th.spawn([&client, &protocol, &replies](boost::asio::yield_context yield) {
+            std::string result;
+            for (int ci = 2; ci <= 3; ++ci)
+            {
+                auto unit = client.async_request(protocol.create(std::to_string(ci)), yield);
+                result += unit.as_string();
+            }
+            replies.set_value(result);
+        });
+
+        BOOST_REQUIRE(replies_result.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+        BOOST_REQUIRE_EQUAL(replies_result.get(), "23");
+#endif
+
+        client_th.wait_async(true, [&client]() {
+            client.disconnect();
+            return true;
+        });
+
+        server_th.wait_async(true, [&server]() {
+            server.stop();
+            return true;
+        });
+
+        client_th.stop();
+        server_th.stop();
+#endif
+    }
+
     BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace tests
@@ -0,0 +1,227 @@
+#if defined(SERVER_LIB_IO_URING)
+
+#include "network_common.h"
+
+#include <server_lib/event_loop.h>
+#include <server_lib/logging_helper.h>
+
+#include <server_lib/network/network_server.h>
+#include <server_lib/network/network_client.h>
+#include <server_lib/network/raw_builder.h>
+#include <server_lib/network/msg_builder.h>
+#include <server_lib/network/uring_transport.h>
+
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
+
+namespace server_lib {
+namespace tests {
+
+    using namespace server_lib::network;
+
+    BOOST_FIXTURE_TEST_SUITE(network_uring_tests, basic_network_fixture)
+
+    BOOST_AUTO_TEST_CASE(uring_echo_check)
+    {
+        print_current_test_name();
+
+        if (!is_uring_supported())
+        {
+            LOG_WARN("io_uring is not supported by kernel. Test is skipped");
+            return;
+        }
+
+        event_loop server_th;
+        event_loop client_th;
+
+        server_th.change_thread_name("!S");
+        client_th.change_thread_name("!C");
+
+        raw_builder protocol;
+
+        network_server server(create_uring_server());
+        network_client client(create_uring_client());
+
+        server.set_nb_workers(2);
+
+        std::string host = get_default_address();
+        auto port = get_free_port();
+
+        // bigger than socket buffer to check partial writes
+        const std::string large_data(4 * 1024 * 1024, 'x');
+        const std::string ping_data = "ping";
+
+        std::shared_ptr<app_connection_i> hold_connection;
+        std::string client_received;
+        bool server_disconnected = false;
+        bool client_disconnected = false;
+
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        auto server_recieve_callback = [&protocol](app_connection_i& conn, app_unit& unit) {
+            // echo
+            BOOST_REQUIRE_NO_THROW(conn.send(protocol.create(unit.as_string())).commit());
+        };
+
+        auto server_disconnect_callback = [&](app_connection_i& conn) {
+            LOG_TRACE("********* server_disconnect_callback");
+
+            BOOST_REQUIRE_EQUAL(reinterpret_cast<uint64_t>(&conn), reinterpret_cast<uint64_t>(hold_connection.get()));
+
+            hold_connection.reset();
+
+            server_th.post([&] {
+                server.stop();
+
+                //done test
+                std::unique_lock<std::mutex> lck(done_test_cond_guard);
+                server_disconnected = true;
+                done_test = client_disconnected;
+                done_test_cond.notify_one();
+            });
+        };
+
+        auto server_new_connection_callback = [&hold_connection, &server_recieve_callback, &server_disconnect_callback](const std::shared_ptr<app_connection_i>& connection) {
+            LOG_TRACE("********* server_new_connection_callback");
+
+            BOOST_REQUIRE(connection);
+
+            connection->set_on_receive_handler(server_recieve_callback);
+            connection->set_on_disconnect_handler(server_disconnect_callback);
+
+            hold_connection = connection;
+        };
+
+        auto client_recieve_callback = [&](app_unit& unit) {
+            client_received += unit.as_string();
+
+            if (client_received.size() == ping_data.size() + large_data.size())
+            {
+                LOG_TRACE("********* client_recieve_callback: all data is received");
+
+                BOOST_REQUIRE(client_received == ping_data + large_data);
+
+                client.disconnect();
+
+                //done test
+                std::unique_lock<std::mutex> lck(done_test_cond_guard);
+                client_disconnected = true;
+                done_test = server_disconnected;
+                done_test_cond.notify_one();
+            }
+        };
+
+        auto client_run = [&]() {
+            BOOST_REQUIRE(client.connect(host, port, &protocol, &client_th, nullptr, client_recieve_callback));
+
+            BOOST_REQUIRE_NO_THROW(client.send(protocol.create(ping_data)).commit());
+            BOOST_REQUIRE_NO_THROW(client.send(protocol.create(large_data)).commit());
+        };
+
+        server_th.start([&]() {
+            BOOST_REQUIRE(server.start(host, port, &protocol, &server_th, server_new_connection_callback));
+
+            client_th.start([&]() { client_run(); });
+        });
+
+        BOOST_REQUIRE(waiting_for(done_test, done_test_cond, done_test_cond_guard));
+
+        client_th.stop();
+        server_th.stop();
+    }
+
+    BOOST_AUTO_TEST_CASE(uring_gather_write_check)
+    {
+        print_current_test_name();
+
+        if (!is_uring_supported())
+        {
+            LOG_WARN("io_uring is not supported by kernel. Test is skipped");
+            return;
+        }
+
+        event_loop server_th;
+        event_loop client_th;
+
+        server_th.change_thread_name("!S");
+        client_th.change_thread_name("!C");
+
+        const size_t max_msg_size = 4 * 1024 * 1024;
+
+        msg_builder protocol { max_msg_size };
+
+        network_server server(create_uring_server());
+        network_client client(create_uring_client());
+
+        std::string host = get_default_address();
+        auto port = get_free_port();
+
+        // small pieces are joined, large ones are sent by gather write
+        std::vector<std::string> messages;
+        for (auto sz : { 10, 3000, 5, 2 * 1024 * 1024, 100, 1500 })
+            messages.emplace_back(static_cast<size_t>(sz), static_cast<char>('a' + messages.size()));
+
+        std::shared_ptr<app_connection_i> hold_connection;
+        std::vector<std::string> server_received;
+
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        auto server_recieve_callback = [&](app_connection_i&, app_unit& unit) {
+            server_received.emplace_back(unit.as_string());
+
+            if (server_received.size() == messages.size())
+            {
+                //done test
+                std::unique_lock<std::mutex> lck(done_test_cond_guard);
+                done_test = true;
+                done_test_cond.notify_one();
+            }
+        };
+
+        auto server_new_connection_callback = [&](const std::shared_ptr<app_connection_i>& connection) {
+            connection->set_on_receive_handler(server_recieve_callback);
+
+            hold_connection = connection;
+        };
+
+        server_th.start([&]() {
+            BOOST_REQUIRE(server.start(host, port, &protocol, &server_th, server_new_connection_callback));
+
+            client_th.start([&]() {
+                BOOST_REQUIRE(client.connect(host, port, &protocol, &client_th));
+
+                for (auto&& msg : messages)
+                    client.send(protocol.create(msg));
+                BOOST_REQUIRE_NO_THROW(client.commit());
+            });
+        });
+
+        BOOST_REQUIRE(waiting_for(done_test, done_test_cond, done_test_cond_guard));
+
+        client_th.wait_async(true, [&]() {
+            client.disconnect();
+            return true;
+        });
+        client_th.stop();
+
+        server_th.wait_async(true, [&]() {
+            server.stop();
+            return true;
+        });
+        server_th.stop();
+
+        BOOST_REQUIRE(server_received == messages);
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace server_lib
+
+#endif // SERVER_LIB_IO_URING